@@ -0,0 +1,172 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include "BRDFs.h"
+#include "DataTypes.h"
+#include "Sampler.h"
+
+namespace dae
+{
+	/**
+	 * \brief Soft shadows from rect, disk and sphere lights with an adaptive number of shadow rays.
+	 * Every light is first probed with NUM_PROBES jittered, stratified samples, one per cell of a grid over its surface.
+	 * The grid is jittered as a whole by one 2D sample, so the probes of consecutive samples stay as well spread as the sampler's points.
+	 * When the probes agree the point is fully lit or fully shadowed and the probes are the estimate, so those regions stay cheap.
+	 * Only in the penumbra, where they disagree, NUM_PENUMBRA_SAMPLES more samples come from a randomly rotated Hammersley set.
+	 * Area lights are normalized like point lights: seen head-on from afar, an area light is as bright as a point light of the same intensity.
+	 */
+	namespace AreaLights
+	{
+		constexpr uint32_t NUM_PROBES_PER_AXIS{ 2 };
+		constexpr uint32_t NUM_PROBES{ NUM_PROBES_PER_AXIS * NUM_PROBES_PER_AXIS };
+		constexpr uint32_t NUM_PENUMBRA_SAMPLES{ 16 };
+
+		//A point on an area light, as seen from the shading point
+		struct LightSample
+		{
+			Vector3 toLightDirection{};
+			float distance{};
+			//Emitted towards the shading point, already divided by the squared distance
+			ColorRGB radiance{};
+		};
+
+		inline bool IsAreaLight(const Light& light)
+		{
+			return light.type == LightType::Rect || light.type == LightType::Disk || light.type == LightType::Sphere;
+		}
+
+		//Shirley and Chiu's concentric mapping, keeps the strata of the unit square intact on the unit disk
+		inline void SampleConcentricDisk(float u1, float u2, float& x, float& y)
+		{
+			const float a{ 2 * u1 - 1 };
+			const float b{ 2 * u2 - 1 };
+			if (a == 0 && b == 0)
+			{
+				x = 0;
+				y = 0;
+				return;
+			}
+
+			const bool isHorizontal{ fabsf(a) > fabsf(b) };
+			const float radius{ isHorizontal ? a : b };
+			const float phi{ isHorizontal ? PI_DIV_4 * (b / a) : PI_DIV_2 - PI_DIV_4 * (a / b) };
+			x = radius * cosf(phi);
+			y = radius * sinf(phi);
+		}
+
+		//Maps (u1, u2) in [0, 1) to a point on the light. Spheres are sampled as the disk they show to the shading point.
+		//Returns false when the point lies behind a rect or disk, which only emit to one side
+		inline bool SampleLight(const Light& light, const Vector3& point, float u1, float u2, LightSample& sample)
+		{
+			Vector3 lightPoint{ light.origin };
+			if (light.type == LightType::Rect)
+			{
+				lightPoint += light.edgeU * (2 * u1 - 1) + light.edgeV * (2 * u2 - 1);
+			}
+			else
+			{
+				const Vector3 diskNormal{ light.type == LightType::Disk ? light.direction : (point - light.origin).Normalized() };
+
+				float diskX{};
+				float diskY{};
+				SampleConcentricDisk(u1, u2, diskX, diskY);
+				lightPoint += BRDF::LocalToWorld(diskNormal, { diskX * light.radius, diskY * light.radius, 0.f });
+			}
+
+			const Vector3 toLight{ lightPoint - point };
+			const float sqrDistance{ toLight.SqrMagnitude() };
+			sample.distance = sqrtf(sqrDistance);
+			sample.toLightDirection = toLight / sample.distance;
+
+			float cosLight{ 1.f };
+			if (light.type != LightType::Sphere)
+			{
+				cosLight = -Vector3::Dot(light.direction, sample.toLightDirection);
+				if (cosLight <= 0)
+					return false;
+			}
+
+			sample.radiance = light.color * (light.intensity * cosLight / sqrDistance);
+			return true;
+		}
+
+		//Van der Corput radical inverse in base 2, the second dimension of the Hammersley set
+		inline float RadicalInverse(uint32_t index)
+		{
+			return Sampler::ToFloat(Sampler::ReverseBits(index));
+		}
+
+		//Cranley-Patterson rotation, wraps around to stay in [0, 1)
+		inline float RotateSample(float value, float offset)
+		{
+			const float rotated{ value + offset };
+			return std::min(rotated - floorf(rotated), 0x1.fffffep-1f);
+		}
+
+		/**
+		 * \brief Direct light from one area light at point.
+		 * \param shade Unshadowed contribution of a LightSample, black when it doesn't reach the surface
+		 * \param isOccluded Traces the shadow ray of a LightSample, only called for samples that contribute
+		 */
+		template<bool shadowsEnabled, typename ShadeFunction, typename OcclusionFunction>
+		ColorRGB Estimate(const Light& light, const Vector3& point, Sampler& sampler, const ShadeFunction& shade, const OcclusionFunction& isOccluded)
+		{
+			float jitterU{};
+			float jitterV{};
+			sampler.Next2D(jitterU, jitterV);
+			float offsetU{};
+			float offsetV{};
+			sampler.Next2D(offsetU, offsetV);
+
+			ColorRGB estimate{};
+			uint32_t numLit{ 0 };
+			uint32_t numShadowed{ 0 };
+
+			const auto takeSample = [&](float u1, float u2) {
+				LightSample sample{};
+				if (!SampleLight(light, point, u1, u2, sample))
+					return;
+
+				//Samples that add nothing need no shadow ray, they don't tell lit and shadowed apart either
+				const ColorRGB contribution{ shade(sample) };
+				if (contribution.r <= 0 && contribution.g <= 0 && contribution.b <= 0)
+					return;
+
+				if constexpr (shadowsEnabled)
+				{
+					if (isOccluded(sample))
+					{
+						++numShadowed;
+						return;
+					}
+					++numLit;
+				}
+
+				estimate += contribution;
+			};
+
+			for (uint32_t probeY{ 0 }; probeY < NUM_PROBES_PER_AXIS; ++probeY)
+			{
+				for (uint32_t probeX{ 0 }; probeX < NUM_PROBES_PER_AXIS; ++probeX)
+				{
+					const float u1{ (probeX + jitterU) / NUM_PROBES_PER_AXIS };
+					const float u2{ (probeY + jitterV) / NUM_PROBES_PER_AXIS };
+					takeSample(u1, u2);
+				}
+			}
+
+			//Fully lit or fully shadowed (or no shadows at all)
+			if (numLit == 0 || numShadowed == 0)
+				return estimate / float(NUM_PROBES);
+
+			for (uint32_t sampleIdx{ 0 }; sampleIdx < NUM_PENUMBRA_SAMPLES; ++sampleIdx)
+			{
+				takeSample(RotateSample((sampleIdx + 0.5f) / NUM_PENUMBRA_SAMPLES, offsetU), RotateSample(RadicalInverse(sampleIdx), offsetV));
+			}
+
+			return estimate / float(NUM_PROBES + NUM_PENUMBRA_SAMPLES);
+		}
+	}
+}
@@ -98,5 +98,72 @@ namespace dae
 			return GeometryFunction_SchlickGGX(n,v,roughness)*GeometryFunction_SchlickGGX(n,l,roughness);
 		}
 
+		/**
+		 * \brief Turns a direction given around +Z into the same direction around n (branchless orthonormal basis, Duff et al. 2017)
+		 * \param n Normalized direction the local +Z axis maps to
+		 * \param local Direction in the local frame
+		 * \return local in world space
+		 */
+		static Vector3 LocalToWorld(const Vector3& n, const Vector3& local)
+		{
+			const float sign{ copysignf(1.f, n.z) };
+			const float a{ -1.f / (sign + n.z) };
+			const float b{ n.x * n.y * a };
+			const Vector3 tangent{ 1.f + sign * n.x * n.x * a, sign * b, -sign * n.x };
+			const Vector3 bitangent{ b, sign + n.y * n.y * a, -n.y };
+
+			return tangent * local.x + bitangent * local.y + n * local.z;
+		}
+
+		/**
+		 * \brief Importance sampling of the Lambert lobe: cosine weighted direction on the hemisphere around n
+		 * \param n Normal of the surface
+		 * \param u1 Uniform random number in [0, 1)
+		 * \param u2 Uniform random number in [0, 1)
+		 * \return Normalized light direction, with probability density Pdf_Lambert
+		 */
+		static Vector3 Sample_Lambert(const Vector3& n, float u1, float u2)
+		{
+			const float radius{ sqrtf(u1) };
+			const float phi{ PI_2 * u2 };
+
+			return LocalToWorld(n, { radius * cosf(phi), radius * sinf(phi), sqrtf(std::max(1.f - u1, 0.f)) });
+		}
+
+		static float Pdf_Lambert(const Vector3& n, const Vector3& l)
+		{
+			return std::max(Vector3::Dot(n, l), 0.f) / PI;
+		}
+
+		/**
+		 * \brief Importance sampling of NormalDistribution_GGX: picks a half vector proportional to D(h) * dot(n, h)
+		 * and reflects the view direction around it
+		 * \param n Normal of the surface
+		 * \param v Normalized view direction
+		 * \param roughness Roughness of the material (squared like NormalDistribution_GGX)
+		 * \param u1 Uniform random number in [0, 1)
+		 * \param u2 Uniform random number in [0, 1)
+		 * \return Normalized light direction, with probability density Pdf_GGX. Can end up below the surface
+		 */
+		static Vector3 Sample_GGX(const Vector3& n, const Vector3& v, float roughness, float u1, float u2)
+		{
+			const float alphaSqrd{ powf(roughness,4) };
+			const float cosTheta{ sqrtf((1 - u1) / (1 + (alphaSqrd - 1) * u1)) };
+			const float sinTheta{ sqrtf(std::max(1 - cosTheta * cosTheta, 0.f)) };
+			const float phi{ PI_2 * u2 };
+
+			const Vector3 halfVector{ LocalToWorld(n, { sinTheta * cosf(phi), sinTheta * sinf(phi), cosTheta }) };
+			return 2 * Vector3::Dot(v, halfVector) * halfVector - v;
+		}
+
+		static float Pdf_GGX(const Vector3& n, const Vector3& v, const Vector3& l, float roughness)
+		{
+			const Vector3 halfVector{ (v + l).Normalized() };
+			const float vDotH{ Vector3::Dot(v, halfVector) };
+			if (vDotH <= 0)
+				return 0.f;
+
+			return NormalDistribution_GGX(n, halfVector, roughness) * std::max(Vector3::Dot(n, halfVector), 0.f) / (4 * vDotH);
+		}
 	}
 }
\ No newline at end of file
@@ -0,0 +1,197 @@
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <thread>
+
+#include "CpuFeatures.h"
+#include "Profiler.h"
+#include "Renderer.h"
+#include "Scene.h"
+#include "Timer.h"
+
+using namespace dae;
+
+namespace
+{
+	struct CameraKeyframe
+	{
+		float time{}; //Normalized [0,1] over the whole run
+		Vector3 offset{}; //Relative to the camera position the scene starts with
+		float pitch{};
+		float yaw{};
+	};
+
+	//Small dolly/pan loop around the starting camera, ends where it began
+	const CameraKeyframe g_CameraPath[]
+	{
+		{ 0.00f, Vector3{  0.0f, 0.0f, 0.0f },  0.f * TO_RADIANS,   0.f * TO_RADIANS },
+		{ 0.25f, Vector3{  1.5f, 0.0f, 0.0f },  0.f * TO_RADIANS, -10.f * TO_RADIANS },
+		{ 0.50f, Vector3{  0.0f, 0.0f, 2.0f },  5.f * TO_RADIANS,   0.f * TO_RADIANS },
+		{ 0.75f, Vector3{ -1.5f, 0.5f, 0.0f },  0.f * TO_RADIANS,  10.f * TO_RADIANS },
+		{ 1.00f, Vector3{  0.0f, 0.0f, 0.0f },  0.f * TO_RADIANS,   0.f * TO_RADIANS }
+	};
+
+	void ApplyCameraPath(Camera& camera, const Vector3& startOrigin, float normalizedTime)
+	{
+		constexpr size_t numKeyframes{ sizeof(g_CameraPath) / sizeof(g_CameraPath[0]) };
+
+		size_t keyIdx{ 0 };
+		while (keyIdx + 2 < numKeyframes && normalizedTime > g_CameraPath[keyIdx + 1].time)
+			++keyIdx;
+
+		const CameraKeyframe& from{ g_CameraPath[keyIdx] };
+		const CameraKeyframe& to{ g_CameraPath[keyIdx + 1] };
+		const float factor{ std::clamp((normalizedTime - from.time) / (to.time - from.time), 0.f, 1.f) };
+
+		const Vector3 offset{
+			Lerpf(from.offset.x, to.offset.x, factor),
+			Lerpf(from.offset.y, to.offset.y, factor),
+			Lerpf(from.offset.z, to.offset.z, factor) };
+
+		camera.SetPose(startOrigin + offset, Lerpf(from.pitch, to.pitch, factor), Lerpf(from.yaw, to.yaw, factor));
+	}
+
+	//Nearest-rank percentile, expects sorted values
+	float Percentile(const std::vector<float>& sortedValues, float percentile)
+	{
+		if (sortedValues.empty())
+			return 0.f;
+
+		const size_t rank{ size_t(std::ceil(percentile / 100.f * sortedValues.size())) };
+		return sortedValues[std::clamp(rank, size_t(1), sortedValues.size()) - 1];
+	}
+}
+
+Benchmark::Benchmark(const BenchmarkSettings& settings) :
+	m_Settings(settings)
+{
+	if (m_Settings.sceneNames.empty())
+		m_Settings.sceneNames = GetSceneNames();
+}
+
+bool Benchmark::Run()
+{
+	m_Results.clear();
+
+	for (const std::string& sceneName : m_Settings.sceneNames)
+	{
+		if (!RunScene(sceneName))
+			return false;
+	}
+
+	return true;
+}
+
+bool Benchmark::RunScene(const std::string& sceneName)
+{
+	const std::unique_ptr<Scene> pScene{ CreateScene(sceneName) };
+	if (!pScene)
+	{
+		std::cout << "Unknown scene: " << sceneName << std::endl;
+		return false;
+	}
+
+	pScene->Initialize();
+	pScene->CalibrateIntersectionAlgorithms();
+
+	Renderer renderer{ m_Settings.width, m_Settings.height };
+	const Vector3 startOrigin{ pScene->GetCamera().origin };
+
+	BenchmarkResult result{};
+	result.sceneName = sceneName;
+	result.sphereAlgorithm = ToString(pScene->GetSphereAlgorithm());
+	result.triangleAlgorithm = ToString(pScene->GetTriangleAlgorithm());
+	result.frameTimesMs.reserve(m_Settings.measuredFrames);
+
+	//Warmup and measurement both play the same timeline from t = 0
+	const auto playTimeline = [&](uint32_t numFrames, bool isMeasured) {
+		Timer timer{};
+		timer.SetFixedTimeStep(m_Settings.timeStep);
+		timer.Start();
+
+		for (uint32_t frame{ 0 }; frame < numFrames; ++frame)
+		{
+			const uint64_t frameStartNs{ Profiler::Now() };
+
+			timer.Update();
+			pScene->Update(&timer);
+			ApplyCameraPath(pScene->GetCamera(), startOrigin, numFrames > 1 ? float(frame) / (numFrames - 1) : 0.f);
+			renderer.Render(pScene.get());
+
+			const uint64_t frameEndNs{ Profiler::Now() };
+
+			if (isMeasured)
+			{
+				result.frameTimesMs.push_back(float(frameEndNs - frameStartNs) / 1'000'000.f);
+				result.rayStats += renderer.GetFrameStats();
+			}
+		}
+	};
+
+	std::cout << "Benchmarking " << sceneName << "..." << std::endl;
+	playTimeline(m_Settings.warmupFrames, false);
+	playTimeline(m_Settings.measuredFrames, true);
+
+	m_Results.push_back(result);
+	return true;
+}
+
+bool Benchmark::WriteJson(const std::string& filename) const
+{
+	std::ofstream fileStream(filename);
+	if (!fileStream)
+		return false;
+
+	fileStream << "{\n";
+	fileStream << "  \"kernelIsa\": \"" << GetKernelIsaName() << "\",\n";
+	fileStream << "  \"threads\": " << std::thread::hardware_concurrency() << ",\n";
+	fileStream << "  \"width\": " << m_Settings.width << ",\n";
+	fileStream << "  \"height\": " << m_Settings.height << ",\n";
+	fileStream << "  \"warmupFrames\": " << m_Settings.warmupFrames << ",\n";
+	fileStream << "  \"measuredFrames\": " << m_Settings.measuredFrames << ",\n";
+	fileStream << "  \"timeStep\": " << m_Settings.timeStep << ",\n";
+	fileStream << "  \"scenes\": [";
+
+	for (size_t resultIdx{ 0 }; resultIdx < m_Results.size(); ++resultIdx)
+	{
+		const BenchmarkResult& result{ m_Results[resultIdx] };
+
+		std::vector<float> sortedTimes{ result.frameTimesMs };
+		std::sort(sortedTimes.begin(), sortedTimes.end());
+
+		const float totalMs{ std::accumulate(sortedTimes.begin(), sortedTimes.end(), 0.f) };
+		const float meanMs{ sortedTimes.empty() ? 0.f : totalMs / sortedTimes.size() };
+		const double raysPerSecond{ totalMs > 0.f ? result.rayStats.GetTotalRays() / (totalMs / 1000.0) : 0.0 };
+
+		fileStream << (resultIdx == 0 ? "" : ",") << "\n    {\n";
+		fileStream << "      \"name\": \"" << result.sceneName << "\",\n";
+		fileStream << "      \"sphereAlgorithm\": \"" << result.sphereAlgorithm << "\",\n";
+		fileStream << "      \"triangleAlgorithm\": \"" << result.triangleAlgorithm << "\",\n";
+		fileStream << "      \"frameTimeMs\": { "
+			<< "\"mean\": " << meanMs
+			<< ", \"min\": " << (sortedTimes.empty() ? 0.f : sortedTimes.front())
+			<< ", \"p50\": " << Percentile(sortedTimes, 50.f)
+			<< ", \"p95\": " << Percentile(sortedTimes, 95.f)
+			<< ", \"p99\": " << Percentile(sortedTimes, 99.f)
+			<< ", \"max\": " << (sortedTimes.empty() ? 0.f : sortedTimes.back())
+			<< " },\n";
+		fileStream << "      \"raysPerSecond\": " << uint64_t(raysPerSecond) << ",\n";
+		fileStream << "      \"primaryRays\": " << result.rayStats.primaryRays << ",\n";
+		fileStream << "      \"shadowRays\": " << result.rayStats.shadowRays << ",\n";
+		fileStream << "      \"secondaryRays\": " << result.rayStats.secondaryRays << ",\n";
+		fileStream << "      \"primitiveTests\": " << result.rayStats.GetTotalPrimitiveTests() << ",\n";
+		fileStream << "      \"frameTimesMs\": [";
+		for (size_t frame{ 0 }; frame < result.frameTimesMs.size(); ++frame)
+		{
+			fileStream << (frame == 0 ? "" : ", ") << result.frameTimesMs[frame];
+		}
+		fileStream << "]\n    }";
+	}
+
+	fileStream << "\n  ]\n}\n";
+	return fileStream.good();
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "RayStats.h"
+
+namespace dae
+{
+	struct BenchmarkSettings
+	{
+		int width{ 640 };
+		int height{ 480 };
+
+		uint32_t warmupFrames{ 10 };
+		uint32_t measuredFrames{ 120 };
+		float timeStep{ 1.f / 30.f }; //Scene time between two frames, independent of how long a frame takes
+
+		std::vector<std::string> sceneNames{}; //Empty = every built-in scene
+	};
+
+	struct BenchmarkResult
+	{
+		std::string sceneName{};
+		std::string sphereAlgorithm{};
+		std::string triangleAlgorithm{};
+		std::vector<float> frameTimesMs{};
+		RayStats rayStats{};
+	};
+
+	/**
+	 * \brief Headless, reproducible benchmark: every scene is rendered offscreen along a fixed
+	 * camera path and animation timeline (fixed time step), first warmupFrames unmeasured, then measuredFrames timed.
+	 */
+	class Benchmark final
+	{
+	public:
+		explicit Benchmark(const BenchmarkSettings& settings);
+		~Benchmark() = default;
+
+		Benchmark(const Benchmark&) = delete;
+		Benchmark(Benchmark&&) noexcept = delete;
+		Benchmark& operator=(const Benchmark&) = delete;
+		Benchmark& operator=(Benchmark&&) noexcept = delete;
+
+		bool Run();
+		bool WriteJson(const std::string& filename) const;
+
+		const std::vector<BenchmarkResult>& GetResults() const { return m_Results; }
+
+	private:
+		bool RunScene(const std::string& sceneName);
+
+		BenchmarkSettings m_Settings{};
+		std::vector<BenchmarkResult> m_Results{};
+	};
+}
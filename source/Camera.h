@@ -1,7 +1,10 @@
 #pragma once
 #include <cassert>
+#include <cstdlib>
+#if !defined(HEADLESS)
 #include <SDL_keyboard.h>
 #include <SDL_mouse.h>
+#endif
 
 #include "Math.h"
 #include "Timer.h"
@@ -45,10 +48,36 @@ namespace dae
 			return cameraToWorld;
 		}
 
+		//The speeds are const, so a camera can't be assigned: copies everything input and scripts change instead
+		void CopyState(const Camera& other)
+		{
+			origin = other.origin;
+			fovAngle = other.fovAngle;
+			forward = other.forward;
+			up = other.up;
+			right = other.right;
+			totalPitch = other.totalPitch;
+			totalYaw = other.totalYaw;
+			cameraToWorld = other.cameraToWorld;
+		}
+
+		//Places the camera directly (scripted camera paths), bypassing input
+		void SetPose(const Vector3& _origin, float pitch, float yaw)
+		{
+			origin = _origin;
+			totalPitch = pitch;
+			totalYaw = yaw;
+
+			Matrix totalRotation{ Matrix::CreateRotation(totalPitch,totalYaw,0) };
+			forward = totalRotation.TransformVector(Vector3::UnitZ);
+			forward.Normalize();
+		}
+
 		void Update(Timer* pTimer)
 		{
 			const float deltaTime = pTimer->GetElapsed();
 
+#if !defined(HEADLESS)
 			//Keyboard Input
 			const uint8_t* pKeyboardState = SDL_GetKeyboardState(nullptr);
 
@@ -91,6 +120,7 @@ namespace dae
 				totalYaw -= mouseX * rotationSpeed * pTimer->GetElapsed();
 				totalPitch -= mouseY * rotationSpeed * pTimer->GetElapsed();
 			}
+#endif
 
 			Matrix totalRotation{ Matrix::CreateRotation(totalPitch,totalYaw,0) };
 			forward = totalRotation.TransformVector(Vector3::UnitZ);
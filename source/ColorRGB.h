@@ -22,7 +22,8 @@ namespace dae
 		}
 
 		#pragma region ColorRGB (Member) Operators
-		const ColorRGB& operator+=(const ColorRGB& c)
+		//Binary operators never touch *this, compound assignments do
+		ColorRGB& operator+=(const ColorRGB& c)
 		{
 			r += c.r;
 			g += c.g;
@@ -31,17 +32,12 @@ namespace dae
 			return *this;
 		}
 
-		const ColorRGB& operator+(const ColorRGB& c)
-		{
-			return *this += c;
-		}
-
 		ColorRGB operator+(const ColorRGB& c) const
 		{
 			return { r + c.r, g + c.g, b + c.b };
 		}
 
-		const ColorRGB& operator-=(const ColorRGB& c)
+		ColorRGB& operator-=(const ColorRGB& c)
 		{
 			r -= c.r;
 			g -= c.g;
@@ -50,17 +46,12 @@ namespace dae
 			return *this;
 		}
 
-		const ColorRGB& operator-(const ColorRGB& c)
-		{
-			return *this -= c;
-		}
-
 		ColorRGB operator-(const ColorRGB& c) const
 		{
 			return { r - c.r, g - c.g, b - c.b };
 		}
 
-		const ColorRGB& operator*=(const ColorRGB& c)
+		ColorRGB& operator*=(const ColorRGB& c)
 		{
 			r *= c.r;
 			g *= c.g;
@@ -69,17 +60,12 @@ namespace dae
 			return *this;
 		}
 
-		const ColorRGB& operator*(const ColorRGB& c)
-		{
-			return *this *= c;
-		}
-
 		ColorRGB operator*(const ColorRGB& c) const
 		{
 			return { r * c.r, g * c.g, b * c.b };
 		}
 
-		const ColorRGB& operator/=(const ColorRGB& c)
+		ColorRGB& operator/=(const ColorRGB& c)
 		{
 			r /= c.r;
 			g /= c.g;
@@ -88,12 +74,12 @@ namespace dae
 			return *this;
 		}
 
-		const ColorRGB& operator/(const ColorRGB& c)
+		ColorRGB operator/(const ColorRGB& c) const
 		{
-			return *this /= c;
+			return { r / c.r, g / c.g, b / c.b };
 		}
 
-		const ColorRGB& operator*=(float s)
+		ColorRGB& operator*=(float s)
 		{
 			r *= s;
 			g *= s;
@@ -102,17 +88,12 @@ namespace dae
 			return *this;
 		}
 
-		const ColorRGB& operator*(float s)
-		{
-			return *this *= s;
-		}
-
 		ColorRGB operator*(float s) const
 		{
-			return { r * s, g * s,b * s };
+			return { r * s, g * s, b * s };
 		}
 
-		const ColorRGB& operator/=(float s)
+		ColorRGB& operator/=(float s)
 		{
 			r /= s;
 			g /= s;
@@ -121,9 +102,9 @@ namespace dae
 			return *this;
 		}
 
-		const ColorRGB& operator/(float s)
+		ColorRGB operator/(float s) const
 		{
-			return *this /= s;
+			return { r / s, g / s, b / s };
 		}
 		#pragma endregion
 	};
@@ -0,0 +1,61 @@
+#include "CpuFeatures.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+using namespace dae;
+
+namespace
+{
+	CpuFeatures DetectCpuFeatures()
+	{
+		CpuFeatures features{};
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+		int cpuInfo[4]{};
+		__cpuid(cpuInfo, 0);
+		const int maxLeaf{ cpuInfo[0] };
+
+		__cpuid(cpuInfo, 1);
+		features.sse42 = (cpuInfo[2] & (1 << 20)) != 0;
+
+		//AVX state has to be enabled by the OS as well (OSXSAVE + XCR0), not just supported by the CPU
+		const bool hasOsxsave{ (cpuInfo[2] & (1 << 27)) != 0 };
+		const unsigned long long xcr0{ hasOsxsave ? _xgetbv(0) : 0 };
+		const bool osSavesAvx{ (xcr0 & 0x6) == 0x6 };
+
+		if (maxLeaf >= 7) {
+			__cpuidex(cpuInfo, 7, 0);
+			features.avx2 = osSavesAvx && (cpuInfo[1] & (1 << 5)) != 0;
+		}
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+		__builtin_cpu_init();
+		features.sse42 = __builtin_cpu_supports("sse4.2");
+		features.avx2 = __builtin_cpu_supports("avx2");
+#endif
+
+		return features;
+	}
+}
+
+const CpuFeatures& dae::GetCpuFeatures()
+{
+	static const CpuFeatures s_Features{ DetectCpuFeatures() };
+	return s_Features;
+}
+
+const char* dae::GetKernelIsaName()
+{
+#if defined(ISA_DISPATCH_AVAILABLE)
+	//Same priority order the ifunc resolvers use
+	const CpuFeatures& features{ GetCpuFeatures() };
+	if (features.avx2)
+		return "avx2";
+	if (features.sse42)
+		return "sse4.2";
+#endif
+
+	return "baseline";
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+//Comment out to build every hot kernel for the baseline instruction set only
+#define ENABLE_ISA_DISPATCH
+
+/**
+ * \brief Marks a hot kernel that gets compiled once per instruction set level (baseline x86-64, SSE4.2, AVX2).
+ * The loader picks the best variant for the CPU the program runs on (cpuid, through an ifunc resolver),
+ * so one binary runs at full speed on every generation. GCC/Clang on x86-64 ELF only, elsewhere it's the baseline build.
+ * Virtual functions can't be multiversioned, keep the hot loop in a non-virtual function and tag that.
+ * No AVX-512 variant: on the benchmark scenes it measured well behind AVX2.
+ */
+#if defined(ENABLE_ISA_DISPATCH) && defined(__x86_64__) && defined(__ELF__) && (defined(__GNUC__) || defined(__clang__))
+#define ISA_DISPATCH_AVAILABLE
+#define HOT_KERNEL __attribute__((target_clones("default", "sse4.2", "avx2")))
+#else
+#define HOT_KERNEL
+#endif
+
+namespace dae
+{
+	struct CpuFeatures
+	{
+		bool sse42{};
+		bool avx2{};
+	};
+
+	//Detected once, on first use
+	const CpuFeatures& GetCpuFeatures();
+
+	//Instruction set level the HOT_KERNEL variants run with on this CPU
+	const char* GetKernelIsaName();
+}
@@ -1,7 +1,9 @@
 #pragma once
 #include <cassert>
+#include <cfloat>
 
 #include "Math.h"
+#include "Profiler.h"
 #include "vector"
 
 namespace dae
@@ -145,21 +147,22 @@ namespace dae
 
 		void UpdateTransforms()
 		{
-			transformedPositions.clear();
-			transformedPositions.reserve(positions.size());
+			PROFILE_SCOPE("TriangleMesh::UpdateTransforms");
+
+			//Buffers are only (re)sized when the mesh itself changes, every other frame they are overwritten in place
+			transformedPositions.resize(positions.size());
 			Matrix transformMatrix{ scaleTransform * rotationTransform * translationTransform };
 
-			for (Vector3 vertex : positions) {
-				transformedPositions.emplace_back(transformMatrix.TransformPoint(vertex));
+			for (size_t index{ 0 }; index < positions.size(); ++index) {
+				transformedPositions[index] = transformMatrix.TransformPoint(positions[index]);
 			}
 
 			UpdateTransformedAABB(transformMatrix);
 
-			transformedNormals.clear();
-			transformedNormals.reserve(normals.size());
+			transformedNormals.resize(normals.size());
 
-			for (Vector3 normal : normals) {
-				transformedNormals.emplace_back(transformMatrix.TransformVector(normal));
+			for (size_t index{ 0 }; index < normals.size(); ++index) {
+				transformedNormals[index] = transformMatrix.TransformVector(normals[index]);
 			}
 		}
 
@@ -212,22 +215,47 @@ namespace dae
 	};
 #pragma endregion
 #pragma region LIGHT
+	//Rect, Disk and Sphere are area lights, they cast soft shadows (see AreaLights.h)
 	enum class LightType
 	{
 		Point,
-		Directional
+		Directional,
+		Rect,
+		Disk,
+		Sphere
 	};
 
 	struct Light
 	{
 		Vector3 origin{};
-		Vector3 direction{};
+		Vector3 direction{}; //Rects and disks: the side they emit to
 		ColorRGB color{};
 		float intensity{};
+		//Point lights are ignored beyond this distance, 0 reaches everywhere
+		float influenceRadius{};
+
+		//Rects span origin +- edgeU +- edgeV, disks and spheres have a radius
+		Vector3 edgeU{};
+		Vector3 edgeV{};
+		float radius{};
 
 		LightType type{};
 	};
 #pragma endregion
+#pragma region INTERSECTION ALGORITHMS
+	enum class SphereAlgorithm { Analytic, Geometric };
+	enum class TriangleAlgorithm { Naive, MollerTrumbore };
+
+	inline const char* ToString(SphereAlgorithm algorithm)
+	{
+		return algorithm == SphereAlgorithm::Analytic ? "Analytic" : "Geometric";
+	}
+
+	inline const char* ToString(TriangleAlgorithm algorithm)
+	{
+		return algorithm == TriangleAlgorithm::Naive ? "Naive" : "MollerTrumbore";
+	}
+#pragma endregion
 #pragma region MISC
 	struct Ray
 	{
@@ -247,5 +275,14 @@ namespace dae
 		bool didHit{ false };
 		unsigned char materialIndex{ 0 };
 	};
+
+	//What a pixel sample's primary ray hit, for the passes that work on the surfaces the pixels show (denoising). A depth of 0 is a miss
+	struct PrimaryHit
+	{
+		Vector3 position{};
+		Vector3 normal{};
+		ColorRGB albedo{};
+		float depth{};
+	};
 #pragma endregion
 }
\ No newline at end of file
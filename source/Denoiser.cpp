@@ -0,0 +1,318 @@
+#include "Denoiser.h"
+#include "CpuFeatures.h"
+#include "Float8.h"
+#include "Renderer.h"
+#include "Threading.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+using namespace dae;
+
+namespace
+{
+	//B3 spline, the 1D kernel of every pass
+	constexpr float KERNEL[5]{ 1.f / 16, 1.f / 4, 3.f / 8, 1.f / 4, 1.f / 16 };
+	//The normal weight is dot^64, computed as this many squarings
+	constexpr int NORMAL_SQUARINGS{ 6 };
+	//Keeps black albedo from dividing by zero, and flat noise-free regions from dividing by a zero deviation
+	constexpr float ALBEDO_EPSILON{ 0.01f };
+	constexpr float EPSILON{ 1e-4f };
+	//Surfaces seen at grazing angles change depth quickly, the expected slope is capped there
+	constexpr float MIN_COS_VIEW{ 0.1f };
+
+	inline Float8 Luminance8(const Float8& red, const Float8& green, const Float8& blue)
+	{
+		return Set8(0.2126f) * red + Set8(0.7152f) * green + Set8(0.0722f) * blue;
+	}
+
+	//Edge-stopping weights fall off like exp(-x), x >= 0, approximated by 1 / (1 + x + x^2 / 2): same start and slope, no exp per lane.
+	//Returns the denominator, so the weights of a tap can share one division
+	inline Float8 FalloffDenominator8(const Float8& x)
+	{
+		return Set8(1.f) + x + Set8(0.5f) * x * x;
+	}
+
+	//max(dot(n, m), 0)^64, 1 on the same surface and quickly 0 across a crease
+	inline Float8 NormalWeight8(const Float8& normalX, const Float8& normalY, const Float8& normalZ, const float* pNormalX, const float* pNormalY, const float* pNormalZ)
+	{
+		Float8 weight{ Max8(normalX * Load8(pNormalX) + normalY * Load8(pNormalY) + normalZ * Load8(pNormalZ), Set8(0.f)) };
+		for (int squaring{ 0 }; squaring < NORMAL_SQUARINGS; ++squaring)
+		{
+			weight = weight * weight;
+		}
+		return weight;
+	}
+}
+
+Denoiser::Denoiser(const DenoiserSettings& settings) :
+	m_Settings(settings)
+{
+}
+
+void Denoiser::Resize(int width, int height)
+{
+	if (width == m_Width && height == m_Height)
+		return;
+
+	m_Width = width;
+	m_Height = height;
+
+	//The last pass reaches 2 * 2^(numIterations - 1) pixels out, the right border also takes the last Float8 of a row
+	m_Border = ((1 << m_Settings.numIterations) + 7) / 8 * 8;
+	m_PaddedWidth = m_Border + (width + 7) / 8 * 8 + m_Border;
+
+	const size_t numPaddedPixels{ size_t(m_PaddedWidth) * size_t(height + 2 * m_Border) };
+	for (std::vector<float>* pPlane : { &m_Guides.albedoRed, &m_Guides.albedoGreen, &m_Guides.albedoBlue, &m_Guides.normalX, &m_Guides.normalY,
+		&m_Guides.normalZ, &m_Guides.depth, &m_Guides.depthSlope })
+	{
+		pPlane->assign(numPaddedPixels, 0.f);
+	}
+
+	for (FilterPlanes& planes : m_Planes)
+	{
+		for (std::vector<float>* pPlane : { &planes.red, &planes.green, &planes.blue, &planes.variance })
+		{
+			pPlane->assign(numPaddedPixels, 0.f);
+		}
+	}
+}
+
+template<typename TileTask>
+void Denoiser::ForEachTile(const TileTask& task) const
+{
+	const uint32_t numTilesX{ uint32_t((m_Width + TILE_SIZE - 1) / TILE_SIZE) };
+	const uint32_t numTilesY{ uint32_t((m_Height + TILE_SIZE - 1) / TILE_SIZE) };
+
+	ParallelFor(0u, numTilesX * numTilesY, [&](uint32_t tileIndex) {
+		const int tileStartX{ int(tileIndex % numTilesX) * TILE_SIZE };
+		const int tileStartY{ int(tileIndex / numTilesX) * TILE_SIZE };
+		task(tileStartX, tileStartY, std::min(tileStartX + TILE_SIZE, m_Width), std::min(tileStartY + TILE_SIZE, m_Height));
+	});
+}
+
+void Denoiser::SetGuides(const std::vector<PrimaryHit>& primaryHits, const ImagePlane& imagePlane, const Camera& camera)
+{
+	Resize(imagePlane.width, imagePlane.height);
+	assert(primaryHits.size() == size_t(m_Width) * m_Height && "One primary hit per pixel");
+
+	//World size of a pixel at distance 1
+	const float pixelFootprint{ 2 * imagePlane.fov / imagePlane.height };
+
+	ForEachTile([&](int startX, int startY, int endX, int endY) {
+		for (int py{ startY }; py < endY; ++py) {
+			for (int px{ startX }; px < endX; ++px) {
+				const PrimaryHit& hit{ primaryHits[size_t(py) * m_Width + px] };
+				const size_t pixelIndex{ GetPaddedIndex(px, py) };
+
+				float depthSlope{ 0.f };
+				if (hit.depth > 0.f) {
+					//A pixel further along, a surface at angle theta to the view is this much deeper: depth * footprint * tan(theta)
+					const float cosView{ std::max(fabsf(Vector3::Dot(hit.normal, hit.position - camera.origin)) / hit.depth, MIN_COS_VIEW) };
+					depthSlope = hit.depth * pixelFootprint * (1 + sqrtf(1 - cosView * cosView) / cosView);
+				}
+
+				m_Guides.albedoRed[pixelIndex] = hit.albedo.r;
+				m_Guides.albedoGreen[pixelIndex] = hit.albedo.g;
+				m_Guides.albedoBlue[pixelIndex] = hit.albedo.b;
+				m_Guides.normalX[pixelIndex] = hit.normal.x;
+				m_Guides.normalY[pixelIndex] = hit.normal.y;
+				m_Guides.normalZ[pixelIndex] = hit.normal.z;
+				m_Guides.depth[pixelIndex] = hit.depth;
+				m_Guides.depthSlope[pixelIndex] = depthSlope;
+			}
+		}
+	});
+}
+
+void Denoiser::Apply(HdrBuffer& hdrBuffer)
+{
+	assert(hdrBuffer.width == m_Width && hdrBuffer.height == m_Height && "Set the guides at the size of the image first");
+
+	//Lighting only: radiance divided by the albedo
+	ForEachTile([&](int startX, int startY, int endX, int endY) {
+		for (int py{ startY }; py < endY; ++py) {
+			for (int px{ startX }; px < endX; ++px) {
+				const size_t pixelIndex{ size_t(py) * m_Width + px };
+				const size_t paddedIndex{ GetPaddedIndex(px, py) };
+
+				m_Planes[1].red[paddedIndex] = hdrBuffer.red[pixelIndex] / std::max(m_Guides.albedoRed[paddedIndex], ALBEDO_EPSILON);
+				m_Planes[1].green[paddedIndex] = hdrBuffer.green[pixelIndex] / std::max(m_Guides.albedoGreen[paddedIndex], ALBEDO_EPSILON);
+				m_Planes[1].blue[paddedIndex] = hdrBuffer.blue[pixelIndex] / std::max(m_Guides.albedoBlue[paddedIndex], ALBEDO_EPSILON);
+			}
+		}
+	});
+
+	ForEachTile([&](int startX, int startY, int endX, int endY) {
+		for (int py{ startY }; py < endY; ++py) {
+			ClampFireflies(m_Planes[1], m_Planes[0], GetPaddedIndex(startX, py), endX - startX);
+		}
+	});
+
+	ForEachTile([&](int startX, int startY, int endX, int endY) {
+		for (int py{ startY }; py < endY; ++py) {
+			EstimateVariance(m_Planes[0], m_Planes[0].variance, GetPaddedIndex(startX, py), endX - startX);
+		}
+	});
+
+	for (uint32_t iteration{ 0 }; iteration < m_Settings.numIterations; ++iteration)
+	{
+		const FilterPlanes& source{ m_Planes[iteration % 2] };
+		FilterPlanes& destination{ m_Planes[(iteration + 1) % 2] };
+
+		ForEachTile([&](int startX, int startY, int endX, int endY) {
+			for (int py{ startY }; py < endY; ++py) {
+				FilterRow(source, destination, GetPaddedIndex(startX, py), endX - startX, 1 << iteration);
+			}
+		});
+	}
+
+	//Albedo back on, misses keep what they had
+	const FilterPlanes& result{ m_Planes[m_Settings.numIterations % 2] };
+	ForEachTile([&](int startX, int startY, int endX, int endY) {
+		for (int py{ startY }; py < endY; ++py) {
+			for (int px{ startX }; px < endX; ++px) {
+				const size_t pixelIndex{ size_t(py) * m_Width + px };
+				const size_t paddedIndex{ GetPaddedIndex(px, py) };
+				if (m_Guides.depth[paddedIndex] <= 0.f)
+					continue;
+
+				hdrBuffer.red[pixelIndex] = result.red[paddedIndex] * std::max(m_Guides.albedoRed[paddedIndex], ALBEDO_EPSILON);
+				hdrBuffer.green[pixelIndex] = result.green[paddedIndex] * std::max(m_Guides.albedoGreen[paddedIndex], ALBEDO_EPSILON);
+				hdrBuffer.blue[pixelIndex] = result.blue[paddedIndex] * std::max(m_Guides.albedoBlue[paddedIndex], ALBEDO_EPSILON);
+			}
+		}
+	});
+}
+
+//Scales every pixel down to the luminance of its brightest direct neighbour, which only changes pixels brighter than all of them
+HOT_KERNEL void Denoiser::ClampFireflies(const FilterPlanes& source, FilterPlanes& destination, size_t firstPixel, int numPixels) const
+{
+	for (int blockStart{ 0 }; blockStart < numPixels; blockStart += 8)
+	{
+		const size_t pixelIndex{ firstPixel + size_t(blockStart) };
+
+		const Float8 red{ Load8(source.red.data() + pixelIndex) };
+		const Float8 green{ Load8(source.green.data() + pixelIndex) };
+		const Float8 blue{ Load8(source.blue.data() + pixelIndex) };
+
+		Float8 maxLuminance{ Set8(0.f) };
+		for (int tapY{ -1 }; tapY <= 1; ++tapY) {
+			for (int tapX{ -1 }; tapX <= 1; ++tapX) {
+				if (tapX == 0 && tapY == 0)
+					continue;
+
+				const size_t tapIndex{ size_t(ptrdiff_t(pixelIndex) + ptrdiff_t(tapY) * m_PaddedWidth + tapX) };
+				maxLuminance = Max8(maxLuminance, Luminance8(Load8(source.red.data() + tapIndex), Load8(source.green.data() + tapIndex), Load8(source.blue.data() + tapIndex)));
+			}
+		}
+
+		const Float8 scale{ Min8(maxLuminance / Max8(Luminance8(red, green, blue), Set8(EPSILON)), Set8(1.f)) };
+		Store8(destination.red.data() + pixelIndex, red * scale);
+		Store8(destination.green.data() + pixelIndex, green * scale);
+		Store8(destination.blue.data() + pixelIndex, blue * scale);
+	}
+}
+
+//Luminance variance over the 5x5 pixels around every pixel that lie on the same surface
+HOT_KERNEL void Denoiser::EstimateVariance(const FilterPlanes& planes, std::vector<float>& variance, size_t firstPixel, int numPixels) const
+{
+	for (int blockStart{ 0 }; blockStart < numPixels; blockStart += 8)
+	{
+		const size_t pixelIndex{ firstPixel + size_t(blockStart) };
+
+		const Float8 normalX{ Load8(m_Guides.normalX.data() + pixelIndex) };
+		const Float8 normalY{ Load8(m_Guides.normalY.data() + pixelIndex) };
+		const Float8 normalZ{ Load8(m_Guides.normalZ.data() + pixelIndex) };
+		const Float8 depth{ Load8(m_Guides.depth.data() + pixelIndex) };
+		//Depth differences in expected slopes of the surface
+		const Float8 depthScale{ Set8(1.f) / (Set8(m_Settings.depthSigma) * Load8(m_Guides.depthSlope.data() + pixelIndex) + Set8(EPSILON)) };
+
+		Float8 sumWeight{ Set8(0.f) };
+		Float8 sumLuminance{ Set8(0.f) };
+		Float8 sumSqrLuminance{ Set8(0.f) };
+
+		for (int tapY{ -2 }; tapY <= 2; ++tapY) {
+			for (int tapX{ -2 }; tapX <= 2; ++tapX) {
+				const size_t tapIndex{ size_t(ptrdiff_t(pixelIndex) + ptrdiff_t(tapY) * m_PaddedWidth + tapX) };
+				//The center's depth difference is 0, any distance does
+				const float inverseDistance{ 1.f / std::max({ std::abs(tapX), std::abs(tapY), 1 }) };
+
+				const Float8 normalWeight{ NormalWeight8(normalX, normalY, normalZ,
+					m_Guides.normalX.data() + tapIndex, m_Guides.normalY.data() + tapIndex, m_Guides.normalZ.data() + tapIndex) };
+				const Float8 depthDifference{ Abs8(depth - Load8(m_Guides.depth.data() + tapIndex)) * depthScale * Set8(inverseDistance) };
+				const Float8 weight{ normalWeight / FalloffDenominator8(depthDifference) };
+
+				const Float8 luminance{ Luminance8(Load8(planes.red.data() + tapIndex), Load8(planes.green.data() + tapIndex), Load8(planes.blue.data() + tapIndex)) };
+				sumWeight = sumWeight + weight;
+				sumLuminance = sumLuminance + weight * luminance;
+				sumSqrLuminance = sumSqrLuminance + weight * luminance * luminance;
+			}
+		}
+
+		const Float8 inverseWeight{ Set8(1.f) / Max8(sumWeight, Set8(1e-20f)) };
+		const Float8 mean{ sumLuminance * inverseWeight };
+		Store8(variance.data() + pixelIndex, Max8(sumSqrLuminance * inverseWeight - mean * mean, Set8(0.f)));
+	}
+}
+
+//One a-trous pass, taps step pixels apart. The variance is filtered along with the squared weights, so later passes see how much noise is left
+HOT_KERNEL void Denoiser::FilterRow(const FilterPlanes& source, FilterPlanes& destination, size_t firstPixel, int numPixels, int step) const
+{
+	for (int blockStart{ 0 }; blockStart < numPixels; blockStart += 8)
+	{
+		const size_t pixelIndex{ firstPixel + size_t(blockStart) };
+
+		const Float8 red{ Load8(source.red.data() + pixelIndex) };
+		const Float8 green{ Load8(source.green.data() + pixelIndex) };
+		const Float8 blue{ Load8(source.blue.data() + pixelIndex) };
+		const Float8 variance{ Load8(source.variance.data() + pixelIndex) };
+		const Float8 luminance{ Luminance8(red, green, blue) };
+
+		const Float8 normalX{ Load8(m_Guides.normalX.data() + pixelIndex) };
+		const Float8 normalY{ Load8(m_Guides.normalY.data() + pixelIndex) };
+		const Float8 normalZ{ Load8(m_Guides.normalZ.data() + pixelIndex) };
+		const Float8 depth{ Load8(m_Guides.depth.data() + pixelIndex) };
+		//Depth differences in expected slopes of the surface, luminance differences in standard deviations of this pixel's noise
+		const Float8 depthScale{ Set8(1.f) / (Set8(m_Settings.depthSigma) * Load8(m_Guides.depthSlope.data() + pixelIndex) + Set8(EPSILON)) };
+		const Float8 luminanceScale{ Set8(1.f) / (Set8(m_Settings.luminanceSigma) * Sqrt8(variance) + Set8(EPSILON)) };
+
+		Float8 sumWeight{ Set8(0.f) };
+		Float8 sumRed{ Set8(0.f) };
+		Float8 sumGreen{ Set8(0.f) };
+		Float8 sumBlue{ Set8(0.f) };
+		Float8 sumVariance{ Set8(0.f) };
+
+		for (int tapY{ -2 }; tapY <= 2; ++tapY) {
+			for (int tapX{ -2 }; tapX <= 2; ++tapX) {
+				const size_t tapIndex{ size_t(ptrdiff_t(pixelIndex) + ptrdiff_t(tapY * step) * m_PaddedWidth + tapX * step) };
+				const float inverseDistance{ 1.f / float(step * std::max({ std::abs(tapX), std::abs(tapY), 1 })) };
+
+				const Float8 tapRed{ Load8(source.red.data() + tapIndex) };
+				const Float8 tapGreen{ Load8(source.green.data() + tapIndex) };
+				const Float8 tapBlue{ Load8(source.blue.data() + tapIndex) };
+
+				const Float8 normalWeight{ NormalWeight8(normalX, normalY, normalZ,
+					m_Guides.normalX.data() + tapIndex, m_Guides.normalY.data() + tapIndex, m_Guides.normalZ.data() + tapIndex) };
+				const Float8 depthDifference{ Abs8(depth - Load8(m_Guides.depth.data() + tapIndex)) * depthScale * Set8(inverseDistance) };
+				const Float8 luminanceDifference{ Abs8(luminance - Luminance8(tapRed, tapGreen, tapBlue)) * luminanceScale };
+				const Float8 weight{ Set8(KERNEL[tapX + 2] * KERNEL[tapY + 2]) * normalWeight
+					/ (FalloffDenominator8(depthDifference) * FalloffDenominator8(luminanceDifference)) };
+
+				sumWeight = sumWeight + weight;
+				sumRed = sumRed + weight * tapRed;
+				sumGreen = sumGreen + weight * tapGreen;
+				sumBlue = sumBlue + weight * tapBlue;
+				sumVariance = sumVariance + weight * weight * Load8(source.variance.data() + tapIndex);
+			}
+		}
+
+		//Misses (and the border) have no weights at all, they keep their value
+		const Float8 inverseWeight{ Set8(1.f) / Max8(sumWeight, Set8(1e-20f)) };
+		Store8(destination.red.data() + pixelIndex, SelectLessEqual8(depth, 0.f, red, sumRed * inverseWeight));
+		Store8(destination.green.data() + pixelIndex, SelectLessEqual8(depth, 0.f, green, sumGreen * inverseWeight));
+		Store8(destination.blue.data() + pixelIndex, SelectLessEqual8(depth, 0.f, blue, sumBlue * inverseWeight));
+		Store8(destination.variance.data() + pixelIndex, SelectLessEqual8(depth, 0.f, variance, sumVariance * inverseWeight * inverseWeight));
+	}
+}
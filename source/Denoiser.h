@@ -0,0 +1,101 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "HdrBuffer.h"
+
+namespace dae
+{
+	struct Camera;
+	struct ImagePlane;
+	struct PrimaryHit;
+
+	struct DenoiserSettings
+	{
+		//Passes of the 5x5 kernel, every pass doubles the spacing of its taps. 4 passes reach 30 pixels out
+		uint32_t numIterations{ 4 };
+		//Neighbours whose luminance differs by this many standard deviations of the pixel's noise hardly count
+		float luminanceSigma{ 4.f };
+		//How much further a neighbour's depth may be off than the surface's slope explains
+		float depthSigma{ 1.f };
+	};
+
+	/**
+	 * \brief Edge-avoiding a-trous wavelet filter (Dammertz et al. 2010) with SVGF's noise-driven luminance weights (Schied et al. 2017).
+	 * The primary hit of every pixel (recorded by the tracer) gives the guides: albedo, normal and depth. Radiance is divided by the albedo first,
+	 * so only the lighting gets smoothed and texture and material edges come back sharp. Single pixels brighter than all their neighbours
+	 * (fireflies) are dimmed first, the filter would smear them into blotches. The filter stops at normal and depth edges,
+	 * and at luminance differences the pixel's own noise (estimated from its neighbours, then filtered along) doesn't explain.
+	 * Works on planes with a border of empty pixels around the image, so the taps of 8 neighbouring pixels can be loaded as one Float8
+	 * without bounds checks. Every pass goes over tiles on the thread pool.
+	 */
+	class Denoiser final
+	{
+	public:
+		explicit Denoiser(const DenoiserSettings& settings = {});
+		~Denoiser() = default;
+
+		Denoiser(const Denoiser&) = delete;
+		Denoiser(Denoiser&&) noexcept = delete;
+		Denoiser& operator=(const Denoiser&) = delete;
+		Denoiser& operator=(Denoiser&&) noexcept = delete;
+
+		//Keeps albedo, normal and depth of the primary hit of every pixel, one per pixel of the image plane in row order.
+		//The camera is the one the hits were traced with
+		void SetGuides(const std::vector<PrimaryHit>& primaryHits, const ImagePlane& imagePlane, const Camera& camera);
+
+		//Filters hdrBuffer in place, with the guides of the last SetGuides (of the same size). Pixels that hit nothing are left as they are
+		void Apply(HdrBuffer& hdrBuffer);
+
+	private:
+		//Tiles handed to the thread pool, a multiple of 8 wide so no two tiles write to the same Float8
+		static constexpr int TILE_SIZE{ 64 };
+
+		//Primary hit attributes. Misses and the border have a zero normal, which no weight survives, and a depth of 0
+		struct GuidePlanes
+		{
+			std::vector<float> albedoRed{};
+			std::vector<float> albedoGreen{};
+			std::vector<float> albedoBlue{};
+			std::vector<float> normalX{};
+			std::vector<float> normalY{};
+			std::vector<float> normalZ{};
+			std::vector<float> depth{};
+			//Depth difference to expect per pixel of distance on the same surface
+			std::vector<float> depthSlope{};
+		};
+
+		//Radiance divided by the albedo, and the variance of its luminance
+		struct FilterPlanes
+		{
+			std::vector<float> red{};
+			std::vector<float> green{};
+			std::vector<float> blue{};
+			std::vector<float> variance{};
+		};
+
+		void Resize(int width, int height);
+		size_t GetPaddedIndex(int x, int y) const { return size_t(y + m_Border) * m_PaddedWidth + size_t(x + m_Border); }
+
+		//Calls task(startX, startY, endX, endY) for every tile of the image, on the thread pool
+		template<typename TileTask>
+		void ForEachTile(const TileTask& task) const;
+
+		//Passes over numPixels pixels of a row starting at firstPixel (padded index), 8 at a time
+		void ClampFireflies(const FilterPlanes& source, FilterPlanes& destination, size_t firstPixel, int numPixels) const;
+		void EstimateVariance(const FilterPlanes& planes, std::vector<float>& variance, size_t firstPixel, int numPixels) const;
+		void FilterRow(const FilterPlanes& source, FilterPlanes& destination, size_t firstPixel, int numPixels, int step) const;
+
+		DenoiserSettings m_Settings{};
+
+		int m_Width{};
+		int m_Height{};
+		//Empty pixels on every side, at least as wide as the last pass reaches
+		int m_Border{};
+		int m_PaddedWidth{};
+
+		GuidePlanes m_Guides{};
+		//Passes read from one and write to the other
+		FilterPlanes m_Planes[2]{};
+	};
+}
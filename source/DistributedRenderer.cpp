@@ -0,0 +1,860 @@
+#include "DistributedRenderer.h"
+#include "ImageSink.h"
+#include "OfflineRenderer.h"
+#include "Scene.h"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <thread>
+
+#if !defined(_WIN32)
+#include <cerrno>
+#include <climits>
+#include <csignal>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <spawn.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+#endif
+
+using namespace dae;
+
+//Values are sent as they are in memory, which is only the same everywhere as long as every machine is little endian
+static_assert(std::endian::native == std::endian::little, "The render protocol is little endian");
+
+#if !defined(_WIN32)
+namespace
+{
+	//Bumped whenever a message changes, workers of another build are turned away
+	constexpr uint32_t PROTOCOL_VERSION{ 2 };
+
+	//Chunks in flight per worker, so a worker never sits idle waiting for its next chunk
+	constexpr size_t MAX_CHUNKS_PER_WORKER{ 2 };
+
+	//How long Start() waits for a worker to connect or load the scene
+	constexpr int STARTUP_TIMEOUT_MS{ 120'000 };
+	//Once a message has started, the rest of it may not take longer than this to arrive (or to be sent). A worker that stalls is lost
+	constexpr int MESSAGE_TIMEOUT_MS{ 30'000 };
+	//How long a worker may take for the chunk it's on before it's considered hung, and its chunks go to the others.
+	//Generous, a chunk is normally done in well under a second
+	constexpr int CHUNK_TIMEOUT_MS{ 120'000 };
+	//How long Stop() gives local workers to quit before killing them
+	constexpr int WORKER_EXIT_TIMEOUT_MS{ 10'000 };
+
+	//Anything bigger than this is not a message of ours
+	constexpr uint32_t MAX_PAYLOAD_SIZE{ 256 * 1024 * 1024 };
+
+	enum class MessageType : uint32_t
+	{
+		Hello,       //Worker > coordinator: protocol version
+		LoadScene,   //Coordinator > worker: scene name, sphere + triangle algorithm, shadows, tile size
+		SceneLoaded, //Worker > coordinator
+		BeginFrame,  //Coordinator > worker: frame index, width, height, animate (uint8) + time
+		RenderChunk, //Coordinator > worker: frame index, chunk index, x, y, width, height
+		ChunkResult, //Worker > coordinator: same as RenderChunk, followed by the red, green and blue planes of the chunk
+		Shutdown     //Coordinator > worker
+	};
+
+	//On the wire: uint32 type, uint32 payload size, payload
+	struct Message
+	{
+		MessageType type{};
+		std::vector<char> payload{};
+		size_t readOffset{ 0 };
+
+		void WriteBytes(const void* pData, size_t size)
+		{
+			const char* pBytes{ static_cast<const char*>(pData) };
+			payload.insert(payload.end(), pBytes, pBytes + size);
+		}
+
+		template<typename T>
+		void Write(const T& value)
+		{
+			WriteBytes(&value, sizeof(T));
+		}
+
+		void WriteString(const std::string& text)
+		{
+			Write(uint32_t(text.size()));
+			WriteBytes(text.data(), text.size());
+		}
+
+		//All reads return false once the payload runs out
+		bool ReadBytes(void* pData, size_t size)
+		{
+			if (readOffset + size > payload.size())
+				return false;
+
+			std::memcpy(pData, payload.data() + readOffset, size);
+			readOffset += size;
+			return true;
+		}
+
+		template<typename T>
+		bool Read(T& value)
+		{
+			return ReadBytes(&value, sizeof(T));
+		}
+
+		bool ReadString(std::string& text)
+		{
+			uint32_t size{};
+			if (!Read(size) || readOffset + size > payload.size())
+				return false;
+
+			text.assign(payload.data() + readOffset, size);
+			readOffset += size;
+			return true;
+		}
+	};
+
+	bool SendAll(int socket, const void* pData, size_t size)
+	{
+		const char* pBytes{ static_cast<const char*>(pData) };
+		while (size > 0)
+		{
+			//MSG_NOSIGNAL: a worker that went away should be an error, not a SIGPIPE
+			const ssize_t numSent{ send(socket, pBytes, size, MSG_NOSIGNAL) };
+			if (numSent < 0 && errno == EINTR)
+				continue;
+			if (numSent <= 0)
+				return false;
+
+			pBytes += numSent;
+			size -= size_t(numSent);
+		}
+
+		return true;
+	}
+
+	bool ReceiveAll(int socket, void* pData, size_t size)
+	{
+		char* pBytes{ static_cast<char*>(pData) };
+		while (size > 0)
+		{
+			const ssize_t numReceived{ recv(socket, pBytes, size, 0) };
+			if (numReceived < 0 && errno == EINTR)
+				continue;
+			if (numReceived <= 0)
+				return false;
+
+			pBytes += numReceived;
+			size -= size_t(numReceived);
+		}
+
+		return true;
+	}
+
+	bool SendMessage(int socket, const Message& message)
+	{
+		const uint32_t header[2]{ uint32_t(message.type), uint32_t(message.payload.size()) };
+		return SendAll(socket, header, sizeof(header)) && SendAll(socket, message.payload.data(), message.payload.size());
+	}
+
+	bool ReceiveMessage(int socket, Message& message)
+	{
+		uint32_t header[2]{};
+		if (!ReceiveAll(socket, header, sizeof(header)) || header[1] > MAX_PAYLOAD_SIZE)
+			return false;
+
+		message.type = MessageType(header[0]);
+		message.payload.resize(header[1]);
+		message.readOffset = 0;
+		return ReceiveAll(socket, message.payload.data(), message.payload.size());
+	}
+
+	//False on timeout or error
+	bool WaitForData(int socket, int timeoutMs)
+	{
+		pollfd pollFd{ socket, POLLIN, 0 };
+		int result{};
+		do
+		{
+			result = poll(&pollFd, 1, timeoutMs);
+		} while (result < 0 && errno == EINTR);
+
+		return result > 0;
+	}
+
+	//Small control messages should leave right away instead of waiting to be batched
+	void DisableNagle(int socket)
+	{
+		const int enabled{ 1 };
+		setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, &enabled, sizeof(enabled));
+	}
+
+	//A remote host that vanishes without closing the connection shows up as an error on the socket within a few minutes,
+	//instead of the default of hours
+	void EnableKeepAlive(int socket)
+	{
+		const int enabled{ 1 };
+		setsockopt(socket, SOL_SOCKET, SO_KEEPALIVE, &enabled, sizeof(enabled));
+#if defined(TCP_KEEPIDLE)
+		const int idleSeconds{ 60 };
+		const int intervalSeconds{ 10 };
+		const int numProbes{ 6 };
+		setsockopt(socket, IPPROTO_TCP, TCP_KEEPIDLE, &idleSeconds, sizeof(idleSeconds));
+		setsockopt(socket, IPPROTO_TCP, TCP_KEEPINTVL, &intervalSeconds, sizeof(intervalSeconds));
+		setsockopt(socket, IPPROTO_TCP, TCP_KEEPCNT, &numProbes, sizeof(numProbes));
+#endif
+	}
+
+	//A recv or send that makes no progress for MESSAGE_TIMEOUT_MS fails (EAGAIN) instead of blocking forever
+	void SetMessageTimeout(int socket)
+	{
+		const timeval timeout{ MESSAGE_TIMEOUT_MS / 1000, (MESSAGE_TIMEOUT_MS % 1000) * 1000 };
+		setsockopt(socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+		setsockopt(socket, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+	}
+
+	struct ChunkRegion
+	{
+		int x{};
+		int y{};
+		int width{};
+		int height{};
+	};
+
+	void WriteChunkHeader(Message& message, uint32_t frameIndex, uint32_t chunkIndex, const ChunkRegion& region)
+	{
+		message.Write(frameIndex);
+		message.Write(chunkIndex);
+		message.Write(int32_t(region.x));
+		message.Write(int32_t(region.y));
+		message.Write(int32_t(region.width));
+		message.Write(int32_t(region.height));
+	}
+
+	bool ReadChunkHeader(Message& message, uint32_t& frameIndex, uint32_t& chunkIndex, ChunkRegion& region)
+	{
+		int32_t values[4]{};
+		const bool succeeded{ message.Read(frameIndex) && message.Read(chunkIndex) && message.ReadBytes(values, sizeof(values)) };
+		region = { values[0], values[1], values[2], values[3] };
+		return succeeded;
+	}
+
+	//Collects the tiles of one chunk on the worker, in the planar layout they're sent in
+	class ChunkSink final : public ImageSink
+	{
+	public:
+		bool Begin(int width, int height) override
+		{
+			m_Width = width;
+
+			const size_t numPixels{ size_t(width) * height };
+			m_Red.assign(numPixels, 0.f);
+			m_Green.assign(numPixels, 0.f);
+			m_Blue.assign(numPixels, 0.f);
+			return true;
+		}
+
+		bool WriteTile(const ImageTile& tile) override
+		{
+			for (int row{ 0 }; row < tile.height; ++row)
+			{
+				const size_t sourceIndex{ row * tile.rowStride };
+				const size_t destinationIndex{ size_t(tile.y + row) * m_Width + tile.x };
+				std::memcpy(&m_Red[destinationIndex], tile.pRed + sourceIndex, tile.width * sizeof(float));
+				std::memcpy(&m_Green[destinationIndex], tile.pGreen + sourceIndex, tile.width * sizeof(float));
+				std::memcpy(&m_Blue[destinationIndex], tile.pBlue + sourceIndex, tile.width * sizeof(float));
+			}
+			return true;
+		}
+
+		bool End() override { return true; }
+
+		void WritePlanes(Message& message) const
+		{
+			message.WriteBytes(m_Red.data(), m_Red.size() * sizeof(float));
+			message.WriteBytes(m_Green.data(), m_Green.size() * sizeof(float));
+			message.WriteBytes(m_Blue.data(), m_Blue.size() * sizeof(float));
+		}
+
+	private:
+		int m_Width{};
+		std::vector<float> m_Red{};
+		std::vector<float> m_Green{};
+		std::vector<float> m_Blue{};
+	};
+}
+
+#pragma region Coordinator
+DistributedRenderer::DistributedRenderer(const DistributedRenderSettings& settings) :
+	m_Settings(settings)
+{
+}
+
+DistributedRenderer::~DistributedRenderer()
+{
+	Stop();
+}
+
+bool DistributedRenderer::Start(const std::string& sceneName, SphereAlgorithm sphereAlgorithm, TriangleAlgorithm triangleAlgorithm)
+{
+	const uint32_t numWorkers{ m_Settings.numLocalWorkers + m_Settings.numRemoteWorkers };
+	if (numWorkers == 0)
+		return false;
+
+	//Remote workers need to reach us from outside, local ones only ever connect over loopback
+	//Close on exec, so local workers don't inherit it and keep the port open after Stop()
+	m_ListenSocket = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	const int reuseAddress{ 1 };
+	setsockopt(m_ListenSocket, SOL_SOCKET, SO_REUSEADDR, &reuseAddress, sizeof(reuseAddress));
+
+	sockaddr_in address{};
+	address.sin_family = AF_INET;
+	address.sin_port = htons(m_Settings.port);
+	address.sin_addr.s_addr = htonl(m_Settings.numRemoteWorkers > 0 ? INADDR_ANY : INADDR_LOOPBACK);
+
+	socklen_t addressSize{ sizeof(address) };
+	if (m_ListenSocket < 0
+		|| bind(m_ListenSocket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0
+		|| listen(m_ListenSocket, SOMAXCONN) != 0
+		|| getsockname(m_ListenSocket, reinterpret_cast<sockaddr*>(&address), &addressSize) != 0)
+	{
+		std::cout << "Could not listen for render workers: " << std::strerror(errno) << std::endl;
+		Stop();
+		return false;
+	}
+
+	const uint16_t port{ ntohs(address.sin_port) };
+	if (m_Settings.numRemoteWorkers > 0)
+		std::cout << "Waiting for " << m_Settings.numRemoteWorkers << " remote render worker(s) on port " << port << std::endl;
+
+	//Local workers are this same executable, resolved so they show up under its name in ps/top
+	char executablePath[PATH_MAX]{};
+	if (readlink("/proc/self/exe", executablePath, sizeof(executablePath) - 1) < 0)
+		std::strcpy(executablePath, "/proc/self/exe");
+
+	const std::string localAddress{ "127.0.0.1:" + std::to_string(port) };
+	for (uint32_t workerIdx{ 0 }; workerIdx < m_Settings.numLocalWorkers; ++workerIdx)
+	{
+		char* arguments[]{ executablePath, const_cast<char*>("--worker"), const_cast<char*>(localAddress.c_str()), nullptr };
+
+		pid_t processId{};
+		if (posix_spawn(&processId, executablePath, nullptr, nullptr, arguments, environ) != 0)
+		{
+			std::cout << "Could not start a render worker process" << std::endl;
+			Stop();
+			return false;
+		}
+		m_LocalProcessIds.push_back(processId);
+	}
+
+	for (uint32_t workerIdx{ 0 }; workerIdx < numWorkers; ++workerIdx)
+	{
+		Worker worker{};
+		if (WaitForData(m_ListenSocket, STARTUP_TIMEOUT_MS))
+			worker.socket = accept4(m_ListenSocket, nullptr, nullptr, SOCK_CLOEXEC);
+		if (worker.socket >= 0)
+		{
+			SetMessageTimeout(worker.socket);
+			EnableKeepAlive(worker.socket);
+		}
+
+		Message hello{};
+		uint32_t protocolVersion{};
+		if (worker.socket < 0
+			|| !WaitForData(worker.socket, STARTUP_TIMEOUT_MS)
+			|| !ReceiveMessage(worker.socket, hello)
+			|| hello.type != MessageType::Hello
+			|| !hello.Read(protocolVersion)
+			|| protocolVersion != PROTOCOL_VERSION)
+		{
+			std::cout << "Render worker " << workerIdx << " did not connect or speaks another protocol version" << std::endl;
+			DisconnectWorker(worker);
+			Stop();
+			return false;
+		}
+
+		DisableNagle(worker.socket);
+		m_Workers.push_back(std::move(worker));
+	}
+
+	Message loadScene{ MessageType::LoadScene };
+	loadScene.WriteString(sceneName);
+	loadScene.Write(uint8_t(sphereAlgorithm));
+	loadScene.Write(uint8_t(triangleAlgorithm));
+	loadScene.Write(uint8_t(m_Settings.shadowsEnabled));
+	loadScene.Write(int32_t(m_Settings.tileSize));
+
+	//Every worker loads at the same time, then we wait for all of them
+	for (Worker& worker : m_Workers)
+	{
+		if (!SendMessage(worker.socket, loadScene))
+			DisconnectWorker(worker);
+	}
+
+	for (Worker& worker : m_Workers)
+	{
+		Message sceneLoaded{};
+		if (worker.socket < 0
+			|| !WaitForData(worker.socket, STARTUP_TIMEOUT_MS)
+			|| !ReceiveMessage(worker.socket, sceneLoaded)
+			|| sceneLoaded.type != MessageType::SceneLoaded)
+		{
+			std::cout << "A render worker could not load " << sceneName << std::endl;
+			Stop();
+			return false;
+		}
+	}
+
+	std::cout << numWorkers << " render worker(s) ready" << std::endl;
+	return true;
+}
+
+bool DistributedRenderer::RenderFrame(int width, int height, ImageSink& sink, std::optional<float> time)
+{
+	if (GetNumWorkers() == 0)
+		return false;
+
+	//Chunks have to cover whole tiles of sinks that write a tile grid
+	const int requiredTileSize{ sink.GetRequiredTileSize() };
+	int chunkSize{ m_Settings.chunkSize };
+	if (requiredTileSize > 0)
+		chunkSize = (chunkSize + requiredTileSize - 1) / requiredTileSize * requiredTileSize;
+
+	const uint32_t numChunksX{ uint32_t((width + chunkSize - 1) / chunkSize) };
+	const uint32_t numChunksY{ uint32_t((height + chunkSize - 1) / chunkSize) };
+	const uint32_t numChunks{ numChunksX * numChunksY };
+
+	const auto getChunkRegion = [&](uint32_t chunkIndex) {
+		ChunkRegion region{};
+		region.x = int(chunkIndex % numChunksX) * chunkSize;
+		region.y = int(chunkIndex / numChunksX) * chunkSize;
+		region.width = std::min(chunkSize, width - region.x);
+		region.height = std::min(chunkSize, height - region.y);
+		return region;
+	};
+
+	if (!sink.Begin(width, height))
+		return false;
+
+	++m_FrameIndex;
+
+	std::deque<uint32_t> unassignedChunks{};
+	for (uint32_t chunkIndex{ 0 }; chunkIndex < numChunks; ++chunkIndex)
+	{
+		unassignedChunks.push_back(chunkIndex);
+	}
+
+	//Whatever a lost worker still had goes back to the others
+	const auto dropWorker = [&](Worker& worker) {
+		std::cout << "Lost a render worker, its chunks are handed to the others" << std::endl;
+		unassignedChunks.insert(unassignedChunks.end(), worker.assignedChunks.begin(), worker.assignedChunks.end());
+		DisconnectWorker(worker);
+	};
+
+	const auto getChunkDeadline = [] {
+		return std::chrono::steady_clock::now() + std::chrono::milliseconds(CHUNK_TIMEOUT_MS);
+	};
+
+	const auto assignChunks = [&](Worker& worker) {
+		while (worker.socket >= 0 && worker.assignedChunks.size() < MAX_CHUNKS_PER_WORKER && !unassignedChunks.empty())
+		{
+			//An idle worker starts on this chunk right away, otherwise it's queued behind the one it's on
+			if (worker.assignedChunks.empty())
+				worker.chunkDeadline = getChunkDeadline();
+
+			const uint32_t chunkIndex{ unassignedChunks.front() };
+			unassignedChunks.pop_front();
+			worker.assignedChunks.push_back(chunkIndex);
+
+			Message renderChunk{ MessageType::RenderChunk };
+			WriteChunkHeader(renderChunk, m_FrameIndex, chunkIndex, getChunkRegion(chunkIndex));
+			if (!SendMessage(worker.socket, renderChunk))
+				dropWorker(worker);
+		}
+	};
+
+	Message beginFrame{ MessageType::BeginFrame };
+	beginFrame.Write(m_FrameIndex);
+	beginFrame.Write(int32_t(width));
+	beginFrame.Write(int32_t(height));
+	beginFrame.Write(uint8_t(time.has_value()));
+	beginFrame.Write(time.value_or(0.f));
+	for (Worker& worker : m_Workers)
+	{
+		if (worker.socket >= 0 && !SendMessage(worker.socket, beginFrame))
+			dropWorker(worker);
+	}
+
+	bool succeeded{ true };
+	uint32_t numFinishedChunks{ 0 };
+	std::vector<pollfd> pollFds{};
+	std::vector<Worker*> pollWorkers{};
+	Message result{};
+
+	while (numFinishedChunks < numChunks)
+	{
+		for (Worker& worker : m_Workers)
+		{
+			assignChunks(worker);
+		}
+
+		//Workers that sit on their chunk too long are hung (or their host is gone), and dropped like disconnected ones
+		const auto now{ std::chrono::steady_clock::now() };
+		auto nextDeadline{ std::chrono::steady_clock::time_point::max() };
+		pollFds.clear();
+		pollWorkers.clear();
+		for (Worker& worker : m_Workers)
+		{
+			if (worker.socket >= 0 && !worker.assignedChunks.empty() && worker.chunkDeadline <= now)
+			{
+				std::cout << "A render worker did not finish its chunk in time" << std::endl;
+				dropWorker(worker);
+			}
+
+			if (worker.socket < 0)
+				continue;
+
+			if (!worker.assignedChunks.empty())
+				nextDeadline = std::min(nextDeadline, worker.chunkDeadline);
+
+			pollFds.push_back({ worker.socket, POLLIN, 0 });
+			pollWorkers.push_back(&worker);
+		}
+
+		//Chunks of dropped workers are handed out on the next pass
+		if (!unassignedChunks.empty() && std::any_of(pollWorkers.begin(), pollWorkers.end(),
+			[](const Worker* pWorker) { return pWorker->assignedChunks.size() < MAX_CHUNKS_PER_WORKER; }))
+			continue;
+
+		if (pollFds.empty())
+		{
+			std::cout << "No render workers left, frame not finished!" << std::endl;
+			sink.End();
+			return false;
+		}
+
+		int timeoutMs{ -1 };
+		if (nextDeadline != std::chrono::steady_clock::time_point::max())
+		{
+			const auto untilDeadline{ std::chrono::duration_cast<std::chrono::milliseconds>(nextDeadline - now).count() };
+			timeoutMs = int(std::clamp<decltype(untilDeadline)>(untilDeadline + 1, 0, CHUNK_TIMEOUT_MS));
+		}
+
+		if (poll(pollFds.data(), pollFds.size(), timeoutMs) < 0)
+		{
+			if (errno == EINTR)
+				continue;
+
+			sink.End();
+			return false;
+		}
+
+		for (size_t pollIdx{ 0 }; pollIdx < pollFds.size(); ++pollIdx)
+		{
+			if (pollFds[pollIdx].revents == 0)
+				continue;
+
+			Worker& worker{ *pollWorkers[pollIdx] };
+
+			uint32_t frameIndex{};
+			uint32_t chunkIndex{};
+			ChunkRegion region{};
+			//A worker that stalls halfway through its result times out, and is dropped like a disconnected one
+			if (!ReceiveMessage(worker.socket, result)
+				|| result.type != MessageType::ChunkResult
+				|| !ReadChunkHeader(result, frameIndex, chunkIndex, region))
+			{
+				dropWorker(worker);
+				continue;
+			}
+
+			const auto assignedChunk{ std::find(worker.assignedChunks.begin(), worker.assignedChunks.end(), chunkIndex) };
+			const ChunkRegion expectedRegion{ chunkIndex < numChunks ? getChunkRegion(chunkIndex) : ChunkRegion{} };
+			const size_t numPixels{ size_t(expectedRegion.width) * expectedRegion.height };
+			if (frameIndex != m_FrameIndex
+				|| assignedChunk == worker.assignedChunks.end()
+				|| std::memcmp(&region, &expectedRegion, sizeof(region)) != 0
+				|| result.payload.size() - result.readOffset != numPixels * 3 * sizeof(float))
+			{
+				dropWorker(worker);
+				continue;
+			}
+			worker.assignedChunks.erase(assignedChunk);
+			//The worker moves on to the next chunk it was given
+			worker.chunkDeadline = getChunkDeadline();
+
+			//The planes follow the 24 byte chunk header, so they're float aligned within the payload
+			const float* pRed{ reinterpret_cast<const float*>(result.payload.data() + result.readOffset) };
+			const float* pGreen{ pRed + numPixels };
+			const float* pBlue{ pGreen + numPixels };
+
+			//Passed on in pieces of the sink's tile grid, if it has one
+			const int pieceSize{ requiredTileSize > 0 ? requiredTileSize : std::max(region.width, region.height) };
+			for (int pieceY{ 0 }; pieceY < region.height; pieceY += pieceSize)
+			{
+				for (int pieceX{ 0 }; pieceX < region.width; pieceX += pieceSize)
+				{
+					const size_t firstPixel{ size_t(pieceY) * region.width + pieceX };
+
+					ImageTile tile{};
+					tile.x = region.x + pieceX;
+					tile.y = region.y + pieceY;
+					tile.width = std::min(pieceSize, region.width - pieceX);
+					tile.height = std::min(pieceSize, region.height - pieceY);
+					tile.pRed = pRed + firstPixel;
+					tile.pGreen = pGreen + firstPixel;
+					tile.pBlue = pBlue + firstPixel;
+					tile.rowStride = size_t(region.width);
+
+					succeeded &= sink.WriteTile(tile);
+				}
+			}
+
+			++numFinishedChunks;
+			if (numFinishedChunks * 10 / numChunks != (numFinishedChunks - 1) * 10 / numChunks)
+				std::cout << "Rendered " << numFinishedChunks * 100 / numChunks << "% (" << numFinishedChunks << "/" << numChunks << " chunks)" << std::endl;
+		}
+	}
+
+	return sink.End() && succeeded;
+}
+
+void DistributedRenderer::Stop()
+{
+	for (Worker& worker : m_Workers)
+	{
+		if (worker.socket >= 0)
+			SendMessage(worker.socket, Message{ MessageType::Shutdown });
+
+		DisconnectWorker(worker);
+	}
+	m_Workers.clear();
+
+	if (m_ListenSocket >= 0)
+	{
+		close(m_ListenSocket);
+		m_ListenSocket = -1;
+	}
+
+	//Workers that never got to connect find the listen socket gone and quit on their own. Wedged ones are killed
+	const auto deadline{ std::chrono::steady_clock::now() + std::chrono::milliseconds(WORKER_EXIT_TIMEOUT_MS) };
+	for (const int processId : m_LocalProcessIds)
+	{
+		int result{};
+		while ((result = waitpid(processId, nullptr, WNOHANG)) == 0 || (result < 0 && errno == EINTR))
+		{
+			if (std::chrono::steady_clock::now() >= deadline)
+			{
+				std::cout << "A render worker did not quit, killing it" << std::endl;
+				kill(processId, SIGKILL);
+				while (waitpid(processId, nullptr, 0) < 0 && errno == EINTR) {}
+				break;
+			}
+
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+	}
+	m_LocalProcessIds.clear();
+}
+
+uint32_t DistributedRenderer::GetNumWorkers() const
+{
+	return uint32_t(std::count_if(m_Workers.begin(), m_Workers.end(), [](const Worker& worker) { return worker.socket >= 0; }));
+}
+
+void DistributedRenderer::DisconnectWorker(Worker& worker)
+{
+	if (worker.socket >= 0)
+		close(worker.socket);
+
+	worker.socket = -1;
+	worker.assignedChunks.clear();
+}
+#pragma endregion
+
+#pragma region Worker
+int dae::RunRenderWorker(const std::string& coordinatorAddress)
+{
+	const size_t separator{ coordinatorAddress.rfind(':') };
+	if (separator == std::string::npos)
+	{
+		std::cout << "Expected <host>:<port>, got " << coordinatorAddress << std::endl;
+		return 1;
+	}
+
+	const std::string host{ coordinatorAddress.substr(0, separator) };
+	const std::string port{ coordinatorAddress.substr(separator + 1) };
+
+	addrinfo hints{};
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+
+	addrinfo* pAddresses{};
+	if (getaddrinfo(host.c_str(), port.c_str(), &hints, &pAddresses) != 0)
+	{
+		std::cout << "Could not resolve " << coordinatorAddress << std::endl;
+		return 1;
+	}
+
+	int coordinatorSocket{ -1 };
+	for (const addrinfo* pAddress{ pAddresses }; pAddress && coordinatorSocket < 0; pAddress = pAddress->ai_next)
+	{
+		coordinatorSocket = socket(pAddress->ai_family, pAddress->ai_socktype, pAddress->ai_protocol);
+		if (coordinatorSocket >= 0 && connect(coordinatorSocket, pAddress->ai_addr, pAddress->ai_addrlen) != 0)
+		{
+			close(coordinatorSocket);
+			coordinatorSocket = -1;
+		}
+	}
+	freeaddrinfo(pAddresses);
+
+	if (coordinatorSocket < 0)
+	{
+		std::cout << "Could not connect to the coordinator at " << coordinatorAddress << std::endl;
+		return 1;
+	}
+	DisableNagle(coordinatorSocket);
+
+	Message hello{ MessageType::Hello };
+	hello.Write(PROTOCOL_VERSION);
+
+	std::unique_ptr<Scene> pScene{};
+	std::unique_ptr<OfflineRenderer> pRenderer{};
+	OfflineRenderSettings renderSettings{};
+	renderSettings.printProgress = false;
+	uint32_t frameIndex{};
+
+	int exitCode{ 1 };
+	bool isRunning{ SendMessage(coordinatorSocket, hello) };
+	Message message{};
+
+	while (isRunning && ReceiveMessage(coordinatorSocket, message))
+	{
+		switch (message.type)
+		{
+		case MessageType::LoadScene:
+		{
+			std::string sceneName{};
+			uint8_t sphereAlgorithm{};
+			uint8_t triangleAlgorithm{};
+			uint8_t shadowsEnabled{};
+			int32_t tileSize{};
+			isRunning = message.ReadString(sceneName) && message.Read(sphereAlgorithm) && message.Read(triangleAlgorithm)
+				&& message.Read(shadowsEnabled) && message.Read(tileSize);
+
+			pScene = isRunning ? CreateScene(sceneName) : nullptr;
+			if (!pScene)
+			{
+				std::cout << "Render worker: unknown scene " << sceneName << std::endl;
+				isRunning = false;
+				break;
+			}
+
+			pScene->Initialize();
+			pScene->SetIntersectionAlgorithms(SphereAlgorithm(sphereAlgorithm), TriangleAlgorithm(triangleAlgorithm));
+			renderSettings.shadowsEnabled = shadowsEnabled != 0;
+			renderSettings.tileSize = tileSize;
+
+			isRunning = SendMessage(coordinatorSocket, Message{ MessageType::SceneLoaded });
+			break;
+		}
+		case MessageType::BeginFrame:
+		{
+			int32_t width{};
+			int32_t height{};
+			uint8_t isAnimated{};
+			float time{};
+			isRunning = pScene && message.Read(frameIndex) && message.Read(width) && message.Read(height)
+				&& message.Read(isAnimated) && message.Read(time);
+			if (!isRunning)
+				break;
+
+			if (isAnimated)
+				pScene->Animate(time);
+
+			renderSettings.width = width;
+			renderSettings.height = height;
+			pRenderer = std::make_unique<OfflineRenderer>(renderSettings);
+			break;
+		}
+		case MessageType::RenderChunk:
+		{
+			uint32_t chunkFrameIndex{};
+			uint32_t chunkIndex{};
+			ChunkRegion region{};
+			isRunning = pRenderer && ReadChunkHeader(message, chunkFrameIndex, chunkIndex, region) && chunkFrameIndex == frameIndex;
+			if (!isRunning)
+				break;
+
+			ChunkSink chunkSink{};
+			pRenderer->RenderRegion(pScene.get(), chunkSink, region.x, region.y, region.width, region.height);
+
+			Message chunkResult{ MessageType::ChunkResult };
+			chunkResult.payload.reserve(24 + size_t(region.width) * region.height * 3 * sizeof(float));
+			WriteChunkHeader(chunkResult, chunkFrameIndex, chunkIndex, region);
+			chunkSink.WritePlanes(chunkResult);
+
+			isRunning = SendMessage(coordinatorSocket, chunkResult);
+			break;
+		}
+		case MessageType::Shutdown:
+			exitCode = 0;
+			isRunning = false;
+			break;
+		default:
+			std::cout << "Render worker: unexpected message " << uint32_t(message.type) << std::endl;
+			isRunning = false;
+			break;
+		}
+	}
+
+	close(coordinatorSocket);
+	return exitCode;
+}
+#pragma endregion
+
+#else
+//No sockets or process spawning on Windows yet, the coordinator just reports it can't start
+DistributedRenderer::DistributedRenderer(const DistributedRenderSettings& settings) :
+	m_Settings(settings)
+{
+}
+
+DistributedRenderer::~DistributedRenderer() = default;
+
+bool DistributedRenderer::Start(const std::string&, SphereAlgorithm, TriangleAlgorithm)
+{
+	std::cout << "Distributed rendering is not supported on this platform" << std::endl;
+	return false;
+}
+
+bool DistributedRenderer::RenderFrame(int, int, ImageSink&, std::optional<float>)
+{
+	return false;
+}
+
+void DistributedRenderer::Stop()
+{
+}
+
+uint32_t DistributedRenderer::GetNumWorkers() const
+{
+	return 0;
+}
+
+void DistributedRenderer::DisconnectWorker(Worker&)
+{
+}
+
+int dae::RunRenderWorker(const std::string&)
+{
+	std::cout << "Distributed rendering is not supported on this platform" << std::endl;
+	return 1;
+}
+#endif
@@ -0,0 +1,77 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "DataTypes.h"
+
+namespace dae
+{
+	class ImageSink;
+
+	struct DistributedRenderSettings
+	{
+		//Worker processes of this binary started on this machine
+		uint32_t numLocalWorkers{ 4 };
+		//Workers started by hand elsewhere with: RayTracer --worker <coordinator host>:<port>
+		uint32_t numRemoteWorkers{ 0 };
+		//0 = any free port, only useful without remote workers
+		uint16_t port{ 0 };
+
+		//Square chunks of the frame handed to one worker at a time, workers split them into tileSize tiles for their threads
+		int chunkSize{ 128 };
+		int tileSize{ 64 };
+		bool shadowsEnabled{ true };
+	};
+
+	/**
+	 * \brief Coordinator of a multi-process render. Workers connect over TCP (so they can live on other machines),
+	 * load the scene once in Start() and stay alive for every RenderFrame() until Stop().
+	 * Frames are split into chunks that are handed out on demand, finished chunks go straight to the sink.
+	 * Chunks of a worker that disconnects are given to the others.
+	 */
+	class DistributedRenderer final
+	{
+	public:
+		explicit DistributedRenderer(const DistributedRenderSettings& settings);
+		~DistributedRenderer();
+
+		DistributedRenderer(const DistributedRenderer&) = delete;
+		DistributedRenderer(DistributedRenderer&&) noexcept = delete;
+		DistributedRenderer& operator=(const DistributedRenderer&) = delete;
+		DistributedRenderer& operator=(DistributedRenderer&&) noexcept = delete;
+
+		//Starts the local workers, waits for all workers to connect and load the scene.
+		//The intersection algorithms are passed on so every worker traces exactly the same way
+		bool Start(const std::string& sceneName, SphereAlgorithm sphereAlgorithm, TriangleAlgorithm triangleAlgorithm);
+		//With a time, every worker first puts its scene in the state it has at that time (Scene::Animate)
+		bool RenderFrame(int width, int height, ImageSink& sink, std::optional<float> time = std::nullopt);
+		void Stop();
+
+		uint32_t GetNumWorkers() const;
+
+	private:
+		struct Worker
+		{
+			int socket{ -1 };
+			std::vector<uint32_t> assignedChunks{};
+			//When the worker has to be done with the first of its assigned chunks
+			std::chrono::steady_clock::time_point chunkDeadline{};
+		};
+
+		static void DisconnectWorker(Worker& worker);
+
+		DistributedRenderSettings m_Settings{};
+
+		int m_ListenSocket{ -1 };
+		std::vector<Worker> m_Workers{};
+		std::vector<int> m_LocalProcessIds{};
+		uint32_t m_FrameIndex{ 0 };
+	};
+
+	//Worker side: connects to the coordinator at "host:port" and renders whatever it asks for until told to stop.
+	//Returns the process exit code
+	int RunRenderWorker(const std::string& coordinatorAddress);
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FLOAT8_SSE
+#include <emmintrin.h>
+#endif
+
+namespace dae
+{
+	//8 floats processed as one value, two SSE registers (or a plain array without SSE).
+	//Meant for passes over the planes of an HdrBuffer, 8 neighbouring pixels of a channel at once
+#if defined(FLOAT8_SSE)
+	struct Float8
+	{
+		__m128 lo;
+		__m128 hi;
+	};
+
+	inline Float8 Load8(const float* pValues) { return { _mm_loadu_ps(pValues), _mm_loadu_ps(pValues + 4) }; }
+	inline void Store8(float* pValues, const Float8& a) { _mm_storeu_ps(pValues, a.lo); _mm_storeu_ps(pValues + 4, a.hi); }
+	inline Float8 Set8(float value) { return { _mm_set1_ps(value), _mm_set1_ps(value) }; }
+
+	inline Float8 operator+(const Float8& a, const Float8& b) { return { _mm_add_ps(a.lo, b.lo), _mm_add_ps(a.hi, b.hi) }; }
+	inline Float8 operator-(const Float8& a, const Float8& b) { return { _mm_sub_ps(a.lo, b.lo), _mm_sub_ps(a.hi, b.hi) }; }
+	inline Float8 operator*(const Float8& a, const Float8& b) { return { _mm_mul_ps(a.lo, b.lo), _mm_mul_ps(a.hi, b.hi) }; }
+	inline Float8 operator/(const Float8& a, const Float8& b) { return { _mm_div_ps(a.lo, b.lo), _mm_div_ps(a.hi, b.hi) }; }
+	inline Float8 Min8(const Float8& a, const Float8& b) { return { _mm_min_ps(a.lo, b.lo), _mm_min_ps(a.hi, b.hi) }; }
+	inline Float8 Max8(const Float8& a, const Float8& b) { return { _mm_max_ps(a.lo, b.lo), _mm_max_ps(a.hi, b.hi) }; }
+	inline Float8 Sqrt8(const Float8& a) { return { _mm_sqrt_ps(a.lo), _mm_sqrt_ps(a.hi) }; }
+
+	//a <= threshold ? ifLess : otherwise, per lane
+	inline Float8 SelectLessEqual8(const Float8& a, float threshold, const Float8& ifLess, const Float8& otherwise)
+	{
+		const __m128 thresholdLanes{ _mm_set1_ps(threshold) };
+		const __m128 maskLo{ _mm_cmple_ps(a.lo, thresholdLanes) };
+		const __m128 maskHi{ _mm_cmple_ps(a.hi, thresholdLanes) };
+		return {
+			_mm_or_ps(_mm_and_ps(maskLo, ifLess.lo), _mm_andnot_ps(maskLo, otherwise.lo)),
+			_mm_or_ps(_mm_and_ps(maskHi, ifLess.hi), _mm_andnot_ps(maskHi, otherwise.hi)) };
+	}
+#else
+	struct Float8
+	{
+		float values[8];
+	};
+
+	template<typename Function>
+	inline Float8 PerLane8(Function function)
+	{
+		Float8 result{};
+		for (int lane{ 0 }; lane < 8; ++lane)
+			result.values[lane] = function(lane);
+		return result;
+	}
+
+	inline Float8 Load8(const float* pValues) { return PerLane8([&](int lane) { return pValues[lane]; }); }
+	inline void Store8(float* pValues, const Float8& a) { for (int lane{ 0 }; lane < 8; ++lane) pValues[lane] = a.values[lane]; }
+	inline Float8 Set8(float value) { return PerLane8([&](int) { return value; }); }
+
+	inline Float8 operator+(const Float8& a, const Float8& b) { return PerLane8([&](int lane) { return a.values[lane] + b.values[lane]; }); }
+	inline Float8 operator-(const Float8& a, const Float8& b) { return PerLane8([&](int lane) { return a.values[lane] - b.values[lane]; }); }
+	inline Float8 operator*(const Float8& a, const Float8& b) { return PerLane8([&](int lane) { return a.values[lane] * b.values[lane]; }); }
+	inline Float8 operator/(const Float8& a, const Float8& b) { return PerLane8([&](int lane) { return a.values[lane] / b.values[lane]; }); }
+	inline Float8 Min8(const Float8& a, const Float8& b) { return PerLane8([&](int lane) { return std::min(a.values[lane], b.values[lane]); }); }
+	inline Float8 Max8(const Float8& a, const Float8& b) { return PerLane8([&](int lane) { return std::max(a.values[lane], b.values[lane]); }); }
+	inline Float8 Sqrt8(const Float8& a) { return PerLane8([&](int lane) { return sqrtf(a.values[lane]); }); }
+
+	inline Float8 SelectLessEqual8(const Float8& a, float threshold, const Float8& ifLess, const Float8& otherwise)
+	{
+		return PerLane8([&](int lane) { return a.values[lane] <= threshold ? ifLess.values[lane] : otherwise.values[lane]; });
+	}
+#endif
+
+	inline Float8 Abs8(const Float8& a) { return Max8(a, Set8(0.f) - a); }
+}
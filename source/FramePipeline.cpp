@@ -0,0 +1,130 @@
+#include "FramePipeline.h"
+#include "Profiler.h"
+#include "Renderer.h"
+
+using namespace dae;
+
+FramePipeline::FramePipeline(Renderer* pRenderer) :
+	m_pRenderer(pRenderer)
+{
+	m_TraceThread = std::thread{ [this] { TraceLoop(); } };
+	m_PresentThread = std::thread{ [this] { PresentLoop(); } };
+}
+
+FramePipeline::~FramePipeline()
+{
+	Flush();
+
+	{
+		const std::lock_guard lock{ m_Mutex };
+		m_IsStopping = true;
+	}
+	m_StateChanged.notify_all();
+
+	m_TraceThread.join();
+	m_PresentThread.join();
+}
+
+void FramePipeline::SubmitFrame(Scene* pScene)
+{
+	{
+		PROFILE_SCOPE("FramePipeline::WaitForTrace");
+
+		std::unique_lock lock{ m_Mutex };
+		WaitShowingFrames(lock, [this] { return m_pTraceScene == nullptr; });
+
+		//The frame buffer of the frame before the previous one, its presentation finished before the previous frame was handed on
+		m_TraceFrameBuffer = (m_TraceFrameBuffer + 1) % Renderer::NUM_FRAME_BUFFERS;
+		m_pTraceScene = pScene;
+		m_FrameStats = m_TracedFrameStats;
+	}
+	m_StateChanged.notify_all();
+}
+
+void FramePipeline::Flush()
+{
+	std::unique_lock lock{ m_Mutex };
+	WaitShowingFrames(lock, [this] { return m_pTraceScene == nullptr && m_PresentFrameBuffer < 0; });
+	m_FrameStats = m_TracedFrameStats;
+}
+
+template<typename Predicate>
+void FramePipeline::WaitShowingFrames(std::unique_lock<std::mutex>& lock, Predicate isDone)
+{
+	while (true)
+	{
+		m_StateChanged.wait(lock, [&] { return m_IsFrameToneMapped || isDone(); });
+
+		if (!m_IsFrameToneMapped)
+			return;
+
+		//The present thread leaves the window surface alone until the frame buffer is released
+		lock.unlock();
+		m_pRenderer->ShowFrame();
+		lock.lock();
+
+		m_IsFrameToneMapped = false;
+		m_PresentFrameBuffer = -1;
+		m_StateChanged.notify_all();
+	}
+}
+
+void FramePipeline::TraceLoop()
+{
+	while (true)
+	{
+		Scene* pScene{};
+		uint32_t frameBuffer{};
+		{
+			std::unique_lock lock{ m_Mutex };
+			m_StateChanged.wait(lock, [this] { return m_IsStopping || m_pTraceScene != nullptr; });
+
+			if (m_pTraceScene == nullptr)
+				return;
+
+			pScene = m_pTraceScene;
+			frameBuffer = m_TraceFrameBuffer;
+		}
+
+		//Profile events are labelled with the frame being traced, the caller's update of the next one included
+		Profiler::Get().BeginFrame();
+		m_pRenderer->TraceFrame(pScene, frameBuffer);
+
+		{
+			//A slow presentation holds back the next trace, never the other way around
+			std::unique_lock lock{ m_Mutex };
+			m_StateChanged.wait(lock, [this] { return m_PresentFrameBuffer < 0; });
+
+			m_PresentFrameBuffer = int(frameBuffer);
+			m_TracedFrameStats = m_pRenderer->GetFrameStats();
+			m_pTraceScene = nullptr;
+		}
+		m_StateChanged.notify_all();
+	}
+}
+
+void FramePipeline::PresentLoop()
+{
+	while (true)
+	{
+		uint32_t frameBuffer{};
+		{
+			std::unique_lock lock{ m_Mutex };
+			m_StateChanged.wait(lock, [this] { return m_IsStopping || m_PresentFrameBuffer >= 0; });
+
+			if (m_PresentFrameBuffer < 0)
+				return;
+
+			frameBuffer = uint32_t(m_PresentFrameBuffer);
+		}
+
+		//Tone maps on this thread alone, the worker pool is busy tracing the next frame
+		m_pRenderer->PresentFrame(frameBuffer, false);
+
+		{
+			const std::lock_guard lock{ m_Mutex };
+			m_IsFrameToneMapped = true;
+		}
+		m_StateChanged.notify_all();
+	}
+}
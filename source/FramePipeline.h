@@ -0,0 +1,71 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+#include "RayStats.h"
+
+namespace dae
+{
+	class Renderer;
+	class Scene;
+
+	/**
+	 * \brief Overlaps the stages of the interactive frame loop: while frame N is traced on a trace thread (and the worker pool),
+	 * the caller updates frame N + 1 in a second scene copy, and the finished frame N - 1 is tone mapped on a present thread.
+	 * The tone mapped frame is shown by the caller, SDL only allows that on the thread that created the window: SubmitFrame and Flush
+	 * show it while they wait. The renderer's two frame buffers alternate between frames, so tracing never writes the buffer being presented.
+	 */
+	class FramePipeline final
+	{
+	public:
+		//The caller alternates between this many scene copies, the scene of the frame being traced is not touched until it's done
+		static constexpr uint32_t NUM_SCENES{ 2 };
+
+		explicit FramePipeline(Renderer* pRenderer);
+		~FramePipeline();
+
+		FramePipeline(const FramePipeline&) = delete;
+		FramePipeline(FramePipeline&&) noexcept = delete;
+		FramePipeline& operator=(const FramePipeline&) = delete;
+		FramePipeline& operator=(FramePipeline&&) noexcept = delete;
+
+		//Waits for the previous frame to finish tracing (it moves on to presentation), then starts tracing pScene.
+		//pScene has to stay untouched until the next SubmitFrame returns. Call it from the thread that created the window
+		void SubmitFrame(Scene* pScene);
+		//Waits until every submitted frame is traced and shown. Needed before reading the renderer's buffers or changing its settings
+		void Flush();
+
+		//Intersection work of the last frame that finished tracing
+		const RayStats& GetFrameStats() const { return m_FrameStats; }
+
+	private:
+		void TraceLoop();
+		void PresentLoop();
+		//Waits until isDone returns true, showing the frames the present thread finishes in the meantime
+		template<typename Predicate>
+		void WaitShowingFrames(std::unique_lock<std::mutex>& lock, Predicate isDone);
+
+		Renderer* m_pRenderer{};
+
+		std::mutex m_Mutex{};
+		std::condition_variable m_StateChanged{};
+
+		//Frame handed to the trace thread, cleared once its trace is done and passed on to the present thread
+		Scene* m_pTraceScene{};
+		uint32_t m_TraceFrameBuffer{ 0 };
+		//Frame buffer waiting for or in presentation, -1 when the present thread is idle
+		int m_PresentFrameBuffer{ -1 };
+		//The present thread tone mapped it, it waits for the caller to show it before it takes the next one
+		bool m_IsFrameToneMapped{ false };
+		bool m_IsStopping{ false };
+
+		//Written by the trace thread, copied for the caller when it collects the frame
+		RayStats m_TracedFrameStats{};
+		RayStats m_FrameStats{};
+
+		std::thread m_TraceThread{};
+		std::thread m_PresentThread{};
+	};
+}
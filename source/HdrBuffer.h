@@ -0,0 +1,49 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+#include "ColorRGB.h"
+
+namespace dae
+{
+	/**
+	 * \brief Linear float radiance, one plane per channel so SIMD passes can load 8 neighbouring pixels of a channel at once.
+	 * Planes are padded up to a multiple of PIXEL_BLOCK_SIZE, the padding pixels are kept black.
+	 */
+	struct HdrBuffer
+	{
+		static constexpr size_t PIXEL_BLOCK_SIZE{ 8 };
+
+		int width{};
+		int height{};
+
+		std::vector<float> red{};
+		std::vector<float> green{};
+		std::vector<float> blue{};
+
+		void Resize(int _width, int _height)
+		{
+			width = _width;
+			height = _height;
+
+			const size_t paddedSize{ (GetPixelCount() + PIXEL_BLOCK_SIZE - 1) / PIXEL_BLOCK_SIZE * PIXEL_BLOCK_SIZE };
+			red.assign(paddedSize, 0.f);
+			green.assign(paddedSize, 0.f);
+			blue.assign(paddedSize, 0.f);
+		}
+
+		size_t GetPixelCount() const { return size_t(width) * height; }
+
+		void SetPixel(size_t pixelIndex, const ColorRGB& color)
+		{
+			red[pixelIndex] = color.r;
+			green[pixelIndex] = color.g;
+			blue[pixelIndex] = color.b;
+		}
+
+		ColorRGB GetPixel(size_t pixelIndex) const
+		{
+			return { red[pixelIndex], green[pixelIndex], blue[pixelIndex] };
+		}
+	};
+}
@@ -0,0 +1,289 @@
+#include "ImageSink.h"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstring>
+
+using namespace dae;
+
+//Both formats store little endian floats, which is what we get by writing memory as is
+static_assert(std::endian::native == std::endian::little, "ImageSink writes raw little endian data");
+
+namespace
+{
+	bool OpenForRandomAccess(std::fstream& file, const std::string& filename)
+	{
+		file.open(filename, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+		return file.is_open();
+	}
+
+	template<typename T>
+	void Append(std::vector<char>& bytes, const T& value)
+	{
+		const char* pBytes{ reinterpret_cast<const char*>(&value) };
+		bytes.insert(bytes.end(), pBytes, pBytes + sizeof(T));
+	}
+
+	void AppendString(std::vector<char>& bytes, const std::string& text)
+	{
+		bytes.insert(bytes.end(), text.begin(), text.end());
+		bytes.push_back('\0');
+	}
+
+	void AppendAttribute(std::vector<char>& bytes, const std::string& name, const std::string& type, const std::vector<char>& value)
+	{
+		AppendString(bytes, name);
+		AppendString(bytes, type);
+		Append(bytes, int32_t(value.size()));
+		bytes.insert(bytes.end(), value.begin(), value.end());
+	}
+}
+
+#pragma region PfmSink
+PfmSink::PfmSink(const std::string& filename) :
+	m_Filename(filename)
+{
+}
+
+bool PfmSink::Begin(int width, int height)
+{
+	m_Width = width;
+	m_Height = height;
+
+	if (!OpenForRandomAccess(m_File, m_Filename))
+		return false;
+
+	//Negative scale = little endian
+	m_File << "PF\n" << width << " " << height << "\n-1.0\n";
+	m_PixelDataOffset = m_File.tellp();
+
+	return m_File.good();
+}
+
+bool PfmSink::WriteTile(const ImageTile& tile)
+{
+	std::vector<float> interleavedRow(size_t(tile.width) * 3);
+
+	const std::lock_guard lock{ m_FileMutex };
+
+	for (int row{ 0 }; row < tile.height; ++row)
+	{
+		const size_t tileRowStart{ row * tile.rowStride };
+		for (int column{ 0 }; column < tile.width; ++column)
+		{
+			interleavedRow[column * 3 + 0] = tile.pRed[tileRowStart + column];
+			interleavedRow[column * 3 + 1] = tile.pGreen[tileRowStart + column];
+			interleavedRow[column * 3 + 2] = tile.pBlue[tileRowStart + column];
+		}
+
+		//PFM stores the bottom row first
+		const int fileRow{ m_Height - 1 - (tile.y + row) };
+		m_File.seekp(m_PixelDataOffset + (std::streamoff(fileRow) * m_Width + tile.x) * 3 * std::streamoff(sizeof(float)));
+		m_File.write(reinterpret_cast<const char*>(interleavedRow.data()), interleavedRow.size() * sizeof(float));
+	}
+
+	return m_File.good();
+}
+
+bool PfmSink::End()
+{
+	m_File.close();
+	return !m_File.fail();
+}
+#pragma endregion
+
+#pragma region ExrSink
+ExrSink::ExrSink(const std::string& filename, ExrLayout layout, int tileSize) :
+	m_Filename(filename),
+	m_Layout(layout),
+	m_TileSize(tileSize)
+{
+}
+
+bool ExrSink::Begin(int width, int height)
+{
+	m_Width = width;
+	m_Height = height;
+
+	if (!OpenForRandomAccess(m_File, m_Filename))
+		return false;
+
+	std::vector<char> header{};
+
+	//Magic number + version 2, bit 9 flags a single part tiled file
+	Append(header, int32_t(20000630));
+	Append(header, int32_t(m_Layout == ExrLayout::Tiled ? 2 | 0x200 : 2));
+
+	//Channels have to be listed alphabetically, the pixel data follows the same order
+	std::vector<char> channels{};
+	for (const char* pName : { "B", "G", "R" })
+	{
+		AppendString(channels, pName);
+		Append(channels, int32_t(2)); //FLOAT
+		Append(channels, int32_t(0)); //pLinear + reserved
+		Append(channels, int32_t(1)); //xSampling
+		Append(channels, int32_t(1)); //ySampling
+	}
+	channels.push_back('\0');
+	AppendAttribute(header, "channels", "chlist", channels);
+
+	AppendAttribute(header, "compression", "compression", { 0 }); //NO_COMPRESSION
+
+	std::vector<char> window{};
+	Append(window, int32_t(0));
+	Append(window, int32_t(0));
+	Append(window, int32_t(width - 1));
+	Append(window, int32_t(height - 1));
+	AppendAttribute(header, "dataWindow", "box2i", window);
+	AppendAttribute(header, "displayWindow", "box2i", window);
+
+	AppendAttribute(header, "lineOrder", "lineOrder", { 0 }); //INCREASING_Y
+
+	std::vector<char> floatOne{};
+	Append(floatOne, 1.f);
+	AppendAttribute(header, "pixelAspectRatio", "float", floatOne);
+
+	std::vector<char> windowCenter{};
+	Append(windowCenter, 0.f);
+	Append(windowCenter, 0.f);
+	AppendAttribute(header, "screenWindowCenter", "v2f", windowCenter);
+	AppendAttribute(header, "screenWindowWidth", "float", floatOne);
+
+	//Chunk sizes are fixed (no compression), so every chunk's position is known up front and
+	//tiles can be written wherever they belong as soon as they're done
+	size_t numChunks{};
+
+	if (m_Layout == ExrLayout::Tiled)
+	{
+		std::vector<char> tileDescription{};
+		Append(tileDescription, uint32_t(m_TileSize));
+		Append(tileDescription, uint32_t(m_TileSize));
+		tileDescription.push_back(0); //ONE_LEVEL, ROUND_DOWN
+		AppendAttribute(header, "tiles", "tiledesc", tileDescription);
+
+		m_NumTilesX = (width + m_TileSize - 1) / m_TileSize;
+		numChunks = size_t(m_NumTilesX) * ((height + m_TileSize - 1) / m_TileSize);
+	}
+	else
+	{
+		numChunks = size_t(height);
+	}
+
+	header.push_back('\0');
+
+	m_ChunkOffsets.resize(numChunks);
+	std::streamoff offset{ std::streamoff(header.size() + numChunks * sizeof(uint64_t)) };
+	for (size_t chunkIndex{ 0 }; chunkIndex < numChunks; ++chunkIndex)
+	{
+		int chunkWidth{ width };
+		int chunkHeight{ 1 };
+		if (m_Layout == ExrLayout::Tiled)
+		{
+			const int tileX{ int(chunkIndex % m_NumTilesX) };
+			const int tileY{ int(chunkIndex / m_NumTilesX) };
+			chunkWidth = std::min(m_TileSize, width - tileX * m_TileSize);
+			chunkHeight = std::min(m_TileSize, height - tileY * m_TileSize);
+		}
+
+		m_ChunkOffsets[chunkIndex] = offset;
+		offset += (m_Layout == ExrLayout::Tiled ? 20 : 8) + std::streamoff(chunkWidth) * chunkHeight * 3 * sizeof(float);
+	}
+
+	m_File.write(header.data(), header.size());
+	for (const std::streamoff chunkOffset : m_ChunkOffsets)
+	{
+		const uint64_t offsetValue{ uint64_t(chunkOffset) };
+		m_File.write(reinterpret_cast<const char*>(&offsetValue), sizeof(offsetValue));
+	}
+
+	//Chunk headers: scanline y or tile coordinates + level, then the data size
+	for (size_t chunkIndex{ 0 }; chunkIndex < numChunks; ++chunkIndex)
+	{
+		std::vector<char> chunkHeader{};
+		const std::streamoff dataOffset{ GetChunkDataOffset(int(chunkIndex)) };
+		const std::streamoff nextOffset{ chunkIndex + 1 < numChunks ? m_ChunkOffsets[chunkIndex + 1] : offset };
+
+		if (m_Layout == ExrLayout::Tiled)
+		{
+			Append(chunkHeader, int32_t(chunkIndex % m_NumTilesX));
+			Append(chunkHeader, int32_t(chunkIndex / m_NumTilesX));
+			Append(chunkHeader, int32_t(0));
+			Append(chunkHeader, int32_t(0));
+		}
+		else
+		{
+			Append(chunkHeader, int32_t(chunkIndex));
+		}
+		Append(chunkHeader, int32_t(nextOffset - dataOffset));
+
+		m_File.seekp(m_ChunkOffsets[chunkIndex]);
+		m_File.write(chunkHeader.data(), chunkHeader.size());
+	}
+
+	return m_File.good();
+}
+
+bool ExrSink::WriteTile(const ImageTile& tile)
+{
+	const float* planes[3]{ tile.pBlue, tile.pGreen, tile.pRed };
+
+	if (m_Layout == ExrLayout::Tiled)
+	{
+		//Tiled files store a tile as one chunk: per line, all blue, then green, then red values
+		assert(tile.x % m_TileSize == 0 && tile.y % m_TileSize == 0);
+		const int chunkIndex{ (tile.y / m_TileSize) * m_NumTilesX + tile.x / m_TileSize };
+		assert(tile.width == std::min(m_TileSize, m_Width - tile.x) && tile.height == std::min(m_TileSize, m_Height - tile.y));
+
+		std::vector<float> chunkData(size_t(tile.width) * tile.height * 3);
+		float* pChunkData{ chunkData.data() };
+		for (int row{ 0 }; row < tile.height; ++row)
+		{
+			for (const float* pPlane : planes)
+			{
+				std::memcpy(pChunkData, pPlane + row * tile.rowStride, tile.width * sizeof(float));
+				pChunkData += tile.width;
+			}
+		}
+
+		const std::lock_guard lock{ m_FileMutex };
+		m_File.seekp(GetChunkDataOffset(chunkIndex));
+		m_File.write(reinterpret_cast<const char*>(chunkData.data()), chunkData.size() * sizeof(float));
+		return m_File.good();
+	}
+
+	//Scanline chunks hold a full row per channel, so a tile row lands in three separate pieces
+	const std::lock_guard lock{ m_FileMutex };
+	for (int row{ 0 }; row < tile.height; ++row)
+	{
+		const std::streamoff rowOffset{ GetChunkDataOffset(tile.y + row) };
+		for (int channel{ 0 }; channel < 3; ++channel)
+		{
+			m_File.seekp(rowOffset + (std::streamoff(channel) * m_Width + tile.x) * std::streamoff(sizeof(float)));
+			m_File.write(reinterpret_cast<const char*>(planes[channel] + row * tile.rowStride), tile.width * sizeof(float));
+		}
+	}
+
+	return m_File.good();
+}
+
+bool ExrSink::End()
+{
+	m_File.close();
+	return !m_File.fail();
+}
+#pragma endregion
+
+std::unique_ptr<ImageSink> dae::CreateImageSink(const std::string& filename, ExrLayout exrLayout, int exrTileSize)
+{
+	const auto hasExtension = [&](const std::string& extension) {
+		return filename.size() >= extension.size() && filename.compare(filename.size() - extension.size(), extension.size(), extension) == 0;
+	};
+
+	if (hasExtension(".pfm"))
+		return std::make_unique<PfmSink>(filename);
+	if (hasExtension(".exr"))
+		return std::make_unique<ExrSink>(filename, exrLayout, exrTileSize);
+
+	return nullptr;
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace dae
+{
+	//A rectangle of linear float RGB pixels, one plane per channel (like HdrBuffer), rows top to bottom
+	struct ImageTile
+	{
+		int x{};
+		int y{};
+		int width{};
+		int height{};
+
+		const float* pRed{};
+		const float* pGreen{};
+		const float* pBlue{};
+		size_t rowStride{}; //In pixels
+	};
+
+	/**
+	 * \brief Receives finished tiles and writes them straight to their place in the output file,
+	 * so no sink ever holds the whole image in memory. Tiles may arrive in any order and from any thread.
+	 */
+	class ImageSink
+	{
+	public:
+		ImageSink() = default;
+		virtual ~ImageSink() = default;
+
+		ImageSink(const ImageSink&) = delete;
+		ImageSink(ImageSink&&) noexcept = delete;
+		ImageSink& operator=(const ImageSink&) = delete;
+		ImageSink& operator=(ImageSink&&) noexcept = delete;
+
+		virtual bool Begin(int width, int height) = 0;
+		virtual bool WriteTile(const ImageTile& tile) = 0;
+		virtual bool End() = 0;
+
+		//Tiles handed to WriteTile have to line up with this grid (0 = any rectangle)
+		virtual int GetRequiredTileSize() const { return 0; }
+	};
+
+	//Portable float map: little endian RGB floats, bottom row first
+	class PfmSink final : public ImageSink
+	{
+	public:
+		explicit PfmSink(const std::string& filename);
+
+		bool Begin(int width, int height) override;
+		bool WriteTile(const ImageTile& tile) override;
+		bool End() override;
+
+	private:
+		std::string m_Filename{};
+		std::fstream m_File{};
+		std::mutex m_FileMutex{};
+		std::streamoff m_PixelDataOffset{};
+
+		int m_Width{};
+		int m_Height{};
+	};
+
+	enum class ExrLayout { Scanline, Tiled };
+
+	//Uncompressed 32 bit float OpenEXR, single part, R/G/B channels
+	class ExrSink final : public ImageSink
+	{
+	public:
+		ExrSink(const std::string& filename, ExrLayout layout, int tileSize = 32);
+
+		bool Begin(int width, int height) override;
+		bool WriteTile(const ImageTile& tile) override;
+		bool End() override;
+
+		int GetRequiredTileSize() const override { return m_Layout == ExrLayout::Tiled ? m_TileSize : 0; }
+
+	private:
+		//File position of the pixel data of a scanline (Scanline) or tile (Tiled)
+		std::streamoff GetChunkDataOffset(int chunkIndex) const { return m_ChunkOffsets[chunkIndex] + (m_Layout == ExrLayout::Tiled ? 20 : 8); }
+
+		std::string m_Filename{};
+		ExrLayout m_Layout{};
+		int m_TileSize{};
+
+		std::fstream m_File{};
+		std::mutex m_FileMutex{};
+		std::vector<std::streamoff> m_ChunkOffsets{};
+
+		int m_Width{};
+		int m_Height{};
+		int m_NumTilesX{};
+	};
+
+	//Picks the sink from the extension: .pfm or .exr, nullptr for anything else
+	std::unique_ptr<ImageSink> CreateImageSink(const std::string& filename, ExrLayout exrLayout = ExrLayout::Scanline, int exrTileSize = 32);
+}
@@ -0,0 +1,271 @@
+#include "LightTree.h"
+#include "MathHelpers.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace dae;
+
+namespace
+{
+	//cos(max(0, a - b)) from the sines and cosines of a and b
+	float CosSubClamped(float sinA, float cosA, float sinB, float cosB)
+	{
+		return cosA > cosB ? 1.f : cosA * cosB + sinA * sinB;
+	}
+
+	//sin(max(0, a - b)) from the sines and cosines of a and b
+	float SinSubClamped(float sinA, float cosA, float sinB, float cosB)
+	{
+		return cosA > cosB ? 0.f : sinA * cosB - cosA * sinB;
+	}
+
+	float SafeSqrt(float value)
+	{
+		return sqrtf(std::max(value, 0.f));
+	}
+
+	float SafeAcos(float value)
+	{
+		return acosf(std::clamp(value, -1.f, 1.f));
+	}
+
+	Vector3 Abs(const Vector3& v)
+	{
+		return { fabsf(v.x), fabsf(v.y), fabsf(v.z) };
+	}
+
+	//Rodrigues' rotation of v around a normalized axis
+	Vector3 Rotate(const Vector3& v, const Vector3& axis, float angle)
+	{
+		const float cosAngle{ cosf(angle) };
+		const float sinAngle{ sinf(angle) };
+		return v * cosAngle + Vector3::Cross(axis, v) * sinAngle + axis * (Vector3::Dot(axis, v) * (1 - cosAngle));
+	}
+}
+
+LightBounds LightBounds::Union(const LightBounds& first, const LightBounds& second)
+{
+	if (first.power <= 0)
+		return second;
+	if (second.power <= 0)
+		return first;
+
+	LightBounds bounds{};
+	bounds.boundsMin = Vector3::Min(first.boundsMin, second.boundsMin);
+	bounds.boundsMax = Vector3::Max(first.boundsMax, second.boundsMax);
+	bounds.cosThetaE = std::min(first.cosThetaE, second.cosThetaE);
+	bounds.power = first.power + second.power;
+	bounds.influenceRadius = first.influenceRadius > 0 && second.influenceRadius > 0 ? std::max(first.influenceRadius, second.influenceRadius) : 0.f;
+
+	//Smallest cone around both emission cones
+	const float thetaFirst{ SafeAcos(first.cosThetaO) };
+	const float thetaSecond{ SafeAcos(second.cosThetaO) };
+	const float thetaBetween{ SafeAcos(Vector3::Dot(first.axis, second.axis)) };
+
+	if (std::min(thetaBetween + thetaSecond, PI) <= thetaFirst)
+	{
+		bounds.axis = first.axis;
+		bounds.cosThetaO = first.cosThetaO;
+		return bounds;
+	}
+	if (std::min(thetaBetween + thetaFirst, PI) <= thetaSecond)
+	{
+		bounds.axis = second.axis;
+		bounds.cosThetaO = second.cosThetaO;
+		return bounds;
+	}
+
+	const float thetaO{ (thetaFirst + thetaBetween + thetaSecond) / 2 };
+	const Vector3 rotationAxis{ Vector3::Cross(first.axis, second.axis) };
+	if (thetaO >= PI || rotationAxis.SqrMagnitude() == 0)
+	{
+		bounds.axis = first.axis;
+		bounds.cosThetaO = -1.f;
+		return bounds;
+	}
+
+	bounds.axis = Rotate(first.axis, rotationAxis.Normalized(), thetaO - thetaFirst);
+	bounds.cosThetaO = cosf(thetaO);
+	return bounds;
+}
+
+float LightBounds::Importance(const Vector3& point, const Vector3& normal) const
+{
+	//None of the lights reach the point when it's further from the bounds than their influence radius
+	if (influenceRadius > 0)
+	{
+		const Vector3 outside{ Vector3::Max(Vector3::Max(boundsMin - point, point - boundsMax), Vector3{}) };
+		if (outside.SqrMagnitude() > influenceRadius * influenceRadius)
+			return 0.f;
+	}
+
+	const Vector3 center{ (boundsMin + boundsMax) * 0.5f };
+	const Vector3 fromCenter{ point - center };
+	const float radiusSqrd{ (boundsMax - boundsMin).SqrMagnitude() * 0.25f };
+
+	//Inside the bounds the distance says nothing, clamp it to the size of the bounds
+	const float sqrDistance{ std::max({ fromCenter.SqrMagnitude(), sqrtf(radiusSqrd), 1e-6f }) };
+	const Vector3 toPoint{ fromCenter / sqrtf(std::max(fromCenter.SqrMagnitude(), 1e-12f)) };
+
+	//Angle the bounds cover seen from the point
+	const float cosThetaB{ fromCenter.SqrMagnitude() > radiusSqrd ? SafeSqrt(1 - radiusSqrd / fromCenter.SqrMagnitude()) : -1.f };
+	const float sinThetaB{ SafeSqrt(1 - cosThetaB * cosThetaB) };
+
+	//Smallest angle between the emission cone and the point, over the whole bounds
+	const float cosThetaW{ Vector3::Dot(axis, toPoint) };
+	const float sinThetaW{ SafeSqrt(1 - cosThetaW * cosThetaW) };
+	const float sinThetaO{ SafeSqrt(1 - cosThetaO * cosThetaO) };
+	const float cosThetaX{ CosSubClamped(sinThetaW, cosThetaW, sinThetaO, cosThetaO) };
+	const float sinThetaX{ SinSubClamped(sinThetaW, cosThetaW, sinThetaO, cosThetaO) };
+	const float cosThetaP{ CosSubClamped(sinThetaX, cosThetaX, sinThetaB, cosThetaB) };
+	if (cosThetaP <= cosThetaE)
+		return 0.f;
+
+	//Smallest angle of incidence on the surface, lights fully behind it get nothing
+	const float cosThetaI{ Vector3::Dot(normal, -toPoint) };
+	const float sinThetaI{ SafeSqrt(1 - cosThetaI * cosThetaI) };
+	const float cosThetaIP{ CosSubClamped(sinThetaI, cosThetaI, sinThetaB, cosThetaB) };
+
+	return std::max(power * cosThetaP * cosThetaIP / sqrDistance, 0.f);
+}
+
+void LightTree::Build(const std::vector<Light>& lights)
+{
+	m_Nodes.clear();
+	m_InfiniteLights.clear();
+
+	std::vector<BuildLight> buildLights{};
+	buildLights.reserve(lights.size());
+
+	for (uint32_t lightIndex{ 0 }; lightIndex < uint32_t(lights.size()); ++lightIndex)
+	{
+		const Light& light{ lights[lightIndex] };
+		if (light.type == LightType::Directional)
+		{
+			m_InfiniteLights.push_back(lightIndex);
+			continue;
+		}
+
+		BuildLight buildLight{};
+		buildLight.bounds.boundsMin = light.origin;
+		buildLight.bounds.boundsMax = light.origin;
+		buildLight.bounds.power = light.intensity * (light.color.r + light.color.g + light.color.b) / 3;
+		buildLight.bounds.influenceRadius = light.influenceRadius;
+		buildLight.centroid = light.origin;
+
+		//Rects and disks emit around their normal and fade out towards their plane, spheres shine everywhere like points
+		if (light.type == LightType::Rect)
+		{
+			const Vector3 cornerExtent{ Vector3::Max(Abs(light.edgeU + light.edgeV), Abs(light.edgeU - light.edgeV)) };
+			buildLight.bounds.boundsMin = light.origin - cornerExtent;
+			buildLight.bounds.boundsMax = light.origin + cornerExtent;
+			buildLight.bounds.axis = light.direction;
+			buildLight.bounds.cosThetaO = 1.f;
+		}
+		else if (light.type == LightType::Disk)
+		{
+			const Vector3& normal{ light.direction };
+			const Vector3 diskExtent{ Vector3{ SafeSqrt(1 - normal.x * normal.x), SafeSqrt(1 - normal.y * normal.y), SafeSqrt(1 - normal.z * normal.z) } * light.radius };
+			buildLight.bounds.boundsMin = light.origin - diskExtent;
+			buildLight.bounds.boundsMax = light.origin + diskExtent;
+			buildLight.bounds.axis = normal;
+			buildLight.bounds.cosThetaO = 1.f;
+		}
+		else if (light.type == LightType::Sphere)
+		{
+			const Vector3 sphereExtent{ light.radius, light.radius, light.radius };
+			buildLight.bounds.boundsMin = light.origin - sphereExtent;
+			buildLight.bounds.boundsMax = light.origin + sphereExtent;
+		}
+		buildLight.lightIndex = lightIndex;
+
+		//Lights without power never contribute, and would make a node look empty
+		if (buildLight.bounds.power > 0)
+			buildLights.push_back(buildLight);
+	}
+
+	if (buildLights.empty())
+		return;
+
+	m_Nodes.reserve(2 * buildLights.size() - 1);
+	BuildNode(buildLights, 0, buildLights.size());
+}
+
+uint32_t LightTree::BuildNode(std::vector<BuildLight>& buildLights, size_t begin, size_t end)
+{
+	const uint32_t nodeIndex{ uint32_t(m_Nodes.size()) };
+	m_Nodes.emplace_back();
+
+	if (end - begin == 1)
+	{
+		m_Nodes[nodeIndex].bounds = buildLights[begin].bounds;
+		m_Nodes[nodeIndex].secondChildOrLight = buildLights[begin].lightIndex;
+		m_Nodes[nodeIndex].isLeaf = true;
+		return nodeIndex;
+	}
+
+	//Median split along the widest axis of the light centroids
+	Vector3 centroidMin{ buildLights[begin].centroid };
+	Vector3 centroidMax{ buildLights[begin].centroid };
+	for (size_t lightIdx{ begin + 1 }; lightIdx < end; ++lightIdx)
+	{
+		centroidMin = Vector3::Min(centroidMin, buildLights[lightIdx].centroid);
+		centroidMax = Vector3::Max(centroidMax, buildLights[lightIdx].centroid);
+	}
+
+	const Vector3 extent{ centroidMax - centroidMin };
+	const int splitAxis{ extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2) };
+	const size_t middle{ begin + (end - begin) / 2 };
+	std::nth_element(buildLights.begin() + begin, buildLights.begin() + middle, buildLights.begin() + end,
+		[splitAxis](const BuildLight& first, const BuildLight& second) { return first.centroid[splitAxis] < second.centroid[splitAxis]; });
+
+	const uint32_t firstChild{ BuildNode(buildLights, begin, middle) };
+	const uint32_t secondChild{ BuildNode(buildLights, middle, end) };
+
+	m_Nodes[nodeIndex].bounds = LightBounds::Union(m_Nodes[firstChild].bounds, m_Nodes[secondChild].bounds);
+	m_Nodes[nodeIndex].secondChildOrLight = secondChild;
+	return nodeIndex;
+}
+
+bool LightTree::Sample(const Vector3& point, const Vector3& normal, float u, uint32_t& lightIndex, float& pmf) const
+{
+	if (m_Nodes.empty())
+		return false;
+
+	uint32_t nodeIndex{ 0 };
+	pmf = 1.f;
+
+	//Importance of the root decides whether anything can be reached at all, below it only the ratios matter
+	if (m_Nodes[0].bounds.Importance(point, normal) <= 0)
+		return false;
+
+	while (!m_Nodes[nodeIndex].isLeaf)
+	{
+		const uint32_t firstChild{ nodeIndex + 1 };
+		const uint32_t secondChild{ m_Nodes[nodeIndex].secondChildOrLight };
+		const float firstImportance{ m_Nodes[firstChild].bounds.Importance(point, normal) };
+		const float secondImportance{ m_Nodes[secondChild].bounds.Importance(point, normal) };
+
+		if (firstImportance + secondImportance <= 0)
+			return false;
+
+		//u is reused for every level, rescaled to [0, 1) within the chosen child's share
+		const float firstProbability{ firstImportance / (firstImportance + secondImportance) };
+		if (u < firstProbability)
+		{
+			nodeIndex = firstChild;
+			pmf *= firstProbability;
+			u = std::min(u / firstProbability, 0x1.fffffep-1f);
+		}
+		else
+		{
+			nodeIndex = secondChild;
+			pmf *= 1 - firstProbability;
+			u = std::min((u - firstProbability) / (1 - firstProbability), 0x1.fffffep-1f);
+		}
+	}
+
+	lightIndex = m_Nodes[nodeIndex].secondChildOrLight;
+	return pmf > 0;
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "DataTypes.h"
+
+namespace dae
+{
+	/**
+	 * \brief Where a light or a group of lights is and where it shines to, with their summed power.
+	 * Emission lies within the cone (axis, thetaO) and fades out over another thetaE beyond it. Point lights shine everywhere (thetaO = PI), rects and disks fade out towards their plane (thetaO = 0, thetaE = PI / 2)
+	 */
+	struct LightBounds
+	{
+		Vector3 boundsMin{};
+		Vector3 boundsMax{};
+		Vector3 axis{ Vector3::UnitZ };
+		float cosThetaO{ -1.f };
+		float cosThetaE{ 0.f };
+		float power{};
+		//Largest influence radius of the lights, 0 when one of them reaches everywhere
+		float influenceRadius{};
+
+		static LightBounds Union(const LightBounds& first, const LightBounds& second);
+
+		//Conservative estimate of how much these lights contribute to a surface at point with normal, 0 when they can't reach it at all
+		float Importance(const Vector3& point, const Vector3& normal) const;
+	};
+
+	/**
+	 * \brief Light BVH for many-light sampling (Conty Estevez and Kulla 2018). Every node bounds its lights in space and direction,
+	 * a sample walks down from the root picking children in proportion to their importance for the shading point,
+	 * so lights that are far away, dim, facing away or behind the surface are rarely picked.
+	 * Directional lights have no position, they're kept aside and always shaded.
+	 */
+	class LightTree final
+	{
+	public:
+		//Up to this many lights every light is shaded, above it NUM_LIGHT_SAMPLES are drawn from the tree per shading point
+		static constexpr uint32_t SAMPLING_THRESHOLD{ 16 };
+		static constexpr uint32_t NUM_LIGHT_SAMPLES{ 4 };
+
+		LightTree() = default;
+		~LightTree() = default;
+
+		LightTree(const LightTree&) = delete;
+		LightTree(LightTree&&) noexcept = delete;
+		LightTree& operator=(const LightTree&) = delete;
+		LightTree& operator=(LightTree&&) noexcept = delete;
+
+		void Build(const std::vector<Light>& lights);
+
+		//Picks one light (index into the scene's lights) for a surface at point with normal. pmf is the probability it was picked with.
+		//Returns false when no light in the tree can reach the point
+		bool Sample(const Vector3& point, const Vector3& normal, float u, uint32_t& lightIndex, float& pmf) const;
+
+		//Indices of the lights that aren't in the tree
+		const std::vector<uint32_t>& GetInfiniteLights() const { return m_InfiniteLights; }
+
+	private:
+		//Depth first: the first child directly follows its parent
+		struct Node
+		{
+			LightBounds bounds{};
+			uint32_t secondChildOrLight{}; //Light index for leaves
+			bool isLeaf{ false };
+		};
+
+		struct BuildLight
+		{
+			LightBounds bounds{};
+			Vector3 centroid{};
+			uint32_t lightIndex{};
+		};
+
+		uint32_t BuildNode(std::vector<BuildLight>& buildLights, size_t begin, size_t end);
+
+		std::vector<Node> m_Nodes{};
+		std::vector<uint32_t> m_InfiniteLights{};
+	};
+}
@@ -25,6 +25,29 @@ namespace dae
 		 * \return color
 		 */
 		virtual ColorRGB Shade(const HitRecord& hitRecord = {}, const Vector3& l = {}, const Vector3& v = {}) = 0;
+
+		/**
+		 * \brief Importance samples the direction light arrives from, so the path tracer follows the lobes of Shade.
+		 * Cosine weighted by default, which fits the diffuse materials
+		 * \param hitRecord current hitrecord
+		 * \param v view direction from hitpoint to viewer
+		 * \param u1 uniform random number in [0, 1)
+		 * \param u2 uniform random number in [0, 1)
+		 * \param u3 uniform random number in [0, 1), picks the lobe for materials with more than one
+		 * \param l sampled light direction from hitpoint
+		 * \return probability density of l (per solid angle)
+		 */
+		virtual float Sample(const HitRecord& hitRecord, const Vector3& v, float u1, float u2, float u3, Vector3& l)
+		{
+			l = BRDF::Sample_Lambert(hitRecord.normal, u1, u2);
+			return BRDF::Pdf_Lambert(hitRecord.normal, l);
+		}
+
+		/**
+		 * \brief Base color of the surface, what the lighting gets multiplied with.
+		 * The denoiser divides it out, so it only smooths the lighting and keeps the material's edges sharp
+		 */
+		virtual ColorRGB GetAlbedo() const { return colors::White; }
 	};
 #pragma endregion
 
@@ -43,6 +66,8 @@ namespace dae
 			return m_Color;
 		}
 
+		ColorRGB GetAlbedo() const override { return m_Color; }
+
 	private:
 		ColorRGB m_Color{colors::White};
 	};
@@ -62,6 +87,8 @@ namespace dae
 			return BRDF::Lambert(m_DiffuseReflectance, m_DiffuseColor);
 		}
 
+		ColorRGB GetAlbedo() const override { return m_DiffuseColor * m_DiffuseReflectance; }
+
 	private:
 		ColorRGB m_DiffuseColor{colors::White};
 		float m_DiffuseReflectance{1.f}; //kd
@@ -85,6 +112,8 @@ namespace dae
 			return BRDF::Lambert(m_DiffuseReflectance, m_DiffuseColor) + BRDF::Phong(m_SpecularReflectance, m_PhongExponent, l, -v, hitRecord.normal);
 		}
 
+		ColorRGB GetAlbedo() const override { return m_DiffuseColor * m_DiffuseReflectance; }
+
 	private:
 		ColorRGB m_DiffuseColor{colors::White};
 		float m_DiffuseReflectance{0.5f}; //kd
@@ -106,8 +135,9 @@ namespace dae
 		// L from hitpoint to light, v from hitpoint to viewer
 		ColorRGB Shade(const HitRecord& hitRecord = {}, const Vector3& l = {}, const Vector3& v = {}) override
 		{
-			ColorRGB f0{};
-			f0 = (m_Metalness == 0) ? ColorRGB{0.04f, 0.04f, 0.04f} : m_Albedo;
+			//Metals tint their reflection and have no diffuse lobe, blended by metalness like GetSpecularProbability
+			const float metalness{ std::clamp(m_Metalness, 0.f, 1.f) };
+			ColorRGB f0{ ColorRGB::Lerp(ColorRGB{ 0.04f, 0.04f, 0.04f }, m_Albedo, metalness) };
 			Vector3 halfVector{ (v + l) / (v + l).Magnitude() };
 			ColorRGB Fresnel{ BRDF::FresnelFunction_Schlick(halfVector,v,f0) };
 			float Distribution{ BRDF::NormalDistribution_GGX(hitRecord.normal,halfVector,m_Roughness) };
@@ -115,17 +145,41 @@ namespace dae
 			float inversDenominator{ 1 / (4 * Vector3::Dot(v,hitRecord.normal) * Vector3::Dot(l,hitRecord.normal)) };
 
 			ColorRGB CookTorrance{ Distribution * Fresnel * Geometry * inversDenominator };
-			ColorRGB kd{};
-			kd = (m_Metalness == 0) ? (ColorRGB{ 1,1,1 } - Fresnel) : ColorRGB{ 0,0,0 };
+			ColorRGB kd{ (ColorRGB{ 1,1,1 } - Fresnel) * (1 - metalness) };
 			ColorRGB diffuse{ BRDF::Lambert(kd,m_Albedo) };
 
 			return diffuse + CookTorrance;
 		}
 
+		//GGX lobe or cosine lobe, the probability density is the one of the mix
+		float Sample(const HitRecord& hitRecord, const Vector3& v, float u1, float u2, float u3, Vector3& l) override
+		{
+			const float specularProbability{ GetSpecularProbability(hitRecord.normal, v) };
+
+			if (u3 < specularProbability)
+				l = BRDF::Sample_GGX(hitRecord.normal, v, m_Roughness, u1, u2);
+			else
+				l = BRDF::Sample_Lambert(hitRecord.normal, u1, u2);
+
+			return specularProbability * BRDF::Pdf_GGX(hitRecord.normal, v, l, m_Roughness)
+				+ (1 - specularProbability) * BRDF::Pdf_Lambert(hitRecord.normal, l);
+		}
+
+		ColorRGB GetAlbedo() const override { return m_Albedo; }
+
 	private:
 		ColorRGB m_Albedo{0.955f, 0.637f, 0.538f}; //Copper
 		float m_Metalness{1.0f};
 		float m_Roughness{0.1f}; // [1.0 > 0.0] >> [ROUGH > SMOOTH]
+
+		//Dielectrics reflect about as much specularly as the Fresnel term at the view angle says, metals have no diffuse lobe.
+		//Blended by metalness in between
+		float GetSpecularProbability(const Vector3& n, const Vector3& v) const
+		{
+			const ColorRGB fresnel{ BRDF::FresnelFunction_Schlick(n, v, ColorRGB{ 0.04f, 0.04f, 0.04f }) };
+			const float dielectricProbability{ std::clamp((fresnel.r + fresnel.g + fresnel.b) / 3, 0.25f, 0.9f) };
+			return Lerpf(dielectricProbability, 1.f, std::clamp(m_Metalness, 0.f, 1.f));
+		}
 	};
 #pragma endregion
 }
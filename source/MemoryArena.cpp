@@ -0,0 +1,90 @@
+#include "MemoryArena.h"
+
+#include <algorithm>
+
+using namespace dae;
+
+#pragma region MemoryArena
+MemoryArena::MemoryArena(size_t blockSize) :
+	m_BlockSize(blockSize)
+{
+}
+
+MemoryArena::~MemoryArena()
+{
+	for (Block& block : m_Blocks)
+	{
+		::operator delete(block.pData, std::align_val_t{ alignof(std::max_align_t) });
+		block.pData = nullptr;
+	}
+
+	m_Blocks.clear();
+}
+
+void* MemoryArena::AllocateSlow(size_t size, size_t alignment)
+{
+	//Try the blocks that are still left from before the last Reset
+	while (++m_CurrentBlock < m_Blocks.size())
+	{
+		m_Offset = 0;
+		if (size + alignment <= m_Blocks[m_CurrentBlock].size)
+			return Allocate(size, alignment);
+	}
+
+	//Out of blocks, grab a new one (big requests get a block of their own size)
+	Block block{};
+	block.size = std::max(m_BlockSize, size + alignment);
+	block.pData = static_cast<std::byte*>(::operator new(block.size, std::align_val_t{ alignof(std::max_align_t) }));
+
+	m_Blocks.push_back(block);
+	m_CurrentBlock = m_Blocks.size() - 1;
+	m_Offset = 0;
+
+	return Allocate(size, alignment);
+}
+
+void MemoryArena::Reset()
+{
+	m_CurrentBlock = 0;
+	m_Offset = 0;
+}
+
+size_t MemoryArena::GetBytesUsed() const
+{
+	size_t bytesUsed{ m_Offset };
+	for (size_t blockIdx{ 0 }; blockIdx < m_CurrentBlock && blockIdx < m_Blocks.size(); ++blockIdx)
+	{
+		bytesUsed += m_Blocks[blockIdx].size;
+	}
+
+	return bytesUsed;
+}
+
+size_t MemoryArena::GetBytesReserved() const
+{
+	size_t bytesReserved{ 0 };
+	for (const Block& block : m_Blocks)
+	{
+		bytesReserved += block.size;
+	}
+
+	return bytesReserved;
+}
+#pragma endregion
+
+#pragma region ScratchArenas
+ScratchArenas::ScratchArenas(size_t blockSize) :
+	m_Arenas(MAX_THREAD_SLOTS),
+	m_BlockSize(blockSize)
+{
+}
+
+void ScratchArenas::ResetAll()
+{
+	for (std::unique_ptr<MemoryArena>& pArena : m_Arenas)
+	{
+		if (pArena)
+			pArena->Reset();
+	}
+}
+#pragma endregion
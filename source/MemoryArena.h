@@ -0,0 +1,109 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include "Threading.h"
+
+namespace dae
+{
+	/**
+	 * \brief Bump allocator. Memory is handed out linearly from large blocks and is only
+	 * given back all at once through Reset() (O(1), blocks are kept for reuse) or on destruction.
+	 * Destructors of objects created with New are NOT called by the arena.
+	 */
+	class MemoryArena final
+	{
+	public:
+		explicit MemoryArena(size_t blockSize = 64 * 1024);
+		~MemoryArena();
+
+		MemoryArena(const MemoryArena&) = delete;
+		MemoryArena(MemoryArena&&) noexcept = delete;
+		MemoryArena& operator=(const MemoryArena&) = delete;
+		MemoryArena& operator=(MemoryArena&&) noexcept = delete;
+
+		void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t))
+		{
+			if (m_CurrentBlock < m_Blocks.size())
+			{
+				const Block& block{ m_Blocks[m_CurrentBlock] };
+				const size_t alignedOffset{ (m_Offset + alignment - 1) & ~(alignment - 1) };
+				if (alignedOffset + size <= block.size)
+				{
+					m_Offset = alignedOffset + size;
+					return block.pData + alignedOffset;
+				}
+			}
+
+			return AllocateSlow(size, alignment);
+		}
+
+		template<typename T, typename... Args>
+		T* New(Args&&... args)
+		{
+			return new (Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+		}
+
+		//Uninitialized storage for count elements, only meant for trivially destructible types
+		template<typename T>
+		T* NewArray(size_t count)
+		{
+			return static_cast<T*>(Allocate(sizeof(T) * count, alignof(T)));
+		}
+
+		void Reset();
+
+		size_t GetBytesUsed() const;
+		size_t GetBytesReserved() const;
+
+	private:
+		struct Block
+		{
+			std::byte* pData{};
+			size_t size{};
+		};
+
+		void* AllocateSlow(size_t size, size_t alignment);
+
+		std::vector<Block> m_Blocks{};
+		size_t m_CurrentBlock{ 0 };
+		size_t m_Offset{ 0 };
+		size_t m_BlockSize{};
+	};
+
+	/**
+	 * \brief One MemoryArena per thread for scratch data (tile buffers, ...).
+	 * Each thread only ever touches its own arena, so allocating is lock-free.
+	 * ResetAll() must be called while no thread allocates from it, a thread may also reset only its own arena.
+	 */
+	class ScratchArenas final
+	{
+	public:
+		explicit ScratchArenas(size_t blockSize = 256 * 1024);
+		~ScratchArenas() = default;
+
+		ScratchArenas(const ScratchArenas&) = delete;
+		ScratchArenas(ScratchArenas&&) noexcept = delete;
+		ScratchArenas& operator=(const ScratchArenas&) = delete;
+		ScratchArenas& operator=(ScratchArenas&&) noexcept = delete;
+
+		MemoryArena& Local()
+		{
+			std::unique_ptr<MemoryArena>& pArena{ m_Arenas[GetThreadSlot()] };
+			if (!pArena)
+				pArena = std::make_unique<MemoryArena>(m_BlockSize);
+
+			return *pArena;
+		}
+
+		void ResetAll();
+
+	private:
+		std::vector<std::unique_ptr<MemoryArena>> m_Arenas{};
+		size_t m_BlockSize{};
+	};
+}
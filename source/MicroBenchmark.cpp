@@ -0,0 +1,362 @@
+//Standalone microbenchmarks for the intersection and shading kernels (no SDL, no window)
+//Usage: MicroBenchmark [--calls n]
+
+//Standard includes
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+//Project includes
+#include "Math.h"
+#include "DataTypes.h"
+#include "Material.h"
+#include "Utils.h"
+
+using namespace dae;
+
+namespace
+{
+	//Fraction of rays that are built to hit their primitive
+	const float g_HitMixes[]{ 0.f, 0.5f, 1.f };
+
+	std::mt19937 g_RandomEngine{ 1337 };
+
+	float RandomFloat(float min, float max)
+	{
+		return std::uniform_real_distribution<float>{ min, max }(g_RandomEngine);
+	}
+
+	bool RandomChance(float probability)
+	{
+		return RandomFloat(0.f, 1.f) < probability;
+	}
+
+	Vector3 RandomVector(float min, float max)
+	{
+		return { RandomFloat(min, max), RandomFloat(min, max), RandomFloat(min, max) };
+	}
+
+	Vector3 RandomDirection()
+	{
+		Vector3 direction{};
+		do {
+			direction = RandomVector(-1.f, 1.f);
+		} while (direction.SqrMagnitude() > 1.f || direction.SqrMagnitude() < 0.0001f);
+
+		return direction.Normalized();
+	}
+
+	//Any unit vector perpendicular to v
+	Vector3 Perpendicular(const Vector3& v)
+	{
+		const Vector3 helper{ std::abs(v.x) < 0.9f ? Vector3::UnitX : Vector3::UnitY };
+		return Vector3::Cross(v, helper).Normalized();
+	}
+
+	Ray MakeRay(const Vector3& origin, const Vector3& target)
+	{
+		Ray ray{};
+		ray.origin = origin;
+		ray.direction = (target - origin).Normalized();
+		return ray;
+	}
+
+	//Keeps results alive so the measured calls can't be optimized away
+	volatile uint64_t g_Sink{ 0 };
+
+	/**
+	 * \brief Calls func(index) numCalls times per run, best of a few runs
+	 * \return nanoseconds per call
+	 */
+	template<typename Func>
+	double MeasureNsPerCall(size_t numCalls, Func&& func)
+	{
+		constexpr int numRuns{ 5 };
+		double bestNs{ DBL_MAX };
+
+		for (int run{ 0 }; run < numRuns; ++run)
+		{
+			uint64_t hits{ 0 };
+			const auto start{ std::chrono::steady_clock::now() };
+
+			for (size_t index{ 0 }; index < numCalls; ++index)
+			{
+				hits += func(index);
+			}
+
+			const auto end{ std::chrono::steady_clock::now() };
+			g_Sink = g_Sink + hits;
+
+			bestNs = std::min(bestNs, std::chrono::duration<double, std::nano>(end - start).count() / numCalls);
+		}
+
+		return bestNs;
+	}
+
+	void PrintHeader()
+	{
+		std::cout << std::left << std::setw(40) << "Kernel"
+			<< std::right << std::setw(10) << "Hit mix"
+			<< std::setw(12) << "ns/call"
+			<< std::setw(10) << "Hit %" << "\n"
+			<< std::string(72, '-') << "\n";
+	}
+
+	void PrintResult(const std::string& name, float hitMix, double nsPerCall, double hitRate)
+	{
+		std::cout << std::left << std::setw(40) << name
+			<< std::right << std::fixed << std::setprecision(2)
+			<< std::setw(10) << hitMix * 100.f
+			<< std::setw(12) << nsPerCall
+			<< std::setw(10) << hitRate * 100.0 << "\n";
+	}
+
+	//Counts how many of the rays actually hit, to validate the generated mix
+	template<typename Func>
+	double MeasureHitRate(size_t numCalls, Func&& func)
+	{
+		uint64_t hits{ 0 };
+		for (size_t index{ 0 }; index < numCalls; ++index)
+		{
+			hits += func(index);
+		}
+
+		return double(hits) / numCalls;
+	}
+
+#pragma region Spheres
+	void BenchmarkSpheres(size_t numCalls)
+	{
+		for (const float hitMix : g_HitMixes)
+		{
+			std::vector<Sphere> spheres(numCalls);
+			std::vector<Ray> rays(numCalls);
+
+			for (size_t index{ 0 }; index < numCalls; ++index)
+			{
+				Sphere& sphere{ spheres[index] };
+				sphere.origin = RandomVector(-10.f, 10.f);
+				sphere.radius = RandomFloat(0.25f, 2.f);
+
+				const Vector3 origin{ sphere.origin + RandomDirection() * RandomFloat(5.f, 20.f) };
+				const Vector3 toCenter{ (sphere.origin - origin).Normalized() };
+
+				//Hits aim inside the silhouette, misses just outside of it
+				const float offset{ RandomChance(hitMix) ? RandomFloat(0.f, 0.9f) : RandomFloat(1.1f, 3.f) };
+				rays[index] = MakeRay(origin, sphere.origin + Perpendicular(toCenter) * sphere.radius * offset);
+			}
+
+			HitRecord hitRecord{};
+			const auto analytic = [&](size_t index) { return GeometryUtils::HitTest_Sphere_Analytic(spheres[index], rays[index], hitRecord); };
+			const auto geometric = [&](size_t index) { return GeometryUtils::HitTest_Sphere_Geometric(spheres[index], rays[index], hitRecord); };
+			const auto geometricShadow = [&](size_t index) { return GeometryUtils::HitTest_Sphere_Geometric(spheres[index], rays[index], hitRecord, true); };
+
+			PrintResult("HitTest_Sphere_Analytic", hitMix, MeasureNsPerCall(numCalls, analytic), MeasureHitRate(numCalls, analytic));
+			PrintResult("HitTest_Sphere_Geometric", hitMix, MeasureNsPerCall(numCalls, geometric), MeasureHitRate(numCalls, geometric));
+			PrintResult("HitTest_Sphere_Geometric (shadow)", hitMix, MeasureNsPerCall(numCalls, geometricShadow), MeasureHitRate(numCalls, geometricShadow));
+		}
+	}
+#pragma endregion
+
+#pragma region Planes
+	void BenchmarkPlanes(size_t numCalls)
+	{
+		for (const float hitMix : g_HitMixes)
+		{
+			std::vector<Plane> planes(numCalls);
+			std::vector<Ray> rays(numCalls);
+
+			for (size_t index{ 0 }; index < numCalls; ++index)
+			{
+				Plane& plane{ planes[index] };
+				plane.origin = RandomVector(-10.f, 10.f);
+				plane.normal = RandomDirection();
+
+				//Rays start in front of the plane and either face it or point away from it
+				const Vector3 origin{ plane.origin + plane.normal * RandomFloat(1.f, 10.f) + Perpendicular(plane.normal) * RandomFloat(-5.f, 5.f) };
+				Vector3 direction{ RandomDirection() };
+				const bool isFacingPlane{ Vector3::Dot(direction, plane.normal) < 0.f };
+				if (isFacingPlane != RandomChance(hitMix))
+					direction = -direction;
+
+				rays[index] = Ray{ origin, direction };
+			}
+
+			HitRecord hitRecord{};
+			const auto plane = [&](size_t index) { return GeometryUtils::HitTest_Plane(planes[index], rays[index], hitRecord); };
+
+			PrintResult("HitTest_Plane", hitMix, MeasureNsPerCall(numCalls, plane), MeasureHitRate(numCalls, plane));
+		}
+	}
+#pragma endregion
+
+#pragma region Triangles
+	void BenchmarkTriangles(size_t numCalls)
+	{
+		for (const float hitMix : g_HitMixes)
+		{
+			std::vector<Triangle> triangles(numCalls);
+			std::vector<Ray> rays(numCalls);
+
+			for (size_t index{ 0 }; index < numCalls; ++index)
+			{
+				const Vector3 center{ RandomVector(-10.f, 10.f) };
+				Triangle triangle{ center + RandomVector(-1.f, 1.f), center + RandomVector(-1.f, 1.f), center + RandomVector(-1.f, 1.f) };
+				triangle.cullMode = TriangleCullMode::NoCulling;
+				triangles[index] = triangle;
+
+				//Hits aim at a point with positive barycentrics, misses push one barycentric below zero
+				float baryU{ RandomFloat(0.05f, 0.9f) };
+				float baryV{ RandomFloat(0.05f, 0.95f - baryU) };
+				if (!RandomChance(hitMix))
+					baryU = -RandomFloat(0.1f, 1.f);
+
+				const Vector3 target{ triangle.v0 + (triangle.v1 - triangle.v0) * baryU + (triangle.v2 - triangle.v0) * baryV };
+				const Vector3 origin{ target + triangle.normal * RandomFloat(2.f, 10.f) * (RandomChance(0.5f) ? 1.f : -1.f) + RandomVector(-1.f, 1.f) };
+				rays[index] = MakeRay(origin, target);
+			}
+
+			HitRecord hitRecord{};
+			const auto naive = [&](size_t index) { return GeometryUtils::HitTest_Triangle_Naive(triangles[index], rays[index], hitRecord); };
+			const auto mollerTrumbore = [&](size_t index) { return GeometryUtils::HitTest_Triangle_MT(triangles[index], rays[index], hitRecord); };
+
+			PrintResult("HitTest_Triangle_Naive", hitMix, MeasureNsPerCall(numCalls, naive), MeasureHitRate(numCalls, naive));
+			PrintResult("HitTest_Triangle_MT", hitMix, MeasureNsPerCall(numCalls, mollerTrumbore), MeasureHitRate(numCalls, mollerTrumbore));
+		}
+	}
+
+	void BenchmarkSlabTests(size_t numCalls)
+	{
+		for (const float hitMix : g_HitMixes)
+		{
+			std::vector<TriangleMesh> meshes(std::min<size_t>(numCalls, 1024));
+			for (TriangleMesh& mesh : meshes)
+			{
+				mesh.transformedMinAABB = RandomVector(-10.f, 10.f);
+				mesh.transformedMaxAABB = mesh.transformedMinAABB + RandomVector(0.5f, 3.f);
+			}
+
+			std::vector<Ray> rays(numCalls);
+			for (size_t index{ 0 }; index < numCalls; ++index)
+			{
+				const TriangleMesh& mesh{ meshes[index % meshes.size()] };
+				const Vector3 center{ (mesh.transformedMinAABB + mesh.transformedMaxAABB) * 0.5f };
+				const Vector3 halfExtent{ (mesh.transformedMaxAABB - mesh.transformedMinAABB) * 0.5f };
+
+				//Hits aim inside the box, misses aim past one of its faces
+				Vector3 target{ center + Vector3{ halfExtent.x * RandomFloat(-0.9f, 0.9f), halfExtent.y * RandomFloat(-0.9f, 0.9f), halfExtent.z * RandomFloat(-0.9f, 0.9f) } };
+				const Vector3 origin{ center + RandomDirection() * RandomFloat(10.f, 20.f) };
+				if (!RandomChance(hitMix))
+				{
+					const Vector3 toCenter{ (center - origin).Normalized() };
+					target = center + Perpendicular(toCenter) * halfExtent.Magnitude() * RandomFloat(1.1f, 2.f);
+				}
+
+				rays[index] = MakeRay(origin, target);
+			}
+
+			const auto slab = [&](size_t index) { return GeometryUtils::SlabTest_TriangleMesh(meshes[index % meshes.size()], rays[index]); };
+
+			PrintResult("SlabTest_TriangleMesh", hitMix, MeasureNsPerCall(numCalls, slab), MeasureHitRate(numCalls, slab));
+		}
+	}
+#pragma endregion
+
+#pragma region Shading
+	struct ShadingSample
+	{
+		HitRecord hitRecord{};
+		Vector3 l{};
+		Vector3 v{};
+	};
+
+	void BenchmarkShading(size_t numCalls)
+	{
+		//Normal, light and view direction in the same hemisphere, like the renderer's shading points
+		std::vector<ShadingSample> samples(numCalls);
+		for (ShadingSample& sample : samples)
+		{
+			sample.hitRecord.normal = RandomDirection();
+			sample.l = RandomDirection();
+			sample.v = RandomDirection();
+			if (Vector3::Dot(sample.l, sample.hitRecord.normal) < 0.f) sample.l = -sample.l;
+			if (Vector3::Dot(sample.v, sample.hitRecord.normal) < 0.f) sample.v = -sample.v;
+		}
+
+		// Materials
+		const std::pair<std::string, std::unique_ptr<Material>> materials[]{
+			{ "Material_SolidColor::Shade", std::make_unique<Material_SolidColor>(colors::Red) },
+			{ "Material_Lambert::Shade", std::make_unique<Material_Lambert>(colors::White, 1.f) },
+			{ "Material_LambertPhong::Shade", std::make_unique<Material_LambertPhong>(colors::Blue, 0.5f, 0.5f, 60.f) },
+			{ "Material_CookTorrence::Shade (metal)", std::make_unique<Material_CookTorrence>(ColorRGB{ 0.972f,0.96f,0.915f }, 1.f, 0.6f) },
+			{ "Material_CookTorrence::Shade (plastic)", std::make_unique<Material_CookTorrence>(ColorRGB{ 0.75f,0.75f,0.75f }, 0.f, 0.6f) }
+		};
+
+		for (const auto& [name, pMaterial] : materials)
+		{
+			const double nsPerCall{ MeasureNsPerCall(numCalls, [&](size_t index) {
+				const ShadingSample& sample{ samples[index] };
+				const ColorRGB color{ pMaterial->Shade(sample.hitRecord, sample.l, sample.v) };
+				return color.r + color.g + color.b > 0.f;
+			}) };
+
+			PrintResult(name, 0.f, nsPerCall, 0.0);
+		}
+
+		// BRDF terms
+		const ColorRGB f0{ 0.04f, 0.04f, 0.04f };
+		const auto printBRDF = [&](const std::string& name, auto&& func) {
+			PrintResult(name, 0.f, MeasureNsPerCall(numCalls, func), 0.0);
+		};
+
+		printBRDF("BRDF::Lambert", [&](size_t index) {
+			return BRDF::Lambert(samples[index].v.x, colors::White).r > 0.f;
+		});
+		printBRDF("BRDF::Phong", [&](size_t index) {
+			const ShadingSample& sample{ samples[index] };
+			return BRDF::Phong(0.5f, 60.f, sample.l, -sample.v, sample.hitRecord.normal).r > 0.f;
+		});
+		printBRDF("BRDF::FresnelFunction_Schlick", [&](size_t index) {
+			const ShadingSample& sample{ samples[index] };
+			return BRDF::FresnelFunction_Schlick((sample.l + sample.v).Normalized(), sample.v, f0).r > 0.f;
+		});
+		printBRDF("BRDF::NormalDistribution_GGX", [&](size_t index) {
+			const ShadingSample& sample{ samples[index] };
+			return BRDF::NormalDistribution_GGX(sample.hitRecord.normal, (sample.l + sample.v).Normalized(), 0.6f) > 0.f;
+		});
+		printBRDF("BRDF::GeometryFunction_Smith", [&](size_t index) {
+			const ShadingSample& sample{ samples[index] };
+			return BRDF::GeometryFunction_Smith(sample.hitRecord.normal, sample.v, sample.l, 0.6f) > 0.f;
+		});
+	}
+#pragma endregion
+}
+
+int main(int argc, char* args[])
+{
+	size_t numCalls{ 1 << 18 };
+
+	for (int argIdx{ 1 }; argIdx + 1 < argc; ++argIdx)
+	{
+		if (std::string(args[argIdx]) == "--calls")
+			numCalls = std::stoul(args[++argIdx]);
+	}
+
+	std::cout << "Calls per kernel: " << numCalls << " (best of 5 runs)\n\n";
+	PrintHeader();
+
+	BenchmarkSpheres(numCalls);
+	BenchmarkPlanes(numCalls);
+	BenchmarkTriangles(numCalls);
+	BenchmarkSlabTests(numCalls);
+	BenchmarkShading(numCalls);
+
+	return 0;
+}
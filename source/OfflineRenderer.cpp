@@ -0,0 +1,96 @@
+#include "OfflineRenderer.h"
+#include "ImageSink.h"
+#include "Renderer.h"
+#include "Scene.h"
+#include "Math.h"
+#include "Profiler.h"
+#include "Threading.h"
+
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+
+using namespace dae;
+
+OfflineRenderer::OfflineRenderer(const OfflineRenderSettings& settings) :
+	m_Settings(settings)
+{
+}
+
+bool OfflineRenderer::Render(Scene* pScene, ImageSink& sink)
+{
+	return RenderRegion(pScene, sink, 0, 0, m_Settings.width, m_Settings.height);
+}
+
+bool OfflineRenderer::RenderRegion(Scene* pScene, ImageSink& sink, int regionX, int regionY, int regionWidth, int regionHeight)
+{
+	const int width{ m_Settings.width };
+	const int height{ m_Settings.height };
+	const int tileSize{ sink.GetRequiredTileSize() > 0 ? sink.GetRequiredTileSize() : m_Settings.tileSize };
+
+	if (!sink.Begin(regionWidth, regionHeight))
+		return false;
+
+	Camera& camera = pScene->GetCamera();
+	auto& materials = pScene->GetMaterials();
+	auto& lights = pScene->GetLights();
+
+	camera.CalculateCameraToWorld();
+
+	const ImagePlane imagePlane{ width, height, tanf(camera.fovAngle * TO_RADIANS / 2), float(width) / height };
+	const Renderer::TracePixelFunction pTracePixel{ Renderer::SelectTracePixel(Renderer::LightingMode::Combined, m_Settings.shadowsEnabled, lights) };
+
+	const uint32_t numTilesX{ uint32_t((regionWidth + tileSize - 1) / tileSize) };
+	const uint32_t numTilesY{ uint32_t((regionHeight + tileSize - 1) / tileSize) };
+	const uint32_t numOfTiles{ numTilesX * numTilesY };
+
+	std::atomic<bool> succeeded{ true };
+	std::atomic<uint32_t> numFinishedTiles{ 0 };
+
+	ParallelFor(0u, numOfTiles, [&](uint32_t tileIndex) {
+		PROFILE_SCOPE("OfflineRenderer::RenderTile");
+
+		ImageTile tile{};
+		tile.x = int(tileIndex % numTilesX) * tileSize;
+		tile.y = int(tileIndex / numTilesX) * tileSize;
+		tile.width = std::min(tileSize, regionWidth - tile.x);
+		tile.height = std::min(tileSize, regionHeight - tile.y);
+		tile.rowStride = size_t(tile.width);
+
+		//The arena only ever holds the tile this thread is working on
+		MemoryArena& arena{ m_TileArenas.Local() };
+		arena.Reset();
+
+		const size_t numTilePixels{ size_t(tile.width) * tile.height };
+		float* pRed{ arena.NewArray<float>(numTilePixels) };
+		float* pGreen{ arena.NewArray<float>(numTilePixels) };
+		float* pBlue{ arena.NewArray<float>(numTilePixels) };
+
+		for (int row{ 0 }; row < tile.height; ++row) {
+			for (int column{ 0 }; column < tile.width; ++column) {
+				const ColorRGB color{ pTracePixel(pScene, regionX + tile.x + column + 0.5f, regionY + tile.y + row + 0.5f, 0, imagePlane, camera, lights, materials, nullptr) };
+
+				const size_t tilePixelIndex{ size_t(row) * tile.width + column };
+				pRed[tilePixelIndex] = color.r;
+				pGreen[tilePixelIndex] = color.g;
+				pBlue[tilePixelIndex] = color.b;
+			}
+		}
+
+		tile.pRed = pRed;
+		tile.pGreen = pGreen;
+		tile.pBlue = pBlue;
+		if (!sink.WriteTile(tile))
+			succeeded = false;
+
+		//Report every 10%, only the thread that crosses a step prints it
+		const uint32_t numFinished{ numFinishedTiles.fetch_add(1) + 1 };
+		if (m_Settings.printProgress && numFinished * 10 / numOfTiles != (numFinished - 1) * 10 / numOfTiles)
+			std::cout << "Rendered " << numFinished * 100 / numOfTiles << "% (" << numFinished << "/" << numOfTiles << " tiles)" << std::endl;
+	});
+
+	if (m_Settings.collectRayStats)
+		m_Stats = RayStatistics::MergeAndReset();
+
+	return sink.End() && succeeded;
+}
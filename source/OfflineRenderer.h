@@ -0,0 +1,58 @@
+#pragma once
+#include <cstdint>
+
+#include "MemoryArena.h"
+#include "RayStats.h"
+
+namespace dae
+{
+	class Scene;
+	class ImageSink;
+
+	struct OfflineRenderSettings
+	{
+		int width{ 3840 };
+		int height{ 2160 };
+
+		//Ignored when the sink needs its own tile grid (tiled EXR)
+		int tileSize{ 64 };
+		bool shadowsEnabled{ true };
+
+		bool printProgress{ true };
+		//Ray counters are shared by the whole process, only one of several renders running at once should collect them
+		bool collectRayStats{ true };
+	};
+
+	/**
+	 * \brief Renders stills of any resolution without a window or a full size framebuffer.
+	 * Tiles are traced into a small per-thread buffer and handed to the sink as soon as they are done,
+	 * so peak memory is about tileSize^2 * threads, no matter how large the image is.
+	 */
+	class OfflineRenderer final
+	{
+	public:
+		explicit OfflineRenderer(const OfflineRenderSettings& settings);
+		~OfflineRenderer() = default;
+
+		OfflineRenderer(const OfflineRenderer&) = delete;
+		OfflineRenderer(OfflineRenderer&&) noexcept = delete;
+		OfflineRenderer& operator=(const OfflineRenderer&) = delete;
+		OfflineRenderer& operator=(OfflineRenderer&&) noexcept = delete;
+
+		//Traces the whole image through the sink's Begin/WriteTile/End, returns false if any of them failed
+		bool Render(Scene* pScene, ImageSink& sink);
+		//Same, but only for the window [regionX, regionX + regionWidth) x [regionY, regionY + regionHeight) of the image.
+		//The sink sees that window as an image of its own, with tile coordinates relative to it
+		bool RenderRegion(Scene* pScene, ImageSink& sink, int regionX, int regionY, int regionWidth, int regionHeight);
+
+		const RayStats& GetStats() const { return m_Stats; }
+
+	private:
+		OfflineRenderSettings m_Settings{};
+
+		//Tile buffers, rewound before every tile
+		ScratchArenas m_TileArenas{};
+
+		RayStats m_Stats{};
+	};
+}
@@ -0,0 +1,172 @@
+#include "PathTracer.h"
+#include "AreaLights.h"
+#include "CpuFeatures.h"
+#include "LightTree.h"
+#include "Material.h"
+#include "RayStats.h"
+#include "Scene.h"
+#include "Utils.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace dae;
+
+namespace
+{
+	//Survival probability cap, so even bright paths get cut off eventually
+	constexpr float MAX_SURVIVAL_PROBABILITY{ 0.95f };
+	//Secondary rays start this far off the surface they leave
+	constexpr float SURFACE_OFFSET{ 0.001f };
+}
+
+template<bool shadowsEnabled>
+HOT_KERNEL ColorRGB PathTracer::TracePixel(Scene* pScene, float x, float y, uint32_t sampleIndex, const ImagePlane& imagePlane, const Camera& camera, const std::vector<Light>& lights, const std::vector<Material*>& materials, PrimaryHit* pPrimaryHit)
+{
+	PathState path{};
+	path.ray = imagePlane.GetPrimaryRay(x, y, camera);
+
+	Sampler sampler{ imagePlane.samplerType, uint32_t(std::max(x, 0.f)), uint32_t(std::max(y, 0.f)), sampleIndex, Sampler::PIXEL_DIMENSIONS };
+
+	RAY_STATS_INC(primaryRays);
+
+	for (; path.bounce < MAX_BOUNCES; ++path.bounce)
+	{
+		HitRecord hit{};
+		pScene->GetClosestHit(path.ray, hit);
+
+		if (path.bounce == 0 && pPrimaryHit)
+			*pPrimaryHit = hit.didHit ? PrimaryHit{ hit.origin, hit.normal, materials[hit.materialIndex]->GetAlbedo(), hit.t } : PrimaryHit{};
+
+		//No environment light, escaping paths carry nothing
+		if (!hit.didHit)
+			break;
+
+		Material* pMaterial{ materials[hit.materialIndex] };
+		const Vector3 v{ -path.ray.direction };
+
+		//Drawn before the lights, whose number of dimensions varies, so every bounce samples its direction from the same dimensions
+		float directionU1{};
+		float directionU2{};
+		sampler.Next2D(directionU1, directionU2);
+		const float lobeU{ sampler.NextFloat() };
+		const float survivalU{ sampler.NextFloat() };
+
+		path.radiance += path.throughput * EstimateDirectLight<shadowsEnabled>(pScene, hit, v, pMaterial, lights, sampler);
+
+		//Seen from behind there's no hemisphere to continue into, and nothing more to gain from the last bounce
+		if (path.bounce + 1 == MAX_BOUNCES || Vector3::Dot(hit.normal, v) <= 0)
+			break;
+
+		Vector3 l{};
+		const float pdf{ pMaterial->Sample(hit, v, directionU1, directionU2, lobeU, l) };
+		const float cosineLaw{ Vector3::Dot(hit.normal, l) };
+		if (!(pdf > 0) || !std::isfinite(pdf) || cosineLaw <= 0)
+			break;
+
+		path.throughput *= pMaterial->Shade(hit, l, v) * (cosineLaw / pdf);
+
+		if (path.bounce + 1 >= RUSSIAN_ROULETTE_START)
+		{
+			const float survivalProbability{ std::min(std::max({ path.throughput.r, path.throughput.g, path.throughput.b }), MAX_SURVIVAL_PROBABILITY) };
+			if (survivalU >= survivalProbability)
+				break;
+
+			path.throughput /= survivalProbability;
+		}
+
+		path.ray = Ray{ hit.origin + hit.normal * SURFACE_OFFSET, l };
+		RAY_STATS_INC(secondaryRays);
+	}
+
+	return path.radiance;
+}
+
+template<bool shadowsEnabled>
+ColorRGB PathTracer::EstimateDirectLight(const Scene* pScene, const HitRecord& hit, const Vector3& v, Material* pMaterial, const std::vector<Light>& lights, Sampler& sampler)
+{
+	ColorRGB directLight{};
+
+	if (lights.size() <= LightTree::SAMPLING_THRESHOLD)
+	{
+		for (const Light& light : lights)
+		{
+			directLight += ShadeLight<shadowsEnabled>(pScene, hit, v, pMaterial, light, sampler);
+		}
+
+		return directLight;
+	}
+
+	const LightTree& lightTree{ pScene->GetLightTree() };
+	for (const uint32_t lightIndex : lightTree.GetInfiniteLights())
+	{
+		directLight += ShadeLight<shadowsEnabled>(pScene, hit, v, pMaterial, lights[lightIndex], sampler);
+	}
+
+	for (uint32_t sampleIdx{ 0 }; sampleIdx < LightTree::NUM_LIGHT_SAMPLES; ++sampleIdx)
+	{
+		uint32_t lightIndex{};
+		float lightPmf{};
+		if (lightTree.Sample(hit.origin, hit.normal, sampler.NextFloat(), lightIndex, lightPmf))
+			directLight += ShadeLight<shadowsEnabled>(pScene, hit, v, pMaterial, lights[lightIndex], sampler) / (LightTree::NUM_LIGHT_SAMPLES * lightPmf);
+	}
+
+	return directLight;
+}
+
+template<bool shadowsEnabled>
+ColorRGB PathTracer::ShadeLight(const Scene* pScene, const HitRecord& hit, const Vector3& v, Material* pMaterial, const Light& light, Sampler& sampler)
+{
+	//Same light model as Renderer::TracePixel in Combined mode
+	if (AreaLights::IsAreaLight(light))
+	{
+		const auto shadeSample = [&](const AreaLights::LightSample& sample) -> ColorRGB {
+			const float cosineLaw{ Vector3::Dot(hit.normal, sample.toLightDirection) };
+			if (cosineLaw < 0)
+				return ColorRGB{};
+
+			return sample.radiance * pMaterial->Shade(hit, sample.toLightDirection, v) * cosineLaw;
+		};
+
+		const auto isOccluded = [&](const AreaLights::LightSample& sample) {
+			Ray toLight{ hit.origin + hit.normal * SURFACE_OFFSET, sample.toLightDirection };
+			toLight.max = sample.distance;
+
+			RAY_STATS_INC(shadowRays);
+			return pScene->DoesHit(toLight);
+		};
+
+		return AreaLights::Estimate<shadowsEnabled>(light, hit.origin, sampler, shadeSample, isOccluded);
+	}
+
+	Vector3 toLightDirection{ LightUtils::GetDirectionToLight(light, hit.origin) };
+	const float sqrDistanceToLight{ toLightDirection.SqrMagnitude() };
+	const float distanceToLight{ sqrtf(sqrDistanceToLight) };
+	toLightDirection /= distanceToLight;
+
+	const bool isPointLight{ light.type == LightType::Point };
+	ColorRGB radiance{};
+	if (!LightUtils::GetPunctualRadiance(light, sqrDistanceToLight, isPointLight, radiance))
+		return ColorRGB{};
+
+	const Vector3& lightDirection{ isPointLight ? toLightDirection : light.direction };
+
+	const float cosineLaw{ Vector3::Dot(hit.normal, lightDirection) };
+	if (cosineLaw < 0)
+		return ColorRGB{};
+
+	if constexpr (shadowsEnabled)
+	{
+		Ray toLight{ hit.origin + hit.normal * SURFACE_OFFSET, toLightDirection };
+		toLight.max = distanceToLight;
+
+		RAY_STATS_INC(shadowRays);
+		if (pScene->DoesHit(toLight))
+			return ColorRGB{};
+	}
+
+	return radiance * pMaterial->Shade(hit, toLightDirection, v) * cosineLaw;
+}
+
+template ColorRGB PathTracer::TracePixel<true>(Scene*, float, float, uint32_t, const ImagePlane&, const Camera&, const std::vector<Light>&, const std::vector<Material*>&, PrimaryHit*);
+template ColorRGB PathTracer::TracePixel<false>(Scene*, float, float, uint32_t, const ImagePlane&, const Camera&, const std::vector<Light>&, const std::vector<Material*>&, PrimaryHit*);
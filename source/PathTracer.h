@@ -0,0 +1,53 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "Camera.h"
+#include "DataTypes.h"
+#include "Sampler.h"
+#include "Renderer.h"
+
+namespace dae
+{
+	class Scene;
+	class Material;
+
+	/**
+	 * \brief Multi-bounce path tracing integrator, Renderer::LightingMode::PathTraced.
+	 * Every bounce adds next-event estimation towards the lights (no light is scene geometry, so none can be hit by chance),
+	 * then continues in a direction importance sampled from the material (Material::Sample: cosine or GGX lobes).
+	 * Paths are cut off by Russian roulette on their throughput after a few bounces, and at MAX_BOUNCES.
+	 */
+	class PathTracer final
+	{
+	public:
+		//Maximum number of surfaces a path shades, 1 is direct lighting only
+		static constexpr uint32_t MAX_BOUNCES{ 8 };
+		//Bounces that always continue before Russian roulette may end a path
+		static constexpr uint32_t RUSSIAN_ROULETTE_START{ 3 };
+
+		PathTracer() = delete;
+
+		//Matches Renderer::TracePixelFunction. The sample values of a path only depend on its pixel and sample index
+		template<bool shadowsEnabled>
+		static ColorRGB TracePixel(Scene* pScene, float x, float y, uint32_t sampleIndex, const ImagePlane& imagePlane, const Camera& camera, const std::vector<Light>& lights, const std::vector<Material*>& materials, PrimaryHit* pPrimaryHit);
+
+	private:
+		//Everything a path carries from one bounce to the next. Lives on the stack of the tracing thread,
+		//so a path needs no recursion and no allocations
+		struct PathState
+		{
+			Ray ray{};
+			ColorRGB throughput{ 1.f, 1.f, 1.f };
+			ColorRGB radiance{};
+			uint32_t bounce{ 0 };
+		};
+
+		//All lights, or LightTree::NUM_LIGHT_SAMPLES picked from the scene's light tree when there are many
+		template<bool shadowsEnabled>
+		static ColorRGB EstimateDirectLight(const Scene* pScene, const HitRecord& hit, const Vector3& v, Material* pMaterial, const std::vector<Light>& lights, Sampler& sampler);
+		//sampler is only drawn from for area lights
+		template<bool shadowsEnabled>
+		static ColorRGB ShadeLight(const Scene* pScene, const HitRecord& hit, const Vector3& v, Material* pMaterial, const Light& light, Sampler& sampler);
+	};
+}
@@ -0,0 +1,83 @@
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+
+using namespace dae;
+
+Profiler& Profiler::Get()
+{
+	static Profiler s_Profiler{};
+	return s_Profiler;
+}
+
+void Profiler::Record(const char* pName, uint64_t startNs, uint64_t endNs)
+{
+	//Only the owning thread ever writes to its buffer
+	ThreadBuffer& buffer{ m_ThreadBuffers[GetThreadSlot()] };
+	if (!buffer.pEvents)
+		buffer.pEvents = std::make_unique<ProfileEvent[]>(EVENTS_PER_THREAD);
+
+	const uint64_t writeIndex{ buffer.writeIndex.load(std::memory_order_relaxed) };
+
+	ProfileEvent& event{ buffer.pEvents[writeIndex % EVENTS_PER_THREAD] };
+	event.pName = pName;
+	event.startNs = startNs;
+	event.endNs = endNs;
+	event.frame = m_CurrentFrame.load(std::memory_order_relaxed);
+
+	buffer.writeIndex.store(writeIndex + 1, std::memory_order_release);
+}
+
+bool Profiler::WriteChromeTrace(const std::string& filename) const
+{
+	std::ofstream fileStream(filename);
+	if (!fileStream)
+		return false;
+
+	//Timestamps are written relative to the oldest event still in the buffers
+	uint64_t baseNs{ UINT64_MAX };
+	for (const ThreadBuffer& buffer : m_ThreadBuffers)
+	{
+		const uint64_t writeIndex{ buffer.writeIndex.load(std::memory_order_acquire) };
+		const uint64_t numEvents{ std::min<uint64_t>(writeIndex, EVENTS_PER_THREAD) };
+		for (uint64_t eventIdx{ writeIndex - numEvents }; eventIdx < writeIndex; ++eventIdx)
+		{
+			baseNs = std::min(baseNs, buffer.pEvents[eventIdx % EVENTS_PER_THREAD].startNs);
+		}
+	}
+
+	fileStream << std::fixed << std::setprecision(3);
+	fileStream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+	bool isFirstEvent{ true };
+	for (uint32_t slot{ 0 }; slot < MAX_THREAD_SLOTS; ++slot)
+	{
+		const ThreadBuffer& buffer{ m_ThreadBuffers[slot] };
+		const uint64_t writeIndex{ buffer.writeIndex.load(std::memory_order_acquire) };
+		if (writeIndex == 0)
+			continue;
+
+		fileStream << (isFirstEvent ? "" : ",")
+			<< "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << slot
+			<< ",\"args\":{\"name\":\"Thread " << slot << "\"}}";
+		isFirstEvent = false;
+
+		const uint64_t numEvents{ std::min<uint64_t>(writeIndex, EVENTS_PER_THREAD) };
+		for (uint64_t eventIdx{ writeIndex - numEvents }; eventIdx < writeIndex; ++eventIdx)
+		{
+			const ProfileEvent& event{ buffer.pEvents[eventIdx % EVENTS_PER_THREAD] };
+
+			fileStream << ",\n{\"name\":\"" << event.pName
+				<< "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << slot
+				<< ",\"ts\":" << (event.startNs - baseNs) / 1000.0
+				<< ",\"dur\":" << (event.endNs - event.startNs) / 1000.0
+				<< ",\"args\":{\"frame\":" << event.frame << "}}";
+		}
+	}
+
+	fileStream << "\n]}\n";
+	return fileStream.good();
+}
@@ -0,0 +1,101 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "Threading.h"
+
+//Comment out to compile every PROFILE_SCOPE away
+#define ENABLE_PROFILER
+
+namespace dae
+{
+	struct ProfileEvent
+	{
+		const char* pName{};
+		uint64_t startNs{};
+		uint64_t endNs{};
+		uint32_t frame{};
+	};
+
+	/**
+	 * \brief Collects scoped timings per thread. Every thread writes into its own ring buffer
+	 * (single producer), so recording never takes a lock. Old events are overwritten once a buffer is full.
+	 */
+	class Profiler final
+	{
+	public:
+		static Profiler& Get();
+
+		~Profiler() = default;
+
+		Profiler(const Profiler&) = delete;
+		Profiler(Profiler&&) noexcept = delete;
+		Profiler& operator=(const Profiler&) = delete;
+		Profiler& operator=(Profiler&&) noexcept = delete;
+
+		static uint64_t Now()
+		{
+			return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now().time_since_epoch()).count());
+		}
+
+		void BeginFrame() { m_CurrentFrame.fetch_add(1, std::memory_order_relaxed); }
+		void Record(const char* pName, uint64_t startNs, uint64_t endNs);
+
+		/**
+		 * \brief Writes all buffered events in the Chrome trace event format (chrome://tracing, Perfetto)
+		 * Should be called while no other thread is recording (e.g. between frames)
+		 * \return true on success
+		 */
+		bool WriteChromeTrace(const std::string& filename) const;
+
+	private:
+		Profiler() = default;
+
+		static constexpr uint32_t EVENTS_PER_THREAD{ 1 << 14 };
+
+		struct ThreadBuffer
+		{
+			std::unique_ptr<ProfileEvent[]> pEvents{};
+			std::atomic<uint64_t> writeIndex{ 0 };
+		};
+
+		ThreadBuffer m_ThreadBuffers[MAX_THREAD_SLOTS]{};
+		std::atomic<uint32_t> m_CurrentFrame{ 0 };
+	};
+
+	class ProfileScope final
+	{
+	public:
+		explicit ProfileScope(const char* pName) :
+			m_pName(pName),
+			m_StartNs(Profiler::Now())
+		{
+		}
+
+		~ProfileScope()
+		{
+			Profiler::Get().Record(m_pName, m_StartNs, Profiler::Now());
+		}
+
+		ProfileScope(const ProfileScope&) = delete;
+		ProfileScope(ProfileScope&&) noexcept = delete;
+		ProfileScope& operator=(const ProfileScope&) = delete;
+		ProfileScope& operator=(ProfileScope&&) noexcept = delete;
+
+	private:
+		const char* m_pName{};
+		uint64_t m_StartNs{};
+	};
+}
+
+#if defined(ENABLE_PROFILER)
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) const ::dae::ProfileScope PROFILE_CONCAT(profileScope, __LINE__){ name }
+#else
+#define PROFILE_SCOPE(name)
+#endif
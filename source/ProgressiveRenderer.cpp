@@ -0,0 +1,333 @@
+#include "ProgressiveRenderer.h"
+#include "ImageSink.h"
+#include "Renderer.h"
+#include "Scene.h"
+#include "Math.h"
+#include "Profiler.h"
+#include "Threading.h"
+
+#include <algorithm>
+#include <bit>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+using namespace dae;
+
+//Checkpoints hold raw memory, they're only meant to be read back on the same kind of machine
+static_assert(std::endian::native == std::endian::little, "Checkpoints are written little endian");
+
+namespace
+{
+	constexpr uint32_t CHECKPOINT_MAGIC{ 0x50435452 }; //"RTCP"
+	constexpr uint32_t CHECKPOINT_VERSION{ 2 };
+
+	//Followed by the scene name (uint32 length + characters), then the red, green and blue sums
+	//and the sample counts, pixelCount values each
+	struct CheckpointHeader
+	{
+		uint32_t magic{ CHECKPOINT_MAGIC };
+		uint32_t version{ CHECKPOINT_VERSION };
+		int32_t width{};
+		int32_t height{};
+		uint32_t completedPasses{};
+		uint8_t shadowsEnabled{};
+		uint8_t sphereAlgorithm{};
+		uint8_t triangleAlgorithm{};
+		uint8_t pathTracingEnabled{};
+		uint8_t samplerType{};
+		uint8_t padding[3]{};
+	};
+}
+
+ProgressiveRenderer::ProgressiveRenderer(const ProgressiveRenderSettings& settings) :
+	m_Settings(settings)
+{
+}
+
+bool ProgressiveRenderer::Render(Scene* pScene, const std::string& sceneName, ImageSink& sink)
+{
+	Reset();
+
+	const uint32_t samplesPerPixel{ m_Settings.samplesPerPixel };
+	const bool hasCheckpoints{ !m_Settings.checkpointFile.empty() };
+
+	if (hasCheckpoints && LoadCheckpoint(pScene, sceneName))
+		std::cout << "Resuming from " << m_Settings.checkpointFile << " at " << m_CompletedPasses << "/" << samplesPerPixel << " samples per pixel" << std::endl;
+
+	uint64_t lastCheckpointNs{ Profiler::Now() };
+	while (m_CompletedPasses < samplesPerPixel)
+	{
+		RenderPass(pScene);
+		++m_CompletedPasses;
+		std::cout << "Sample " << m_CompletedPasses << "/" << samplesPerPixel << std::endl;
+
+		const bool isStopRequested{ s_IsStopRequested.load() };
+		const bool isCheckpointDue{ double(Profiler::Now() - lastCheckpointNs) / 1'000'000'000.0 >= m_Settings.checkpointInterval };
+
+		//Checkpoints only ever land between passes, where every pixel has the same number of samples
+		if (hasCheckpoints && (isStopRequested || isCheckpointDue) && m_CompletedPasses < samplesPerPixel)
+		{
+			if (SaveCheckpoint(pScene, sceneName))
+				std::cout << "Checkpoint saved to " << m_Settings.checkpointFile << std::endl;
+			else
+				std::cout << "Something went wrong. Checkpoint not saved!" << std::endl;
+
+			lastCheckpointNs = Profiler::Now();
+		}
+
+		if (isStopRequested && m_CompletedPasses < samplesPerPixel)
+		{
+			std::cout << "Stopped after " << m_CompletedPasses << "/" << samplesPerPixel << " samples per pixel" << std::endl;
+			return false;
+		}
+	}
+
+	if (!WriteImage(pScene, sink))
+		return false;
+
+	//The image is out, the checkpoint has served its purpose
+	if (hasCheckpoints)
+	{
+		std::error_code error{};
+		std::filesystem::remove(m_Settings.checkpointFile, error);
+	}
+
+	return true;
+}
+
+void ProgressiveRenderer::Reset()
+{
+	const size_t numPixels{ size_t(m_Settings.width) * m_Settings.height };
+
+	m_Accumulation.Resize(m_Settings.width, m_Settings.height);
+	m_SampleCounts.assign(numPixels, 0);
+	m_CompletedPasses = 0;
+	m_PrimaryHits.assign(m_Settings.denoiseEnabled ? numPixels : 0, {});
+	m_HasPrimaryHits = false;
+}
+
+void ProgressiveRenderer::RenderPass(Scene* pScene)
+{
+	PROFILE_SCOPE("ProgressiveRenderer::RenderPass");
+
+	const int width{ m_Settings.width };
+	const int height{ m_Settings.height };
+	const int tileSize{ m_Settings.tileSize };
+
+	Camera& camera = pScene->GetCamera();
+	auto& materials = pScene->GetMaterials();
+	auto& lights = pScene->GetLights();
+
+	camera.CalculateCameraToWorld();
+
+	const ImagePlane imagePlane{ width, height, tanf(camera.fovAngle * TO_RADIANS / 2), float(width) / height, m_Settings.samplerType };
+	const Renderer::LightingMode lightingMode{ m_Settings.pathTracingEnabled ? Renderer::LightingMode::PathTraced : Renderer::LightingMode::Combined };
+	const Renderer::TracePixelFunction pTracePixel{ Renderer::SelectTracePixel(lightingMode, m_Settings.shadowsEnabled, lights) };
+
+	const uint32_t numTilesX{ uint32_t((width + tileSize - 1) / tileSize) };
+	const uint32_t numTilesY{ uint32_t((height + tileSize - 1) / tileSize) };
+
+	//Every pixel only depends on its own sample count and sums, so the result doesn't depend on which thread gets which tile
+	ParallelFor(0u, numTilesX * numTilesY, [&](uint32_t tileIndex) {
+		const int tileStartX{ int(tileIndex % numTilesX) * tileSize };
+		const int tileStartY{ int(tileIndex / numTilesX) * tileSize };
+		const int tileEndX{ std::min(tileStartX + tileSize, width) };
+		const int tileEndY{ std::min(tileStartY + tileSize, height) };
+
+		for (int py{ tileStartY }; py < tileEndY; ++py) {
+			for (int px{ tileStartX }; px < tileEndX; ++px) {
+				const size_t pixelIndex{ size_t(py) * width + px };
+
+				Sampler pixelSampler{ m_Settings.samplerType, uint32_t(px), uint32_t(py), m_SampleCounts[pixelIndex] };
+				float jitterX{};
+				float jitterY{};
+				pixelSampler.Next2D(jitterX, jitterY);
+				const float x{ px + jitterX };
+				const float y{ py + jitterY };
+
+				PrimaryHit* const pPrimaryHit{ m_Settings.denoiseEnabled ? &m_PrimaryHits[pixelIndex] : nullptr };
+				const ColorRGB color{ pTracePixel(pScene, x, y, m_SampleCounts[pixelIndex], imagePlane, camera, lights, materials, pPrimaryHit) };
+				m_Accumulation.red[pixelIndex] += color.r;
+				m_Accumulation.green[pixelIndex] += color.g;
+				m_Accumulation.blue[pixelIndex] += color.b;
+				++m_SampleCounts[pixelIndex];
+			}
+		}
+	});
+
+	m_HasPrimaryHits = m_Settings.denoiseEnabled;
+	RayStatistics::MergeAndReset();
+}
+
+bool ProgressiveRenderer::WriteImage(Scene* pScene, ImageSink& sink)
+{
+	const int width{ m_Settings.width };
+	const int height{ m_Settings.height };
+	const int tileSize{ sink.GetRequiredTileSize() > 0 ? sink.GetRequiredTileSize() : m_Settings.tileSize };
+
+	//The filter reaches across tiles, the whole image is averaged and denoised before the first tile goes out
+	//A checkpoint that already holds all passes leaves no pass to record the guides
+	const bool denoise{ m_Settings.denoiseEnabled && m_HasPrimaryHits };
+	if (m_Settings.denoiseEnabled && !denoise)
+		std::cout << "No pass was rendered in this run, writing the image without denoising" << std::endl;
+
+	HdrBuffer denoised{};
+	if (denoise)
+	{
+		PROFILE_SCOPE("Denoiser");
+
+		denoised.Resize(width, height);
+		for (size_t pixelIndex{ 0 }; pixelIndex < denoised.GetPixelCount(); ++pixelIndex)
+		{
+			const float weight{ m_SampleCounts[pixelIndex] > 0 ? 1.f / m_SampleCounts[pixelIndex] : 0.f };
+			denoised.SetPixel(pixelIndex, m_Accumulation.GetPixel(pixelIndex) * weight);
+		}
+
+		const Camera& camera = pScene->GetCamera();
+		const ImagePlane imagePlane{ width, height, tanf(camera.fovAngle * TO_RADIANS / 2), float(width) / height };
+		m_Denoiser.SetGuides(m_PrimaryHits, imagePlane, camera);
+		m_Denoiser.Apply(denoised);
+	}
+
+	if (!sink.Begin(width, height))
+		return false;
+
+	const uint32_t numTilesX{ uint32_t((width + tileSize - 1) / tileSize) };
+	const uint32_t numTilesY{ uint32_t((height + tileSize - 1) / tileSize) };
+
+	std::atomic<bool> succeeded{ true };
+	ParallelFor(0u, numTilesX * numTilesY, [&](uint32_t tileIndex) {
+		ImageTile tile{};
+		tile.x = int(tileIndex % numTilesX) * tileSize;
+		tile.y = int(tileIndex / numTilesX) * tileSize;
+		tile.width = std::min(tileSize, width - tile.x);
+		tile.height = std::min(tileSize, height - tile.y);
+		tile.rowStride = size_t(tile.width);
+
+		MemoryArena& arena{ m_TileArenas.Local() };
+		arena.Reset();
+
+		const size_t numTilePixels{ size_t(tile.width) * tile.height };
+		float* pRed{ arena.NewArray<float>(numTilePixels) };
+		float* pGreen{ arena.NewArray<float>(numTilePixels) };
+		float* pBlue{ arena.NewArray<float>(numTilePixels) };
+
+		for (int row{ 0 }; row < tile.height; ++row) {
+			for (int column{ 0 }; column < tile.width; ++column) {
+				const size_t pixelIndex{ size_t(tile.y + row) * width + tile.x + column };
+				const size_t tilePixelIndex{ size_t(row) * tile.width + column };
+				if (denoise) {
+					pRed[tilePixelIndex] = denoised.red[pixelIndex];
+					pGreen[tilePixelIndex] = denoised.green[pixelIndex];
+					pBlue[tilePixelIndex] = denoised.blue[pixelIndex];
+					continue;
+				}
+
+				const float weight{ m_SampleCounts[pixelIndex] > 0 ? 1.f / m_SampleCounts[pixelIndex] : 0.f };
+
+				pRed[tilePixelIndex] = m_Accumulation.red[pixelIndex] * weight;
+				pGreen[tilePixelIndex] = m_Accumulation.green[pixelIndex] * weight;
+				pBlue[tilePixelIndex] = m_Accumulation.blue[pixelIndex] * weight;
+			}
+		}
+
+		tile.pRed = pRed;
+		tile.pGreen = pGreen;
+		tile.pBlue = pBlue;
+		if (!sink.WriteTile(tile))
+			succeeded = false;
+	});
+
+	return sink.End() && succeeded;
+}
+
+bool ProgressiveRenderer::SaveCheckpoint(const Scene* pScene, const std::string& sceneName) const
+{
+	PROFILE_SCOPE("ProgressiveRenderer::SaveCheckpoint");
+
+	//Written next to the old checkpoint and moved over it when complete, so being killed halfway never leaves a broken one
+	const std::string temporaryFile{ m_Settings.checkpointFile + ".tmp" };
+	{
+		std::ofstream fileStream(temporaryFile, std::ios::binary | std::ios::trunc);
+		if (!fileStream)
+			return false;
+
+		CheckpointHeader header{};
+		header.width = m_Settings.width;
+		header.height = m_Settings.height;
+		header.completedPasses = m_CompletedPasses;
+		header.shadowsEnabled = uint8_t(m_Settings.shadowsEnabled);
+		header.sphereAlgorithm = uint8_t(pScene->GetSphereAlgorithm());
+		header.triangleAlgorithm = uint8_t(pScene->GetTriangleAlgorithm());
+		header.pathTracingEnabled = uint8_t(m_Settings.pathTracingEnabled);
+		header.samplerType = uint8_t(m_Settings.samplerType);
+
+		const uint32_t sceneNameSize{ uint32_t(sceneName.size()) };
+		const size_t numPixels{ m_SampleCounts.size() };
+
+		fileStream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		fileStream.write(reinterpret_cast<const char*>(&sceneNameSize), sizeof(sceneNameSize));
+		fileStream.write(sceneName.data(), sceneNameSize);
+		fileStream.write(reinterpret_cast<const char*>(m_Accumulation.red.data()), numPixels * sizeof(float));
+		fileStream.write(reinterpret_cast<const char*>(m_Accumulation.green.data()), numPixels * sizeof(float));
+		fileStream.write(reinterpret_cast<const char*>(m_Accumulation.blue.data()), numPixels * sizeof(float));
+		fileStream.write(reinterpret_cast<const char*>(m_SampleCounts.data()), numPixels * sizeof(uint32_t));
+
+		fileStream.close();
+		if (fileStream.fail())
+			return false;
+	}
+
+	std::error_code error{};
+	std::filesystem::rename(temporaryFile, m_Settings.checkpointFile, error);
+	return !error;
+}
+
+bool ProgressiveRenderer::LoadCheckpoint(Scene* pScene, const std::string& sceneName)
+{
+	std::ifstream fileStream(m_Settings.checkpointFile, std::ios::binary);
+	if (!fileStream)
+		return false;
+
+	CheckpointHeader header{};
+	uint32_t sceneNameSize{};
+	fileStream.read(reinterpret_cast<char*>(&header), sizeof(header));
+	fileStream.read(reinterpret_cast<char*>(&sceneNameSize), sizeof(sceneNameSize));
+
+	std::string checkpointSceneName(fileStream ? std::min(sceneNameSize, 1024u) : 0u, '\0');
+	fileStream.read(checkpointSceneName.data(), checkpointSceneName.size());
+
+	//A checkpoint of another render would silently mix two images, start over instead
+	if (!fileStream
+		|| header.magic != CHECKPOINT_MAGIC
+		|| header.version != CHECKPOINT_VERSION
+		|| header.width != m_Settings.width
+		|| header.height != m_Settings.height
+		|| header.shadowsEnabled != uint8_t(m_Settings.shadowsEnabled)
+		|| header.pathTracingEnabled != uint8_t(m_Settings.pathTracingEnabled)
+		|| header.samplerType != uint8_t(m_Settings.samplerType)
+		|| checkpointSceneName != sceneName)
+	{
+		std::cout << "Checkpoint " << m_Settings.checkpointFile << " belongs to another render, starting over" << std::endl;
+		return false;
+	}
+
+	const size_t numPixels{ m_SampleCounts.size() };
+	fileStream.read(reinterpret_cast<char*>(m_Accumulation.red.data()), numPixels * sizeof(float));
+	fileStream.read(reinterpret_cast<char*>(m_Accumulation.green.data()), numPixels * sizeof(float));
+	fileStream.read(reinterpret_cast<char*>(m_Accumulation.blue.data()), numPixels * sizeof(float));
+	fileStream.read(reinterpret_cast<char*>(m_SampleCounts.data()), numPixels * sizeof(uint32_t));
+
+	if (!fileStream)
+	{
+		std::cout << "Checkpoint " << m_Settings.checkpointFile << " is incomplete, starting over" << std::endl;
+		Reset();
+		return false;
+	}
+
+	//Calibration can pick differently from run to run, the rest of the render has to trace like the first part did
+	pScene->SetIntersectionAlgorithms(SphereAlgorithm(header.sphereAlgorithm), TriangleAlgorithm(header.triangleAlgorithm));
+	m_CompletedPasses = header.completedPasses;
+	return true;
+}
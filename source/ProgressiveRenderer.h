@@ -0,0 +1,87 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "DataTypes.h"
+#include "Denoiser.h"
+#include "HdrBuffer.h"
+#include "MemoryArena.h"
+#include "Sampler.h"
+
+namespace dae
+{
+	class Scene;
+	class ImageSink;
+
+	struct ProgressiveRenderSettings
+	{
+		int width{ 1920 };
+		int height{ 1080 };
+
+		uint32_t samplesPerPixel{ 64 };
+		int tileSize{ 64 };
+		bool shadowsEnabled{ true };
+		//Indirect light through PathTracer instead of direct light only
+		bool pathTracingEnabled{ false };
+		//Where the position of every sample within its pixel and the light and path sample values come from
+		SamplerType samplerType{ SamplerType::Sobol };
+		//Runs the Denoiser over the averaged image before it's written, for low sample counts
+		bool denoiseEnabled{ false };
+
+		//Empty = no checkpoints
+		std::string checkpointFile{};
+		//Seconds between two checkpoints, one is always written when a stop is requested
+		float checkpointInterval{ 300.f };
+	};
+
+	/**
+	 * \brief Offline renderer that accumulates jittered samples over many passes, one sample per pixel per pass.
+	 * A sample's values only depend on its pixel and sample count, so between passes the accumulation buffer and sample counts
+	 * are all a checkpoint file needs: a later run with the same image settings picks up from there and ends with a bit-identical image.
+	 */
+	class ProgressiveRenderer final
+	{
+	public:
+		explicit ProgressiveRenderer(const ProgressiveRenderSettings& settings);
+		~ProgressiveRenderer() = default;
+
+		ProgressiveRenderer(const ProgressiveRenderer&) = delete;
+		ProgressiveRenderer(ProgressiveRenderer&&) noexcept = delete;
+		ProgressiveRenderer& operator=(const ProgressiveRenderer&) = delete;
+		ProgressiveRenderer& operator=(ProgressiveRenderer&&) noexcept = delete;
+
+		//Resumes from the checkpoint file when it matches sceneName and the settings, then renders the remaining passes
+		//and writes the averaged image to the sink. Returns false on errors and when stopped early
+		bool Render(Scene* pScene, const std::string& sceneName, ImageSink& sink);
+
+		//Safe to call from a signal handler: finishes the current pass, writes a checkpoint and returns from Render
+		static void RequestStop() { s_IsStopRequested.store(true); }
+
+		uint32_t GetCompletedPasses() const { return m_CompletedPasses; }
+
+	private:
+		void Reset();
+		void RenderPass(Scene* pScene);
+		bool WriteImage(Scene* pScene, ImageSink& sink);
+
+		bool SaveCheckpoint(const Scene* pScene, const std::string& sceneName) const;
+		bool LoadCheckpoint(Scene* pScene, const std::string& sceneName);
+
+		static inline std::atomic<bool> s_IsStopRequested{ false };
+
+		ProgressiveRenderSettings m_Settings{};
+
+		//Sums of all samples so far, divided by the sample count only when the image is written
+		HdrBuffer m_Accumulation{};
+		std::vector<uint32_t> m_SampleCounts{};
+		uint32_t m_CompletedPasses{ 0 };
+
+		ScratchArenas m_TileArenas{};
+		Denoiser m_Denoiser{};
+		//Denoiser guides, what the last pass's sample of every pixel hit. Not in checkpoints, a resumed render records them again
+		std::vector<PrimaryHit> m_PrimaryHits{};
+		bool m_HasPrimaryHits{ false };
+	};
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <cstdint>
+
+namespace dae
+{
+	/**
+	 * \brief PCG32 (XSH RR) generator. The whole state is one uint64_t, so a fresh generator per pixel sample
+	 * (FromPixelSample) is cheap and makes every sample reproducible on its own, whatever was traced before it.
+	 */
+	struct Pcg32
+	{
+		static constexpr uint64_t MULTIPLIER{ 6364136223846793005ull };
+		static constexpr uint64_t INCREMENT{ 1442695040888963407ull };
+
+		uint64_t state{};
+
+		//Neighbouring seeds (pixel indices) are scrambled first so their sequences don't start out correlated
+		static Pcg32 FromSeed(uint64_t seed)
+		{
+			Pcg32 rng{ Hash(seed) + INCREMENT };
+			rng.NextUInt();
+			return rng;
+		}
+
+		//One sequence per sample of a pixel, pixel coordinates below 2^20. The sample index is hashed on its own
+		//rather than shifted above the pixel bits, so all 32 bits of it count
+		static Pcg32 FromPixelSample(uint32_t pixelX, uint32_t pixelY, uint32_t sampleIndex)
+		{
+			return FromSeed(Hash(sampleIndex) ^ (uint64_t(pixelY) << 20) ^ pixelX);
+		}
+
+		//SplitMix64 finalizer, a bijection so different values never hash the same
+		static uint64_t Hash(uint64_t value)
+		{
+			value += 0x9E3779B97F4A7C15ull;
+			value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+			value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+			return value ^ (value >> 31);
+		}
+
+		uint32_t NextUInt()
+		{
+			const uint64_t oldState{ state };
+			state = oldState * MULTIPLIER + INCREMENT;
+
+			const uint32_t xorShifted{ uint32_t(((oldState >> 18u) ^ oldState) >> 27u) };
+			const uint32_t rotation{ uint32_t(oldState >> 59u) };
+			return (xorShifted >> rotation) | (xorShifted << ((32u - rotation) & 31u));
+		}
+
+		//[0, 1), 24 bits so every value is exactly representable as a float
+		float NextFloat()
+		{
+			return float(NextUInt() >> 8) * (1.f / 16777216.f);
+		}
+	};
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include <cstdint>
+
+#include "Threading.h"
+
+//Comment out (or define DISABLE_RAY_STATS for the build) to compile every RAY_STATS_INC away
+#if !defined(DISABLE_RAY_STATS)
+#define ENABLE_RAY_STATS
+#endif
+
+namespace dae
+{
+	struct RayStats
+	{
+		uint64_t primaryRays{};
+		uint64_t shadowRays{};
+		uint64_t secondaryRays{}; //Bounces of the path tracer
+
+		uint64_t sphereTests{};
+		uint64_t planeTests{};
+		uint64_t triangleTests{};
+
+		uint64_t slabTestsPassed{};
+		uint64_t slabTestsFailed{};
+
+		uint64_t nodeVisits{}; //Acceleration structure nodes visited
+
+		uint64_t GetTotalRays() const { return primaryRays + shadowRays + secondaryRays; }
+		uint64_t GetTotalPrimitiveTests() const { return sphereTests + planeTests + triangleTests; }
+
+		RayStats& operator+=(const RayStats& other)
+		{
+			primaryRays += other.primaryRays;
+			shadowRays += other.shadowRays;
+			secondaryRays += other.secondaryRays;
+			sphereTests += other.sphereTests;
+			planeTests += other.planeTests;
+			triangleTests += other.triangleTests;
+			slabTestsPassed += other.slabTestsPassed;
+			slabTestsFailed += other.slabTestsFailed;
+			nodeVisits += other.nodeVisits;
+
+			return *this;
+		}
+	};
+
+	/**
+	 * \brief Per-thread ray counters. Threads only increment their own (cache line padded) counters,
+	 * which are merged once at the end of a frame while no worker is rendering.
+	 */
+	namespace RayStatistics
+	{
+		struct alignas(64) ThreadStats
+		{
+			RayStats stats{};
+		};
+
+		inline ThreadStats g_ThreadStats[MAX_THREAD_SLOTS]{};
+
+		inline RayStats& Local()
+		{
+			thread_local RayStats& stats{ g_ThreadStats[GetThreadSlot()].stats };
+			return stats;
+		}
+
+		//Sums the counters of all threads and clears them for the next frame
+		inline RayStats MergeAndReset()
+		{
+			RayStats merged{};
+			for (ThreadStats& threadStats : g_ThreadStats)
+			{
+				merged += threadStats.stats;
+				threadStats.stats = {};
+			}
+
+			return merged;
+		}
+	}
+}
+
+#if defined(ENABLE_RAY_STATS)
+#define RAY_STATS_INC(counter) (++::dae::RayStatistics::Local().counter)
+#else
+#define RAY_STATS_INC(counter) ((void)0)
+#endif
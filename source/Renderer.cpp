@@ -1,17 +1,29 @@
 //External includes
+#if !defined(HEADLESS)
 #include "SDL.h"
 #include "SDL_surface.h"
+#endif
 
 //Project includes
 #include "Renderer.h"
+#include "AreaLights.h"
 #include "Math.h"
 #include "Matrix.h"
 #include "Material.h"
 #include "Scene.h"
 #include "Utils.h"
-
+#include "Profiler.h"
+#include "RayStats.h"
+#include "CpuFeatures.h"
+#include "ImageSink.h"
+#include "LightTree.h"
+#include "PathTracer.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <fstream>
 #include <future>
-#include <ppl.h>
 
 using namespace dae;
 
@@ -19,6 +31,7 @@ using namespace dae;
 #define PARALLEL
 
 
+#if !defined(HEADLESS)
 Renderer::Renderer(SDL_Window * pWindow) :
 	m_pWindow(pWindow),
 	m_pBuffer(SDL_GetWindowSurface(pWindow))
@@ -26,46 +39,218 @@ Renderer::Renderer(SDL_Window * pWindow) :
 	//Initialize
 	SDL_GetWindowSize(pWindow, &m_Width, &m_Height);
 	m_pBufferPixels = static_cast<uint32_t*>(m_pBuffer->pixels);
+
+	//The tone mapper packs 32 bit pixels itself, straight into the window's format
+	assert(m_pBuffer->format->BytesPerPixel == 4);
+	m_PixelLayout = { m_pBuffer->format->Rshift, m_pBuffer->format->Gshift, m_pBuffer->format->Bshift, m_pBuffer->format->Amask };
+
+	for (FrameBuffer& frameBuffer : m_FrameBuffers)
+	{
+		frameBuffer.hdrBuffer.Resize(m_Width, m_Height);
+		frameBuffer.costBuffer.resize(size_t(m_Width) * m_Height);
+	}
+	m_PrimaryHits.resize(size_t(m_Width) * m_Height);
+}
+
+Renderer::Renderer(int width, int height) :
+	m_pBuffer(SDL_CreateRGBSurfaceWithFormat(0, width, height, 32, SDL_PIXELFORMAT_ARGB8888)),
+	m_OwnsBuffer(true),
+	m_Width(width),
+	m_Height(height)
+{
+	m_pBufferPixels = static_cast<uint32_t*>(m_pBuffer->pixels);
+	m_PixelLayout = { m_pBuffer->format->Rshift, m_pBuffer->format->Gshift, m_pBuffer->format->Bshift, m_pBuffer->format->Amask };
+
+	for (FrameBuffer& frameBuffer : m_FrameBuffers)
+	{
+		frameBuffer.hdrBuffer.Resize(m_Width, m_Height);
+		frameBuffer.costBuffer.resize(size_t(m_Width) * m_Height);
+	}
+	m_PrimaryHits.resize(size_t(m_Width) * m_Height);
 }
 
-void Renderer::Render(Scene* pScene) const
+Renderer::~Renderer()
 {
-	Camera& camera = pScene->GetCamera();
+	if (m_OwnsBuffer)
+		SDL_FreeSurface(m_pBuffer);
+}
+#else
+Renderer::Renderer(int width, int height) :
+	m_Width(width),
+	m_Height(height)
+{
+	m_PixelStorage.resize(size_t(m_Width) * m_Height);
+	m_pBufferPixels = m_PixelStorage.data();
+
+	for (FrameBuffer& frameBuffer : m_FrameBuffers)
+	{
+		frameBuffer.hdrBuffer.Resize(m_Width, m_Height);
+		frameBuffer.costBuffer.resize(size_t(m_Width) * m_Height);
+	}
+	m_PrimaryHits.resize(size_t(m_Width) * m_Height);
+}
+
+Renderer::~Renderer() = default;
+#endif
+
+void Renderer::Render(Scene* pScene)
+{
+	const uint32_t frameBufferIndex{ (m_LastTracedFrameBuffer + 1) % NUM_FRAME_BUFFERS };
+
+	TraceFrame(pScene, frameBufferIndex);
+	PresentFrame(frameBufferIndex, true);
+	ShowFrame();
+}
+
+void Renderer::TraceFrame(Scene* pScene, uint32_t frameBufferIndex)
+{
+	FrameBuffer& frameBuffer{ m_FrameBuffers[frameBufferIndex] };
+	const LightingMode lightingMode{ m_CurrentLightingMode };
+	const HeatmapMetric heatmapMetric{ m_CurrentHeatmapMetric };
+	frameBuffer.isHeatmap = lightingMode == LightingMode::Heatmap;
+
+	//A copy, the scene's camera may be read by the next frame's update at the same time
+	Camera camera{ pScene->GetCamera() };
 	auto& materials = pScene->GetMaterials();
 	auto& lights = pScene->GetLights();
 
-	const float aspectRatio{ float(m_Width) / m_Height };
-	const float fov{ tanf(camera.fovAngle * TO_RADIANS/2) };
-	camera.CalculateCameraToWorld();
+	const ImagePlane imagePlane{ m_Width, m_Height, tanf(camera.fovAngle * TO_RADIANS/2), float(m_Width) / m_Height };
+	{
+		PROFILE_SCOPE("Camera::CalculateCameraToWorld");
+		camera.CalculateCameraToWorld();
+	}
+
+	const uint32_t numTilesX{ (uint32_t(m_Width) + TILE_SIZE - 1) / TILE_SIZE };
+	const uint32_t numTilesY{ (uint32_t(m_Height) + TILE_SIZE - 1) / TILE_SIZE };
+	const uint32_t numOfTiles{ numTilesX * numTilesY };
+
+	const bool shadowsEnabled{ m_ShadowsEnabled };
+	const TracePixelFunction pTracePixel{ SelectTracePixel(lightingMode, shadowsEnabled, lights) };
+
+	//Tiles only shade the lights whose influence radius reaches into them. Path tracing shades bounces outside of the tile, so it keeps all lights
+	const bool cullLights{ lightingMode != LightingMode::PathTraced && TileLightLists::HasBoundedLights(lights) };
+	if (cullLights) {
+		PROFILE_SCOPE("TileLightLists::Build");
+		m_TileLightLists.Build(lights, camera, imagePlane, TILE_SIZE);
+	}
+
+	//Heatmaps show the cost of this frame's tracing, history would hide it
+	const bool temporalReuse{ m_TemporalReuseEnabled && lightingMode != LightingMode::Heatmap };
+	if (temporalReuse) {
+		//History only holds what the same lighting mode and shadow setting traced
+		if (lightingMode != m_TemporalLightingMode || shadowsEnabled != m_TemporalShadowsEnabled) {
+			m_TemporalCache.Reset();
+			m_TemporalLightingMode = lightingMode;
+			m_TemporalShadowsEnabled = shadowsEnabled;
+		}
+
+		m_TemporalCache.BeginFrame(m_Width, m_Height);
+	}
+	else {
+		//Turned back on later, the camera will have moved without it
+		m_TemporalCache.Reset();
+	}
+
+	//Heatmaps show the cost of tracing, there's nothing to smooth
+	const bool denoise{ m_DenoiserEnabled && lightingMode != LightingMode::Heatmap };
+
+	//Both find their pixels' surfaces in the primary hits of the frame's own samples
+	const bool recordPrimaryHits{ denoise || temporalReuse };
+
+	const uint32_t sampleIndex{ m_FrameIndex++ };
+	HdrBuffer& hdrBuffer{ frameBuffer.hdrBuffer };
+	std::vector<float>& costBuffer{ frameBuffer.costBuffer };
 
-	const uint32_t numOfPixels{ uint32_t(m_Width * m_Height) };
+	const auto renderTile = [=, this, &camera, &hdrBuffer, &costBuffer](uint32_t tileIndex) {
+		PROFILE_SCOPE("Renderer::RenderTile");
+
+		const uint32_t tileStartX{ (tileIndex % numTilesX) * TILE_SIZE };
+		const uint32_t tileStartY{ (tileIndex / numTilesX) * TILE_SIZE };
+		const uint32_t tileEndX{ std::min(tileStartX + TILE_SIZE, uint32_t(m_Width)) };
+		const uint32_t tileEndY{ std::min(tileStartY + TILE_SIZE, uint32_t(m_Height)) };
+
+		//The light mix of a culled tile may differ from the whole scene's
+		const std::vector<Light>& tileLights{ cullLights ? m_TileLightLists.GetTileLights(tileIndex) : lights };
+		const TracePixelFunction pTileTracePixel{ cullLights ? SelectTracePixel(lightingMode, shadowsEnabled, tileLights) : pTracePixel };
+
+		if (lightingMode == LightingMode::Heatmap) {
+			for (uint32_t py{ tileStartY }; py < tileEndY; ++py) {
+				for (uint32_t px{ tileStartX }; px < tileEndX; ++px) {
+					const uint32_t pixelIndex{ px + (py * m_Width) };
+
+					const uint64_t costBefore{ GetPixelCost(heatmapMetric) };
+					hdrBuffer.SetPixel(pixelIndex, pTileTracePixel(pScene, px + 0.5f, py + 0.5f, sampleIndex, imagePlane, camera, tileLights, materials, nullptr));
+					costBuffer[pixelIndex] = float(GetPixelCost(heatmapMetric) - costBefore);
+				}
+			}
+			return;
+		}
+
+		for (uint32_t py{ tileStartY }; py < tileEndY; ++py) {
+			for (uint32_t px{ tileStartX }; px < tileEndX; ++px) {
+				const uint32_t pixelIndex{ px + (py * m_Width) };
+				PrimaryHit* const pPrimaryHit{ recordPrimaryHits ? &m_PrimaryHits[pixelIndex] : nullptr };
+
+				if (!temporalReuse) {
+					//Linear radiance, tone mapping and packing happen in a separate pass
+					hdrBuffer.SetPixel(pixelIndex, pTileTracePixel(pScene, px + 0.5f, py + 0.5f, sampleIndex, imagePlane, camera, tileLights, materials, pPrimaryHit));
+					continue;
+				}
+
+				const uint32_t pixelSampleIndex{ m_TemporalCache.GetSampleIndex(pixelIndex) };
+				ColorRGB radiance{};
+				uint32_t numSamples{};
+				uint32_t numTracedSamples{ 0 };
+				if (m_TemporalCache.IsSkipTurn(pixelIndex)) {
+					//Whether its history is enough only shows once its primary hit is known. If not, the first sample traces it again
+					*pPrimaryHit = TracePrimaryHit(pScene, px + 0.5f, py + 0.5f, imagePlane, camera, materials);
+					numSamples = m_TemporalCache.Reproject(pixelIndex, *pPrimaryHit);
+				}
+				else {
+					radiance = pTileTracePixel(pScene, px + 0.5f, py + 0.5f, pixelSampleIndex, imagePlane, camera, tileLights, materials, pPrimaryHit);
+					numSamples = m_TemporalCache.Reproject(pixelIndex, *pPrimaryHit);
+					numTracedSamples = 1;
+				}
+
+				//Pixels without history would look noisier than their neighbours with only this frame's sample
+				for (; numTracedSamples < numSamples; ++numTracedSamples) {
+					radiance += pTileTracePixel(pScene, px + 0.5f, py + 0.5f, pixelSampleIndex + numTracedSamples, imagePlane, camera, tileLights, materials, nullptr);
+				}
+
+				//Pixels that take no sample show their history, Accumulate fills them in
+				if (numSamples > 0) {
+					hdrBuffer.SetPixel(pixelIndex, radiance / float(numSamples));
+				}
+			}
+		}
+	};
 
 #if defined(ASYNC)
 	// Async execution
 	const uint32_t numOfCores{ std::thread::hardware_concurrency() };
 	std::vector<std::future<void>> asyncFutures{};
-	const uint32_t numPixelPerTask{ numOfPixels / numOfCores };
-	uint32_t numUnassignedPixels{ numOfPixels % numOfCores };
-	uint32_t currentPixelIndex{ 0 };
+	const uint32_t numTilesPerTask{ numOfTiles / numOfCores };
+	uint32_t numUnassignedTiles{ numOfTiles % numOfCores };
+	uint32_t currentTileIndex{ 0 };
 
 	for (uint32_t coreId{ 0 }; coreId < numOfCores; ++coreId) {
 
-		uint32_t taskSize{ numPixelPerTask };
-		if (numUnassignedPixels > 0) {
+		uint32_t taskSize{ numTilesPerTask };
+		if (numUnassignedTiles > 0) {
 			++taskSize;
-			--numUnassignedPixels;
+			--numUnassignedTiles;
 		}
 
-		asyncFutures.push_back(std::async(std::launch::async, [=, this] {
+		asyncFutures.push_back(std::async(std::launch::async, [=] {
 
-			const uint32_t pixelIndexEnd = currentPixelIndex + taskSize;
-			for (uint32_t pixelIndex{ currentPixelIndex }; pixelIndex < pixelIndexEnd; ++pixelIndex) {
-				RenderPixel(pScene, pixelIndex, fov, aspectRatio, camera, lights, materials);
+			const uint32_t tileIndexEnd = currentTileIndex + taskSize;
+			for (uint32_t tileIndex{ currentTileIndex }; tileIndex < tileIndexEnd; ++tileIndex) {
+				renderTile(tileIndex);
 			}
 
 		}));
 
-		currentPixelIndex += taskSize;
+		currentTileIndex += taskSize;
 	}
 
 	for (const std::future<void>& f : asyncFutures) {
@@ -74,112 +259,407 @@ void Renderer::Render(Scene* pScene) const
 
 #elif defined(PARALLEL)
 	// Parallel for execution
-	concurrency::parallel_for(0u, numOfPixels, [=, this](int i) {
-		RenderPixel(pScene, i, fov, aspectRatio, camera, lights, materials);
-	});
+	ParallelFor(0u, numOfTiles, renderTile);
 
 #else
 	// Synchronous execution
-	for (uint32_t pixel{ 0 }; pixel < numOfPixels; ++pixel) {
-		RenderPixel(pScene, pixel, fov, aspectRatio, camera, lights, materials);
+	for (uint32_t tileIndex{ 0 }; tileIndex < numOfTiles; ++tileIndex) {
+		renderTile(tileIndex);
 	}
 
 #endif
 
+	if (temporalReuse) {
+		PROFILE_SCOPE("TemporalCache::Accumulate");
+		m_TemporalCache.Accumulate(hdrBuffer, m_PrimaryHits, camera);
+	}
+
+	if (denoise) {
+		PROFILE_SCOPE("Denoiser");
+		m_Denoiser.SetGuides(m_PrimaryHits, imagePlane, camera);
+		m_Denoiser.Apply(hdrBuffer);
+	}
+
+	//Merge the per-thread ray counters of this frame
+	m_FrameStats = RayStatistics::MergeAndReset();
+	m_LastTracedFrameBuffer = frameBufferIndex;
+}
+
+void Renderer::PresentFrame(uint32_t frameBufferIndex, bool useThreadPool)
+{
+	const FrameBuffer& frameBuffer{ m_FrameBuffers[frameBufferIndex] };
+
+	{
+		PROFILE_SCOPE("ToneMapper::Apply");
+
+		//Chunks are a multiple of the HDR pixel block size
+		constexpr size_t pixelsPerChunk{ 16 * 1024 };
+		const size_t numPixels{ frameBuffer.hdrBuffer.GetPixelCount() };
+		const uint32_t numChunks{ uint32_t((numPixels + pixelsPerChunk - 1) / pixelsPerChunk) };
+
+		const auto toneMapChunk = [&](uint32_t chunkIndex) {
+			const size_t firstPixel{ chunkIndex * pixelsPerChunk };
+			m_ToneMapper.Apply(frameBuffer.hdrBuffer, firstPixel, std::min(pixelsPerChunk, numPixels - firstPixel), m_pBufferPixels, m_PixelLayout);
+		};
+
+		if (useThreadPool) {
+			ParallelFor(0u, numChunks, toneMapChunk);
+		}
+		else {
+			for (uint32_t chunkIndex{ 0 }; chunkIndex < numChunks; ++chunkIndex) {
+				toneMapChunk(chunkIndex);
+			}
+		}
+	}
+
+	if (frameBuffer.isHeatmap) {
+		ColorizeHeatmap(frameBuffer.costBuffer);
+	}
+}
+
+void Renderer::ShowFrame()
+{
 	//@END
 	//Update SDL Surface
-	SDL_UpdateWindowSurface(m_pWindow);
+#if !defined(HEADLESS)
+	if (m_pWindow) {
+		PROFILE_SCOPE("SDL_UpdateWindowSurface");
+		SDL_UpdateWindowSurface(m_pWindow);
+	}
+#endif
 }
 
+#if !defined(HEADLESS)
 bool Renderer::SaveBufferToImage() const
 {
 	return SDL_SaveBMP(m_pBuffer, "RayTracing_Buffer.bmp");
 }
 
+uint32_t Renderer::MapRGB(uint8_t r, uint8_t g, uint8_t b) const
+{
+	return SDL_MapRGB(m_pBuffer->format, r, g, b);
+}
+#else
+//Same convention as SDL_SaveBMP: returns false on success
+bool Renderer::SaveBufferToImage() const
+{
+	std::ofstream fileStream("RayTracing_Buffer.bmp", std::ios::binary);
+	if (!fileStream)
+		return true;
+
+	//32 bit uncompressed BMP, rows stored bottom-up. ARGB8888 in little endian is exactly the BGRA byte order BMP expects
+	const uint32_t rowSize{ uint32_t(m_Width) * 4 };
+	const uint32_t imageSize{ rowSize * uint32_t(m_Height) };
+	constexpr uint32_t headerSize{ 14 + 40 };
+
+	uint8_t header[headerSize]{};
+	const auto write16 = [&](uint32_t offset, uint16_t value) { std::memcpy(header + offset, &value, sizeof(value)); };
+	const auto write32 = [&](uint32_t offset, uint32_t value) { std::memcpy(header + offset, &value, sizeof(value)); };
+
+	header[0] = 'B';
+	header[1] = 'M';
+	write32(2, headerSize + imageSize);
+	write32(10, headerSize);
+	write32(14, 40);
+	write32(18, uint32_t(m_Width));
+	write32(22, uint32_t(m_Height));
+	write16(26, 1);
+	write16(28, 32);
+	write32(34, imageSize);
+
+	fileStream.write(reinterpret_cast<const char*>(header), headerSize);
+	for (int row{ m_Height - 1 }; row >= 0; --row) {
+		fileStream.write(reinterpret_cast<const char*>(m_pBufferPixels + size_t(row) * m_Width), rowSize);
+	}
+
+	return !fileStream.good();
+}
+
+uint32_t Renderer::MapRGB(uint8_t r, uint8_t g, uint8_t b) const
+{
+	return 0xFF000000u | (uint32_t(r) << 16) | (uint32_t(g) << 8) | uint32_t(b);
+}
+#endif
+
+bool Renderer::SaveHdrImage(const std::string& filename) const
+{
+	const std::unique_ptr<ImageSink> pSink{ CreateImageSink(filename, ExrLayout::Scanline, int(TILE_SIZE)) };
+	if (!pSink || !pSink->Begin(m_Width, m_Height))
+		return false;
+
+	const HdrBuffer& hdrBuffer{ m_FrameBuffers[m_LastTracedFrameBuffer].hdrBuffer };
+
+	bool success{ true };
+	for (int tileStartY{ 0 }; tileStartY < m_Height; tileStartY += int(TILE_SIZE))
+	{
+		for (int tileStartX{ 0 }; tileStartX < m_Width; tileStartX += int(TILE_SIZE))
+		{
+			const size_t firstPixel{ size_t(tileStartY) * m_Width + tileStartX };
+
+			ImageTile tile{};
+			tile.x = tileStartX;
+			tile.y = tileStartY;
+			tile.width = std::min(int(TILE_SIZE), m_Width - tileStartX);
+			tile.height = std::min(int(TILE_SIZE), m_Height - tileStartY);
+			tile.pRed = hdrBuffer.red.data() + firstPixel;
+			tile.pGreen = hdrBuffer.green.data() + firstPixel;
+			tile.pBlue = hdrBuffer.blue.data() + firstPixel;
+			tile.rowStride = size_t(m_Width);
+
+			success &= pSink->WriteTile(tile);
+		}
+	}
+
+	return pSink->End() && success;
+}
+
 void Renderer::CycleLightingMode() {
-	m_CurrentLightingMode = LightingMode((int(m_CurrentLightingMode) + 1) % 4);
+	m_CurrentLightingMode = LightingMode((int(m_CurrentLightingMode.load()) + 1) % 6);
+}
+
+void Renderer::CycleHeatmapMetric() {
+	m_CurrentHeatmapMetric = HeatmapMetric((int(m_CurrentHeatmapMetric.load()) + 1) % 2);
+
+#if !defined(ENABLE_RAY_STATS)
+	//Without ray statistics there is nothing to count, time is the only metric left
+	m_CurrentHeatmapMetric = HeatmapMetric::Time;
+#endif
+}
+
+uint64_t Renderer::GetPixelCost(HeatmapMetric heatmapMetric) {
+#if defined(ENABLE_RAY_STATS)
+	if (heatmapMetric == HeatmapMetric::IntersectionTests) {
+		const RayStats& stats{ RayStatistics::Local() };
+		return stats.GetTotalPrimitiveTests() + stats.slabTestsPassed + stats.slabTestsFailed;
+	}
+#endif
+
+	return Profiler::Now();
+}
+
+void Renderer::ColorizeHeatmap(const std::vector<float>& costBuffer) {
+	// Normalize against the most expensive pixel of this frame
+	const float maxCost{ std::max(*std::max_element(costBuffer.begin(), costBuffer.end()), 1.f) };
+
+	// Cold to hot: black > blue > cyan > green > yellow > red
+	constexpr int numRampColors{ 6 };
+	const ColorRGB ramp[numRampColors]{ colors::Black, colors::Blue, colors::Cyan, colors::Green, colors::Yellow, colors::Red };
+
+	for (size_t pixelIndex{ 0 }; pixelIndex < costBuffer.size(); ++pixelIndex) {
+		const float rampPosition{ costBuffer[pixelIndex] / maxCost * (numRampColors - 1) };
+		const int rampIndex{ std::min(int(rampPosition), numRampColors - 2) };
+		const ColorRGB heatColor{ ColorRGB::Lerp(ramp[rampIndex], ramp[rampIndex + 1], rampPosition - rampIndex) };
+
+		m_pBufferPixels[pixelIndex] = MapRGB(
+			static_cast<uint8_t>(heatColor.r * 255),
+			static_cast<uint8_t>(heatColor.g * 255),
+			static_cast<uint8_t>(heatColor.b * 255));
+	}
+}
+
+PrimaryHit Renderer::TracePrimaryHit(Scene* pScene, float x, float y, const ImagePlane& imagePlane, const Camera& camera, const std::vector<Material*>& materials) {
+	HitRecord closestHit{};
+
+	RAY_STATS_INC(primaryRays);
+	pScene->GetClosestHit(imagePlane.GetPrimaryRay(x, y, camera), closestHit);
+
+	if (!closestHit.didHit)
+		return PrimaryHit{};
+
+	return PrimaryHit{ closestHit.origin, closestHit.normal, materials[closestHit.materialIndex]->GetAlbedo(), closestHit.t };
 }
 
-void Renderer::RenderPixel(Scene* pScene, uint32_t pixelIndex, float fov, float aspectRatio, const Camera& camera, const std::vector<Light>& lights, const std::vector<Material*>& materials) const {
-	
-	const int px = pixelIndex % m_Width;
-	const int py = pixelIndex / m_Width;
+Renderer::TracePixelFunction Renderer::SelectTracePixel(LightingMode lightingMode, bool shadowsEnabled, const std::vector<Light>& lights) {
+	const bool onlyPointLights{ std::all_of(lights.begin(), lights.end(), [](const Light& light) { return light.type == LightType::Point; }) };
+	const bool onlyDirectionalLights{ std::all_of(lights.begin(), lights.end(), [](const Light& light) { return light.type == LightType::Directional; }) };
+
+	LightMix lightMix{ LightMix::Mixed };
+	if (lights.size() > LightTree::SAMPLING_THRESHOLD)
+		lightMix = LightMix::ManyLights;
+	else if (onlyPointLights)
+		lightMix = LightMix::PointOnly;
+	else if (onlyDirectionalLights)
+		lightMix = LightMix::DirectionalOnly;
+
+	switch (lightingMode) {
+	case LightingMode::ObservedArea:
+		return SelectTracePixel<LightingMode::ObservedArea>(shadowsEnabled, lightMix);
+	case LightingMode::Radiance:
+		return SelectTracePixel<LightingMode::Radiance>(shadowsEnabled, lightMix);
+	case LightingMode::BRDF:
+		return SelectTracePixel<LightingMode::BRDF>(shadowsEnabled, lightMix);
+	case LightingMode::PathTraced:
+		return shadowsEnabled ? &PathTracer::TracePixel<true> : &PathTracer::TracePixel<false>;
+	case LightingMode::Combined:
+	case LightingMode::Heatmap:
+	default:
+		return SelectTracePixel<LightingMode::Combined>(shadowsEnabled, lightMix);
+	}
+}
 
-	Vector3 rayDirection{};
-	rayDirection.x = ((2 * (px + 0.5f) / m_Width) - 1) * aspectRatio * fov;
-	rayDirection.y = (1 - (2 * (py + 0.5f) / m_Height)) * fov;
-	rayDirection.z = 1;
-	rayDirection.Normalize();
+template<Renderer::LightingMode lightingMode>
+Renderer::TracePixelFunction Renderer::SelectTracePixel(bool shadowsEnabled, LightMix lightMix) {
+	return shadowsEnabled ?
+		SelectTracePixel<lightingMode, true>(lightMix) :
+		SelectTracePixel<lightingMode, false>(lightMix);
+}
 
-	rayDirection = camera.cameraToWorld.TransformVector(rayDirection);
+template<Renderer::LightingMode lightingMode, bool shadowsEnabled>
+Renderer::TracePixelFunction Renderer::SelectTracePixel(LightMix lightMix) {
+	switch (lightMix) {
+	case LightMix::PointOnly:
+		return &Renderer::TracePixel<lightingMode, shadowsEnabled, LightMix::PointOnly>;
+	case LightMix::DirectionalOnly:
+		return &Renderer::TracePixel<lightingMode, shadowsEnabled, LightMix::DirectionalOnly>;
+	case LightMix::ManyLights:
+		return &Renderer::TracePixel<lightingMode, shadowsEnabled, LightMix::ManyLights>;
+	case LightMix::Mixed:
+	default:
+		return &Renderer::TracePixel<lightingMode, shadowsEnabled, LightMix::Mixed>;
+	}
+}
 
-	Ray hitRay{ camera.origin, rayDirection };
+template<Renderer::LightingMode lightingMode, bool shadowsEnabled, Renderer::LightMix lightMix>
+HOT_KERNEL ColorRGB Renderer::TracePixel(Scene* pScene, float x, float y, uint32_t sampleIndex, const ImagePlane& imagePlane, const Camera& camera, const std::vector<Light>& lights, const std::vector<Material*>& materials, PrimaryHit* pPrimaryHit) {
+
+	const Ray hitRay{ imagePlane.GetPrimaryRay(x, y, camera) };
 
 	ColorRGB finalColor{ 0,0,0 };
 	HitRecord closestHit{};
 
+	RAY_STATS_INC(primaryRays);
 	pScene->GetClosestHit(hitRay, closestHit);
 
+	if (pPrimaryHit) {
+		*pPrimaryHit = closestHit.didHit
+			? PrimaryHit{ closestHit.origin, closestHit.normal, materials[closestHit.materialIndex]->GetAlbedo(), closestHit.t }
+			: PrimaryHit{};
+	}
+
 	if (closestHit.didHit) {
-		for (const Light& light : lights) {
+		// Light sampling (area lights, the light tree) only depends on the pixel and sample index
+		Sampler sampler{ imagePlane.samplerType, uint32_t(x), uint32_t(y), sampleIndex, Sampler::PIXEL_DIMENSIONS };
+
+		// Area lights average the contribution of several points on the light, each with its own shadow ray
+		const auto shadeAreaLight = [&](const Light& light) -> ColorRGB {
+			const auto shadeSample = [&](const AreaLights::LightSample& sample) -> ColorRGB {
+				const float cosineLaw{ Vector3::Dot(closestHit.normal, sample.toLightDirection) };
+				if (cosineLaw < 0)
+					return ColorRGB{};
+
+				if constexpr (lightingMode == LightingMode::ObservedArea) {
+					return ColorRGB{ cosineLaw, cosineLaw, cosineLaw };
+				}
+				else if constexpr (lightingMode == LightingMode::Radiance) {
+					return sample.radiance;
+				}
+				else if constexpr (lightingMode == LightingMode::BRDF) {
+					return materials[closestHit.materialIndex]->Shade(closestHit, sample.toLightDirection, -hitRay.direction);
+				}
+				else {
+					return sample.radiance * materials[closestHit.materialIndex]->Shade(closestHit, sample.toLightDirection, -hitRay.direction) * cosineLaw;
+				}
+			};
+
+			const auto isOccluded = [&](const AreaLights::LightSample& sample) {
+				Ray toLight{ closestHit.origin + closestHit.normal * 0.001f, sample.toLightDirection };
+				toLight.max = sample.distance;
+
+				RAY_STATS_INC(shadowRays);
+				return pScene->DoesHit(toLight);
+			};
+
+			return AreaLights::Estimate<shadowsEnabled>(light, closestHit.origin, sampler, shadeSample, isOccluded);
+		};
+
+		// Contribution of a single light to the hit
+		const auto shadeLight = [&](const Light& light) -> ColorRGB {
+			if constexpr (lightMix == LightMix::Mixed || lightMix == LightMix::ManyLights) {
+				if (AreaLights::IsAreaLight(light))
+					return shadeAreaLight(light);
+			}
+
 
 			// Vector from hit to light
 			Vector3 toLightDirection{ LightUtils::GetDirectionToLight(light, closestHit.origin) };
-			float distanceToLight{ toLightDirection.Magnitude() };
-			toLightDirection.Normalize();
+			const float sqrDistanceToLight{ toLightDirection.SqrMagnitude() };
+			const float distanceToLight{ sqrtf(sqrDistanceToLight) };
+			toLightDirection /= distanceToLight;
 
 			// Outgoing light direction (depends on light type)
-			Vector3 lightDirection{ light.direction };
-			if (light.type == LightType::Point) {
-				lightDirection = toLightDirection;
+			bool isPointLight{ lightMix == LightMix::PointOnly };
+			if constexpr (lightMix == LightMix::Mixed || lightMix == LightMix::ManyLights) {
+				isPointLight = light.type == LightType::Point;
 			}
 
+			// Bounded lights don't reach beyond their influence radius
+			ColorRGB radiance{};
+			if (!LightUtils::GetPunctualRadiance(light, sqrDistanceToLight, isPointLight, radiance))
+				return ColorRGB{};
+
+			const Vector3& lightDirection{ isPointLight ? toLightDirection : light.direction };
+
 			// Cosine Law
-			float cosineLaw{ Vector3::Dot(closestHit.normal, lightDirection) };
+			const float cosineLaw{ Vector3::Dot(closestHit.normal, lightDirection) };
 
 			// Light hits the surface
-			if (cosineLaw >= 0) {
+			if (cosineLaw < 0)
+				return ColorRGB{};
 
-				// Illumination is direct (so nothing between surface and light) or shadows are ignored
-				Vector3 startPoint{ closestHit.origin + closestHit.normal * 0.001f };
-				Ray toLight{ startPoint, toLightDirection };
+			// Illumination is direct (so nothing between surface and light) or shadows are ignored
+			if constexpr (shadowsEnabled) {
+				Ray toLight{ closestHit.origin + closestHit.normal * 0.001f, toLightDirection };
 				toLight.max = distanceToLight;
-				if (!pScene->DoesHit(toLight) || !m_ShadowsEnabled) {
-
-					// Radiance
-					ColorRGB radiance{ LightUtils::GetRadiance(light,closestHit.origin) };
 
-					// BRDF color
-					ColorRGB BRDFColor{ materials[closestHit.materialIndex]->Shade(closestHit, toLightDirection, -hitRay.direction) };
+				RAY_STATS_INC(shadowRays);
+				if (pScene->DoesHit(toLight))
+					return ColorRGB{};
+			}
 
-					switch (m_CurrentLightingMode) {
-					case LightingMode::ObservedArea:
-						finalColor += ColorRGB{ cosineLaw, cosineLaw, cosineLaw };
-						break;
+			if constexpr (lightingMode == LightingMode::ObservedArea) {
+				return ColorRGB{ cosineLaw, cosineLaw, cosineLaw };
+			}
 
-					case LightingMode::Radiance:
-						finalColor += radiance;
-						break;
+			// BRDF color
+			ColorRGB BRDFColor{};
+			if constexpr (lightingMode != LightingMode::Radiance) {
+				BRDFColor = materials[closestHit.materialIndex]->Shade(closestHit, toLightDirection, -hitRay.direction);
+			}
 
-					case LightingMode::BRDF:
-						finalColor += BRDFColor;
-						break;
+			if constexpr (lightingMode == LightingMode::Radiance) {
+				return radiance;
+			}
+			else if constexpr (lightingMode == LightingMode::BRDF) {
+				return BRDFColor;
+			}
+			else {
+				return radiance * BRDFColor * cosineLaw;
+			}
+		};
+
+		if constexpr (lightMix == LightMix::ManyLights) {
+			// Directional lights are always shaded, a few point lights are picked by their estimated contribution.
+			// The tree indexes the scene's lights, which may be more than the given (culled) ones
+			const LightTree& lightTree{ pScene->GetLightTree() };
+			const std::vector<Light>& sceneLights{ pScene->GetLights() };
+			for (const uint32_t lightIndex : lightTree.GetInfiniteLights()) {
+				finalColor += shadeLight(sceneLights[lightIndex]);
+			}
 
-					case LightingMode::Combined:
-						finalColor += radiance * BRDFColor * cosineLaw;
-						break;
-					}
+			for (uint32_t sampleIdx{ 0 }; sampleIdx < LightTree::NUM_LIGHT_SAMPLES; ++sampleIdx) {
+				uint32_t lightIndex{};
+				float lightPmf{};
+				if (lightTree.Sample(closestHit.origin, closestHit.normal, sampler.NextFloat(), lightIndex, lightPmf)) {
+					finalColor += shadeLight(sceneLights[lightIndex]) / (LightTree::NUM_LIGHT_SAMPLES * lightPmf);
 				}
 			}
 		}
+		else {
+			for (const Light& light : lights) {
+				finalColor += shadeLight(light);
+			}
+		}
 	}
 
-	//Update Color in Buffer
-	finalColor.MaxToOne();
-
-	m_pBufferPixels[px + (py * m_Width)] = SDL_MapRGB(m_pBuffer->format,
-		static_cast<uint8_t>(finalColor.r * 255),
-		static_cast<uint8_t>(finalColor.g * 255),
-		static_cast<uint8_t>(finalColor.b * 255));
-
-}
\ No newline at end of file
+	return finalColor;
+}
@@ -1,10 +1,19 @@
 #pragma once
 
+#include <atomic>
 #include <cstdint>
+#include <string>
 #include <vector>
 #include "Camera.h"
 #include "Material.h"
 #include "DataTypes.h"
+#include "Denoiser.h"
+#include "HdrBuffer.h"
+#include "RayStats.h"
+#include "Sampler.h"
+#include "TemporalCache.h"
+#include "TileLightLists.h"
+#include "ToneMapper.h"
 
 struct SDL_Window;
 struct SDL_Surface;
@@ -13,37 +22,163 @@ namespace dae
 {
 	class Scene;
 
+	//Size of the image and the camera frustum its pixels map to, fixed for a whole frame
+	struct ImagePlane
+	{
+		int width{};
+		int height{};
+		float fov{}; //tan(fovAngle / 2)
+		float aspectRatio{};
+		//Where the sample values of every pixel come from, for the modes that draw them
+		SamplerType samplerType{ SamplerType::Sobol };
+
+		//Primary ray through (x, y), in pixels (pixel centers are at +0.5)
+		Ray GetPrimaryRay(float x, float y, const Camera& camera) const
+		{
+			Vector3 rayDirection{};
+			rayDirection.x = ((2 * x / width) - 1) * aspectRatio * fov;
+			rayDirection.y = (1 - (2 * y / height)) * fov;
+			rayDirection.z = 1;
+			rayDirection.Normalize();
+
+			return Ray{ camera.origin, camera.cameraToWorld.TransformVector(rayDirection) };
+		}
+	};
+
 	class Renderer final
 	{
 	public:
+#if !defined(HEADLESS)
 		Renderer(SDL_Window* pWindow);
-		~Renderer() = default;
+#endif
+		//Headless: renders into an offscreen surface of the given size
+		Renderer(int width, int height);
+		~Renderer();
 
 		Renderer(const Renderer&) = delete;
 		Renderer(Renderer&&) noexcept = delete;
 		Renderer& operator=(const Renderer&) = delete;
 		Renderer& operator=(Renderer&&) noexcept = delete;
 
-		void Render(Scene* pScene) const;
-		void RenderPixel(Scene* pScene, uint32_t pixelIndex, float fov, float aspectRatio, const Camera& camera, const std::vector<Light>& lights, const std::vector<Material*>& materials) const;
+		//Traces pScene and presents it right away
+		void Render(Scene* pScene);
+
+		//The parts of Render, so a FramePipeline can present one frame while tracing the next.
+		//A frame is traced into and presented from the same frame buffer, different frame buffers may be in use at the same time
+		static constexpr uint32_t NUM_FRAME_BUFFERS{ 2 };
+		//Only reads pScene, its camera included
+		void TraceFrame(Scene* pScene, uint32_t frameBufferIndex);
+		//Tone maps into the window surface. Without the thread pool, so it doesn't wait for a trace holding it
+		void PresentFrame(uint32_t frameBufferIndex, bool useThreadPool);
+		//Shows the window surface. SDL only allows it on the thread that created the window, and not while PresentFrame writes the surface
+		void ShowFrame();
 
 		bool SaveBufferToImage() const;
+		//Writes the linear radiance of the last traced frame, before tone mapping (.pfm or .exr). Returns true on success
+		bool SaveHdrImage(const std::string& filename) const;
+
+		const RayStats& GetFrameStats() const { return m_FrameStats; }
 
 		void ToggleShadows() { m_ShadowsEnabled = !m_ShadowsEnabled; }
+		//Returns whether it's on now
+		bool ToggleDenoiser() { m_DenoiserEnabled = !m_DenoiserEnabled; return m_DenoiserEnabled; }
+		//Returns whether it's on now
+		bool ToggleTemporalReuse() { m_TemporalReuseEnabled = !m_TemporalReuseEnabled; return m_TemporalReuseEnabled; }
 		void CycleLightingMode();
+		void CycleHeatmapMetric();
+
+		ToneMapper& GetToneMapper() { return m_ToneMapper; }
+
+		//PathTraced adds indirect light (see PathTracer). Heatmap renders Combined, but displays the cost of every pixel instead
+		enum class LightingMode { ObservedArea, Radiance, BRDF, Combined, PathTraced, Heatmap };
+
+		//Traces a primary ray through (x, y) on the image plane, in pixels (pixel centers are at +0.5), and returns its linear radiance.
+		//The sample index tells samples of the same pixel apart, for the modes that draw sample values.
+		//What the primary ray hit is written to the last argument unless it's null
+		using TracePixelFunction = ColorRGB(*)(Scene*, float, float, uint32_t, const ImagePlane&, const Camera&, const std::vector<Light>&, const std::vector<Material*>&, PrimaryHit*);
+		//Mode, shadow and light type checks are resolved here once per frame, not per pixel and light
+		static TracePixelFunction SelectTracePixel(LightingMode lightingMode, bool shadowsEnabled, const std::vector<Light>& lights);
 
 	private:
+		//Which light types the scene contains, lets TracePixel drop the per-light type check. Area lights are always Mixed.
+		//ManyLights samples a few lights from the scene's LightTree instead of shading all of the given ones
+		enum class LightMix { PointOnly, DirectionalOnly, Mixed, ManyLights };
+
+		//One TracePixel variant per (lighting mode, shadows, light mix)
+		template<LightingMode lightingMode, bool shadowsEnabled, LightMix lightMix>
+		static ColorRGB TracePixel(Scene* pScene, float x, float y, uint32_t sampleIndex, const ImagePlane& imagePlane, const Camera& camera, const std::vector<Light>& lights, const std::vector<Material*>& materials, PrimaryHit* pPrimaryHit);
+
+		//What the primary ray through (x, y) hits, without shading it
+		static PrimaryHit TracePrimaryHit(Scene* pScene, float x, float y, const ImagePlane& imagePlane, const Camera& camera, const std::vector<Material*>& materials);
+
+		template<LightingMode lightingMode>
+		static TracePixelFunction SelectTracePixel(bool shadowsEnabled, LightMix lightMix);
+		template<LightingMode lightingMode, bool shadowsEnabled>
+		static TracePixelFunction SelectTracePixel(LightMix lightMix);
+
+		//Render work is handed out in square tiles of TILE_SIZE x TILE_SIZE pixels
+		static constexpr uint32_t TILE_SIZE{ 32 };
+
 		SDL_Window* m_pWindow{};
 
 		SDL_Surface* m_pBuffer{};
 		uint32_t* m_pBufferPixels{};
+		bool m_OwnsBuffer{ false };
+
+		//Headless builds have no SDL, pixels are stored here as ARGB8888 instead
+		std::vector<uint32_t> m_PixelStorage{};
+		PixelLayout m_PixelLayout{};
+
+		//Everything a traced frame hands over to its presentation
+		struct FrameBuffer
+		{
+			//Tracing writes linear radiance here, the tone mapper turns it into m_pBufferPixels afterwards
+			HdrBuffer hdrBuffer{};
+			//Heatmap frames also store the cost of every pixel
+			std::vector<float> costBuffer{};
+			bool isHeatmap{ false };
+		};
+
+		FrameBuffer m_FrameBuffers[NUM_FRAME_BUFFERS]{};
+		uint32_t m_LastTracedFrameBuffer{ NUM_FRAME_BUFFERS - 1 };
+		//Sample index of the next frame, so sample values differ from frame to frame
+		uint32_t m_FrameIndex{ 0 };
+
+		ToneMapper m_ToneMapper{};
+
+		uint32_t MapRGB(uint8_t r, uint8_t g, uint8_t b) const;
 
 		int m_Width{};
 		int m_Height{};
 
-		bool m_ShadowsEnabled{ true };
+		//Input toggles these while a pipelined frame is being traced, every frame reads them once at its start
+		std::atomic<bool> m_ShadowsEnabled{ true };
+		std::atomic<bool> m_DenoiserEnabled{ false };
+		std::atomic<bool> m_TemporalReuseEnabled{ false };
+
+		//Filters traced frames when enabled, only ever used by TraceFrame
+		Denoiser m_Denoiser{};
+		//Primary hit of every pixel center, recorded by the frame's own samples when the denoiser or the temporal cache need them
+		std::vector<PrimaryHit> m_PrimaryHits{};
+
+		//Colors of past frames, reused after camera moves when enabled. Only ever used by TraceFrame
+		TemporalCache m_TemporalCache{};
+		//What the history was traced with, it's dropped when either changes
+		LightingMode m_TemporalLightingMode{};
+		bool m_TemporalShadowsEnabled{};
+
+		//Lights that reach each tile, rebuilt every frame for scenes with bounded lights
+		TileLightLists m_TileLightLists{};
+
+		//Intersection work done during the last frame
+		RayStats m_FrameStats{};
+
+		std::atomic<LightingMode> m_CurrentLightingMode{ LightingMode::Combined };
+
+		enum class HeatmapMetric { IntersectionTests, Time };
+		std::atomic<HeatmapMetric> m_CurrentHeatmapMetric{ HeatmapMetric::IntersectionTests };
 
-		enum class LightingMode { ObservedArea, Radiance, BRDF, Combined };
-		LightingMode m_CurrentLightingMode{ LightingMode::Combined };
+		static uint64_t GetPixelCost(HeatmapMetric heatmapMetric);
+		void ColorizeHeatmap(const std::vector<float>& costBuffer);
 	};
 }
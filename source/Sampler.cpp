@@ -0,0 +1,162 @@
+#include "Sampler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace dae;
+
+namespace
+{
+	constexpr uint32_t TILE_SIZE{ 64 };
+	constexpr uint32_t NUM_TEXELS{ TILE_SIZE * TILE_SIZE };
+
+	//Ulichney's void-and-cluster: ranks every texel so that, for any n, the texels ranked below n form a blue noise pattern.
+	//Texel values are their rank, so thresholding the tile at any level gives evenly spread points without clumps
+	std::vector<float> BuildBlueNoiseTile()
+	{
+		constexpr float SIGMA{ 1.5f };
+		constexpr uint32_t NUM_INITIAL_POINTS{ NUM_TEXELS / 10 };
+
+		//Gaussian of the toroidal distance, indexed by the (wrapped) offset between two texels
+		std::vector<float> kernel(NUM_TEXELS);
+		for (uint32_t y{ 0 }; y < TILE_SIZE; ++y)
+		{
+			for (uint32_t x{ 0 }; x < TILE_SIZE; ++x)
+			{
+				const float dx{ float(std::min(x, TILE_SIZE - x)) };
+				const float dy{ float(std::min(y, TILE_SIZE - y)) };
+				kernel[y * TILE_SIZE + x] = expf(-(dx * dx + dy * dy) / (2 * SIGMA * SIGMA));
+			}
+		}
+
+		//Adds (or with sign -1 removes) the kernel of one texel to an energy field
+		const auto splat = [&kernel](std::vector<float>& energy, uint32_t texel, float sign) {
+			const uint32_t texelX{ texel % TILE_SIZE };
+			const uint32_t texelY{ texel / TILE_SIZE };
+			for (uint32_t y{ 0 }; y < TILE_SIZE; ++y)
+			{
+				const uint32_t kernelRow{ ((y - texelY) % TILE_SIZE) * TILE_SIZE };
+				for (uint32_t x{ 0 }; x < TILE_SIZE; ++x)
+				{
+					energy[y * TILE_SIZE + x] += sign * kernel[kernelRow + (x - texelX) % TILE_SIZE];
+				}
+			}
+		};
+
+		//The tightest cluster is the set texel with the most energy, the largest void the empty texel with the least
+		const auto findExtreme = [](const std::vector<float>& energy, const std::vector<uint8_t>& isSet, bool wantSet, bool wantHighest) {
+			uint32_t bestTexel{ 0 };
+			bool hasBest{ false };
+			for (uint32_t texel{ 0 }; texel < NUM_TEXELS; ++texel)
+			{
+				if (bool(isSet[texel]) != wantSet)
+					continue;
+
+				if (!hasBest || (wantHighest ? energy[texel] > energy[bestTexel] : energy[texel] < energy[bestTexel]))
+				{
+					bestTexel = texel;
+					hasBest = true;
+				}
+			}
+			return bestTexel;
+		};
+
+		//Initial binary pattern: random points, then the tightest cluster is moved to the largest void until that changes nothing
+		std::vector<uint8_t> isSet(NUM_TEXELS);
+		std::vector<float> energy(NUM_TEXELS);
+
+		Pcg32 rng{ Pcg32::FromSeed(NUM_TEXELS) };
+		for (uint32_t numPoints{ 0 }; numPoints < NUM_INITIAL_POINTS;)
+		{
+			const uint32_t texel{ rng.NextUInt() % NUM_TEXELS };
+			if (isSet[texel])
+				continue;
+
+			isSet[texel] = 1;
+			splat(energy, texel, 1.f);
+			++numPoints;
+		}
+
+		for (uint32_t iteration{ 0 }; iteration < NUM_TEXELS; ++iteration)
+		{
+			const uint32_t cluster{ findExtreme(energy, isSet, true, true) };
+			isSet[cluster] = 0;
+			splat(energy, cluster, -1.f);
+
+			const uint32_t largestVoid{ findExtreme(energy, isSet, false, false) };
+			isSet[largestVoid] = 1;
+			splat(energy, largestVoid, 1.f);
+
+			if (largestVoid == cluster)
+				break;
+		}
+
+		std::vector<uint32_t> ranks(NUM_TEXELS);
+
+		//Phase 1: the initial points are ranked by taking away the tightest cluster, one after the other
+		{
+			std::vector<uint8_t> remaining{ isSet };
+			std::vector<float> remainingEnergy{ energy };
+			for (uint32_t rank{ NUM_INITIAL_POINTS }; rank > 0; --rank)
+			{
+				const uint32_t cluster{ findExtreme(remainingEnergy, remaining, true, true) };
+				remaining[cluster] = 0;
+				splat(remainingEnergy, cluster, -1.f);
+				ranks[cluster] = rank - 1;
+			}
+		}
+
+		//Phase 2: up to half of the tile, the largest void is filled next
+		for (uint32_t rank{ NUM_INITIAL_POINTS }; rank < NUM_TEXELS / 2; ++rank)
+		{
+			const uint32_t largestVoid{ findExtreme(energy, isSet, false, false) };
+			isSet[largestVoid] = 1;
+			splat(energy, largestVoid, 1.f);
+			ranks[largestVoid] = rank;
+		}
+
+		//Phase 3: beyond half the empty texels are the minority, the tightest cluster of empty texels is filled next
+		std::vector<float> emptyEnergy(NUM_TEXELS);
+		for (uint32_t texel{ 0 }; texel < NUM_TEXELS; ++texel)
+		{
+			if (!isSet[texel])
+				splat(emptyEnergy, texel, 1.f);
+		}
+
+		for (uint32_t rank{ NUM_TEXELS / 2 }; rank < NUM_TEXELS; ++rank)
+		{
+			const uint32_t cluster{ findExtreme(emptyEnergy, isSet, false, true) };
+			isSet[cluster] = 1;
+			splat(emptyEnergy, cluster, -1.f);
+			ranks[cluster] = rank;
+		}
+
+		std::vector<float> tile(NUM_TEXELS);
+		for (uint32_t texel{ 0 }; texel < NUM_TEXELS; ++texel)
+		{
+			tile[texel] = (ranks[texel] + 0.5f) / NUM_TEXELS;
+		}
+		return tile;
+	}
+}
+
+const char* dae::ToString(SamplerType samplerType)
+{
+	switch (samplerType)
+	{
+	case SamplerType::Sobol: return "sobol";
+	case SamplerType::BlueNoise: return "blue-noise";
+	case SamplerType::Pcg: return "pcg";
+	default: return "unknown";
+	}
+}
+
+const float* Sampler::GetBlueNoiseTile()
+{
+	static_assert(BLUE_NOISE_TILE_SIZE == TILE_SIZE);
+
+	//Built by the first thread that needs it, the others wait for it
+	static const std::vector<float> tile{ BuildBlueNoiseTile() };
+	return tile.data();
+}
@@ -0,0 +1,181 @@
+#pragma once
+#include <cstdint>
+
+#include "Random.h"
+
+namespace dae
+{
+	//Sobol is Owen-scrambled (well stratified for any sample count), BlueNoise spreads the error over the screen
+	//as high frequency noise that's easier on the eye at low sample counts, Pcg is plain random numbers
+	enum class SamplerType { Sobol, BlueNoise, Pcg };
+
+	const char* ToString(SamplerType samplerType);
+
+	/**
+	 * \brief Sample values for one sample of one pixel, one dimension after the other.
+	 * Every value only depends on (pixel, sample index, dimension), never on the thread or the order pixels are traced in,
+	 * so images come out the same no matter how tiles are scheduled. Samplers are small values that live on the stack of the tracing thread.
+	 * Sobol follows Burley's hash-based Owen scrambling ("Practical Hash-based Owen Scrambling", 2020): every dimension (or pair of
+	 * dimensions for Next2D) is a shuffled, scrambled (0, 2)-sequence of its own, seeded by pixel and dimension.
+	 * BlueNoise shifts a blue noise tile by a different offset per dimension and steps through a golden ratio sequence per sample.
+	 */
+	class Sampler final
+	{
+	public:
+		//Dimensions 0 and 1 place the sample within its pixel, shading draws from the ones after
+		static constexpr uint32_t PIXEL_DIMENSIONS{ 2 };
+
+		Sampler(SamplerType type, uint32_t pixelX, uint32_t pixelY, uint32_t sampleIndex, uint32_t firstDimension = 0) :
+			m_Type{ type },
+			m_PixelX{ pixelX },
+			m_PixelY{ pixelY },
+			m_SampleIndex{ sampleIndex },
+			m_Dimension{ firstDimension },
+			m_PixelSeed{ Hash(pixelX ^ Hash(pixelY)) }
+		{
+			if (m_Type == SamplerType::Pcg)
+			{
+				m_Rng = Pcg32::FromPixelSample(pixelX, pixelY, sampleIndex);
+				for (uint32_t dimension{ 0 }; dimension < firstDimension; ++dimension)
+				{
+					m_Rng.NextUInt();
+				}
+			}
+		}
+
+		//[0, 1) for the next dimension
+		float NextFloat()
+		{
+			const uint32_t dimension{ m_Dimension++ };
+			switch (m_Type)
+			{
+			case SamplerType::Sobol:
+			{
+				const uint32_t seed{ HashCombine(m_PixelSeed, dimension) };
+				const uint32_t index{ NestedUniformScramble(m_SampleIndex, seed) };
+				return ToFloat(NestedUniformScramble(ReverseBits(index), HashCombine(seed, 1)));
+			}
+			case SamplerType::BlueNoise:
+				return BlueNoise(dimension, GOLDEN_RATIO_CONJUGATE);
+			case SamplerType::Pcg:
+			default:
+				return m_Rng.NextFloat();
+			}
+		}
+
+		//[0, 1)^2 for the next two dimensions, stratified together rather than one by one
+		void Next2D(float& u1, float& u2)
+		{
+			const uint32_t dimension{ m_Dimension };
+			m_Dimension += 2;
+
+			switch (m_Type)
+			{
+			case SamplerType::Sobol:
+			{
+				const uint32_t seed{ HashCombine(m_PixelSeed, dimension) };
+				const uint32_t index{ NestedUniformScramble(m_SampleIndex, seed) };
+				u1 = ToFloat(NestedUniformScramble(ReverseBits(index), HashCombine(seed, 1)));
+				u2 = ToFloat(NestedUniformScramble(SobolSecondDimension(index), HashCombine(seed, 2)));
+				break;
+			}
+			case SamplerType::BlueNoise:
+				//R2 sequence steps per sample
+				u1 = BlueNoise(dimension, 0.75487766f);
+				u2 = BlueNoise(dimension + 1, 0.56984029f);
+				break;
+			case SamplerType::Pcg:
+			default:
+				u1 = m_Rng.NextFloat();
+				u2 = m_Rng.NextFloat();
+				break;
+			}
+		}
+
+		static uint32_t ReverseBits(uint32_t value)
+		{
+			value = (value << 16u) | (value >> 16u);
+			value = ((value & 0x00FF00FFu) << 8u) | ((value & 0xFF00FF00u) >> 8u);
+			value = ((value & 0x0F0F0F0Fu) << 4u) | ((value & 0xF0F0F0F0u) >> 4u);
+			value = ((value & 0x33333333u) << 2u) | ((value & 0xCCCCCCCCu) >> 2u);
+			value = ((value & 0x55555555u) << 1u) | ((value & 0xAAAAAAAAu) >> 1u);
+			return value;
+		}
+
+		//24 bits, so every value is exactly representable and below 1
+		static float ToFloat(uint32_t value)
+		{
+			return float(value >> 8) * (1.f / 16777216.f);
+		}
+
+	private:
+		static constexpr float GOLDEN_RATIO_CONJUGATE{ 0.61803399f };
+
+		//Blue noise tile values, BLUE_NOISE_TILE_SIZE^2 of them in [0, 1), built on first use
+		static constexpr uint32_t BLUE_NOISE_TILE_SIZE{ 64 };
+		static const float* GetBlueNoiseTile();
+
+		//Chris Wellons' lowbias32
+		static uint32_t Hash(uint32_t value)
+		{
+			value ^= value >> 16u;
+			value *= 0x7FEB352Du;
+			value ^= value >> 15u;
+			value *= 0x846CA68Bu;
+			value ^= value >> 16u;
+			return value;
+		}
+
+		static uint32_t HashCombine(uint32_t seed, uint32_t value)
+		{
+			return Hash(seed ^ (value + 0x9E3779B9u + (seed << 6u) + (seed >> 2u)));
+		}
+
+		//Owen scrambling of the bits of a value from high to low: every bit is flipped depending on the bits above it
+		static uint32_t NestedUniformScramble(uint32_t value, uint32_t seed)
+		{
+			value = ReverseBits(value);
+
+			//Laine-Karras style permutation with Burley's constants
+			value ^= value * 0x3D20ADEAu;
+			value += seed;
+			value *= (seed >> 16u) | 1u;
+			value ^= value * 0x05526C56u;
+			value ^= value * 0x53A22864u;
+
+			return ReverseBits(value);
+		}
+
+		//Sobol's second dimension (its first is the van der Corput sequence, ReverseBits)
+		static uint32_t SobolSecondDimension(uint32_t index)
+		{
+			uint32_t result{ 0 };
+			for (uint32_t direction{ 1u << 31u }; index != 0; index >>= 1u, direction ^= direction >> 1u)
+			{
+				if (index & 1u)
+					result ^= direction;
+			}
+			return result;
+		}
+
+		float BlueNoise(uint32_t dimension, float stepPerSample) const
+		{
+			const uint32_t shift{ Hash(dimension + 1) };
+			const uint32_t x{ (m_PixelX + shift) % BLUE_NOISE_TILE_SIZE };
+			const uint32_t y{ (m_PixelY + (shift >> 16u)) % BLUE_NOISE_TILE_SIZE };
+
+			//In 32 bit fixed point, so the step stays exact for any sample index and wrapping around 1 is the integer overflow
+			const uint32_t tileValue{ uint32_t(double(GetBlueNoiseTile()[y * BLUE_NOISE_TILE_SIZE + x]) * 4294967296.0) };
+			const uint32_t step{ uint32_t(double(stepPerSample) * 4294967296.0) };
+			return ToFloat(tileValue + m_SampleIndex * step);
+		}
+
+		SamplerType m_Type{};
+		uint32_t m_PixelX{};
+		uint32_t m_PixelY{};
+		uint32_t m_SampleIndex{};
+		uint32_t m_Dimension{};
+		uint32_t m_PixelSeed{};
+		Pcg32 m_Rng{};
+	};
+}
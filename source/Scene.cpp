@@ -1,37 +1,61 @@
 #include "Scene.h"
 #include "Utils.h"
 #include "Material.h"
+#include "CpuFeatures.h"
+#include "Random.h"
 
 namespace dae {
 
 #pragma region Base Scene
 	//Initialize Scene with Default Solid Color Material (RED)
-	Scene::Scene():
-		m_Materials({ new Material_SolidColor({1,0,0})})
+	Scene::Scene()
 	{
 		m_SphereGeometries.reserve(32);
 		m_PlaneGeometries.reserve(32);
 		m_TriangleMeshGeometries.reserve(32);
 		m_Lights.reserve(32);
+		m_Materials.reserve(32);
+
+		AddMaterial<Material_SolidColor>(ColorRGB{ 1,0,0 });
+
+		SetIntersectionAlgorithms(GeometryUtils::DEFAULT_SPHERE_ALGORITHM, GeometryUtils::DEFAULT_TRIANGLE_ALGORITHM);
 	}
 
 	Scene::~Scene()
 	{
+		//Materials live in the scene arena, only their destructors need to run
 		for(auto& pMaterial : m_Materials)
 		{
-			delete pMaterial;
+			pMaterial->~Material();
 			pMaterial = nullptr;
 		}
 
 		m_Materials.clear();
 	}
 
-	void dae::Scene::GetClosestHit(const Ray& ray, HitRecord& closestHit) const
+	void Scene::Initialize()
+	{
+		Populate();
+
+		//The renderers switch to sampling lights through the tree above the threshold, whichever scene has them
+		if (m_Lights.size() > LightTree::SAMPLING_THRESHOLD)
+			m_LightTree.Build(m_Lights);
+	}
+
+	void Scene::Update(Timer* pTimer)
+	{
+		m_Camera.Update(pTimer);
+		Animate(pTimer->GetTotal());
+		m_Camera.CalculateCameraToWorld();
+	}
+
+	template<SphereAlgorithm sphereAlgorithm, TriangleAlgorithm triangleAlgorithm>
+	HOT_KERNEL void Scene::GetClosestHit_Impl(const Ray& ray, HitRecord& closestHit) const
 	{
 		HitRecord tempHit{};
 
 		for (const Sphere& sphere : m_SphereGeometries) {
-			if (GeometryUtils::HitTest_Sphere(sphere, ray, tempHit) && tempHit.t < closestHit.t) {
+			if (GeometryUtils::HitTest_Sphere<sphereAlgorithm>(sphere, ray, tempHit) && tempHit.t < closestHit.t) {
 				closestHit = tempHit;
 			}
 		}
@@ -43,16 +67,19 @@ namespace dae {
 		}
 
 		for (const TriangleMesh& triangle : m_TriangleMeshGeometries) {
-			if (GeometryUtils::HitTest_TriangleMesh(triangle, ray, tempHit) && tempHit.t < closestHit.t) {
+			if (GeometryUtils::HitTest_TriangleMesh<triangleAlgorithm>(triangle, ray, tempHit) && tempHit.t < closestHit.t) {
 				closestHit = tempHit;
 			}
 		}
 	}
 
-	bool Scene::DoesHit(const Ray& ray) const
+	template<SphereAlgorithm sphereAlgorithm, TriangleAlgorithm triangleAlgorithm>
+	HOT_KERNEL bool Scene::DoesHit_Impl(const Ray& ray) const
 	{
+		HitRecord tempHit{};
+
 		for (const Sphere& sphere : m_SphereGeometries) {
-			if (GeometryUtils::HitTest_Sphere(sphere, ray)) {
+			if (GeometryUtils::HitTest_Sphere<sphereAlgorithm>(sphere, ray, tempHit, true)) {
 				return true;
 			};
 		}
@@ -64,7 +91,7 @@ namespace dae {
 		}
 
 		for (const TriangleMesh& triangle : m_TriangleMeshGeometries) {
-			if (GeometryUtils::HitTest_TriangleMesh(triangle, ray)) {
+			if (GeometryUtils::HitTest_TriangleMesh<triangleAlgorithm>(triangle, ray, tempHit, true)) {
 				return true;
 			}
 		}
@@ -72,6 +99,118 @@ namespace dae {
 		return false;
 	}
 
+	void Scene::SetIntersectionAlgorithms(SphereAlgorithm sphereAlgorithm, TriangleAlgorithm triangleAlgorithm)
+	{
+		m_SphereAlgorithm = sphereAlgorithm;
+		m_TriangleAlgorithm = triangleAlgorithm;
+
+		if (sphereAlgorithm == SphereAlgorithm::Analytic) {
+			if (triangleAlgorithm == TriangleAlgorithm::Naive) {
+				m_pGetClosestHit = &Scene::GetClosestHit_Impl<SphereAlgorithm::Analytic, TriangleAlgorithm::Naive>;
+				m_pDoesHit = &Scene::DoesHit_Impl<SphereAlgorithm::Analytic, TriangleAlgorithm::Naive>;
+			}
+			else {
+				m_pGetClosestHit = &Scene::GetClosestHit_Impl<SphereAlgorithm::Analytic, TriangleAlgorithm::MollerTrumbore>;
+				m_pDoesHit = &Scene::DoesHit_Impl<SphereAlgorithm::Analytic, TriangleAlgorithm::MollerTrumbore>;
+			}
+		}
+		else {
+			if (triangleAlgorithm == TriangleAlgorithm::Naive) {
+				m_pGetClosestHit = &Scene::GetClosestHit_Impl<SphereAlgorithm::Geometric, TriangleAlgorithm::Naive>;
+				m_pDoesHit = &Scene::DoesHit_Impl<SphereAlgorithm::Geometric, TriangleAlgorithm::Naive>;
+			}
+			else {
+				m_pGetClosestHit = &Scene::GetClosestHit_Impl<SphereAlgorithm::Geometric, TriangleAlgorithm::MollerTrumbore>;
+				m_pDoesHit = &Scene::DoesHit_Impl<SphereAlgorithm::Geometric, TriangleAlgorithm::MollerTrumbore>;
+			}
+		}
+	}
+
+	void Scene::CalibrateIntersectionAlgorithms()
+	{
+		//Ray set: primary rays on a coarse grid through the current camera + one shadow ray per light for every primary hit
+		constexpr int gridWidth{ 80 };
+		constexpr int gridHeight{ 60 };
+		constexpr int numRuns{ 3 };
+
+		Camera camera{ m_Camera };
+		camera.CalculateCameraToWorld();
+		const float fov{ tanf(camera.fovAngle * TO_RADIANS / 2) };
+		const float aspectRatio{ float(gridWidth) / gridHeight };
+
+		std::vector<Ray> primaryRays{};
+		std::vector<Ray> shadowRays{};
+		primaryRays.reserve(gridWidth * gridHeight);
+
+		const size_t lightStride{ m_Lights.size() > LightTree::SAMPLING_THRESHOLD ? m_Lights.size() / LightTree::NUM_LIGHT_SAMPLES : 1 };
+
+		for (int py{ 0 }; py < gridHeight; ++py) {
+			for (int px{ 0 }; px < gridWidth; ++px) {
+				Vector3 rayDirection{
+					((2 * (px + 0.5f) / gridWidth) - 1) * aspectRatio * fov,
+					(1 - (2 * (py + 0.5f) / gridHeight)) * fov,
+					1 };
+				rayDirection.Normalize();
+				primaryRays.push_back(Ray{ camera.origin, camera.cameraToWorld.TransformVector(rayDirection) });
+
+				HitRecord closestHit{};
+				GetClosestHit(primaryRays.back(), closestHit);
+				if (!closestHit.didHit)
+					continue;
+
+				//With many lights the renderer only traces shadow rays to a few of them, calibrate with as many
+				for (size_t lightIdx{ 0 }; lightIdx < m_Lights.size(); lightIdx += lightStride) {
+					Vector3 toLight{ LightUtils::GetDirectionToLight(m_Lights[lightIdx], closestHit.origin) };
+					Ray shadowRay{ closestHit.origin + closestHit.normal * 0.001f, toLight };
+					shadowRay.max = shadowRay.direction.Normalize();
+					shadowRays.push_back(shadowRay);
+				}
+			}
+		}
+
+		const auto timeAlgorithms = [&](SphereAlgorithm sphereAlgorithm, TriangleAlgorithm triangleAlgorithm) {
+			SetIntersectionAlgorithms(sphereAlgorithm, triangleAlgorithm);
+
+			uint64_t bestNs{ UINT64_MAX };
+			for (int run{ 0 }; run < numRuns; ++run) {
+				const uint64_t startNs{ Profiler::Now() };
+
+				for (const Ray& ray : primaryRays) {
+					HitRecord closestHit{};
+					GetClosestHit(ray, closestHit);
+				}
+
+				for (const Ray& ray : shadowRays) {
+					DoesHit(ray);
+				}
+
+				bestNs = std::min(bestNs, Profiler::Now() - startNs);
+			}
+
+			return bestNs;
+		};
+
+		SphereAlgorithm bestSphereAlgorithm{ GeometryUtils::DEFAULT_SPHERE_ALGORITHM };
+		TriangleAlgorithm bestTriangleAlgorithm{ GeometryUtils::DEFAULT_TRIANGLE_ALGORITHM };
+		uint64_t bestNs{ UINT64_MAX };
+
+		for (const SphereAlgorithm sphereAlgorithm : { SphereAlgorithm::Analytic, SphereAlgorithm::Geometric }) {
+			for (const TriangleAlgorithm triangleAlgorithm : { TriangleAlgorithm::Naive, TriangleAlgorithm::MollerTrumbore }) {
+				const uint64_t ns{ timeAlgorithms(sphereAlgorithm, triangleAlgorithm) };
+				if (ns < bestNs) {
+					bestNs = ns;
+					bestSphereAlgorithm = sphereAlgorithm;
+					bestTriangleAlgorithm = triangleAlgorithm;
+				}
+			}
+		}
+
+		SetIntersectionAlgorithms(bestSphereAlgorithm, bestTriangleAlgorithm);
+
+		//Calibration rays shouldn't show up in the statistics of the first frame
+		RayStatistics::MergeAndReset();
+	}
+
 #pragma region Scene Helpers
 	Sphere* Scene::AddSphere(const Vector3& origin, float radius, unsigned char materialIndex)
 	{
@@ -129,24 +268,69 @@ namespace dae {
 		return &m_Lights.back();
 	}
 
-	unsigned char Scene::AddMaterial(Material* pMaterial)
+	Light* Scene::AddRectLight(const Vector3& center, const Vector3& edgeU, const Vector3& edgeV, float intensity, const ColorRGB& color)
+	{
+		Light l;
+		l.origin = center;
+		l.direction = Vector3::Cross(edgeU, edgeV).Normalized();
+		l.edgeU = edgeU;
+		l.edgeV = edgeV;
+		l.intensity = intensity;
+		l.color = color;
+		l.type = LightType::Rect;
+
+		m_Lights.emplace_back(l);
+		return &m_Lights.back();
+	}
+
+	Light* Scene::AddDiskLight(const Vector3& center, const Vector3& normal, float radius, float intensity, const ColorRGB& color)
+	{
+		Light l;
+		l.origin = center;
+		l.direction = normal.Normalized();
+		l.radius = radius;
+		l.intensity = intensity;
+		l.color = color;
+		l.type = LightType::Disk;
+
+		m_Lights.emplace_back(l);
+		return &m_Lights.back();
+	}
+
+	Light* Scene::AddSphereLight(const Vector3& center, float radius, float intensity, const ColorRGB& color)
 	{
-		m_Materials.push_back(pMaterial);
-		return static_cast<unsigned char>(m_Materials.size() - 1);
+		Light l;
+		l.origin = center;
+		l.radius = radius;
+		l.intensity = intensity;
+		l.color = color;
+		l.type = LightType::Sphere;
+
+		m_Lights.emplace_back(l);
+		return &m_Lights.back();
+	}
+
+	void Scene::LimitLightInfluence(float minRadiance)
+	{
+		for (Light& light : m_Lights)
+		{
+			if (light.type == LightType::Point)
+				light.influenceRadius = LightUtils::GetInfluenceRadius(light, minRadiance);
+		}
 	}
 #pragma endregion
 #pragma endregion
 
 #pragma region SCENE W1
-	void Scene_W1::Initialize()
+	void Scene_W1::Populate()
 	{
 				//default: Material id0 >> SolidColor Material (RED)
 		constexpr unsigned char matId_Solid_Red = 0;
-		const unsigned char matId_Solid_Blue = AddMaterial(new Material_SolidColor{ colors::Blue });
+		const unsigned char matId_Solid_Blue = AddMaterial<Material_SolidColor>(colors::Blue);
 
-		const unsigned char matId_Solid_Yellow = AddMaterial(new Material_SolidColor{ colors::Yellow });
-		const unsigned char matId_Solid_Green = AddMaterial(new Material_SolidColor{ colors::Green });
-		const unsigned char matId_Solid_Magenta = AddMaterial(new Material_SolidColor{ colors::Magenta });
+		const unsigned char matId_Solid_Yellow = AddMaterial<Material_SolidColor>(colors::Yellow);
+		const unsigned char matId_Solid_Green = AddMaterial<Material_SolidColor>(colors::Green);
+		const unsigned char matId_Solid_Magenta = AddMaterial<Material_SolidColor>(colors::Magenta);
 
 		//Spheres
 		AddSphere({ -25.f, 0.f, 100.f }, 50.f, matId_Solid_Red);
@@ -162,18 +346,18 @@ namespace dae {
 #pragma endregion
 
 #pragma region SCENE W2
-	void Scene_W2::Initialize()
+	void Scene_W2::Populate()
 	{
 		m_Camera.origin = { 0.0f,3.0f,-9.0f };
 		m_Camera.fovAngle = 45.0f;
 
 		//default: Material id0 >> SolidColor Material (RED)
 		constexpr unsigned char matId_Solid_Red = 0;
-		const unsigned char matId_Solid_Blue = AddMaterial(new Material_SolidColor{ colors::Blue });
+		const unsigned char matId_Solid_Blue = AddMaterial<Material_SolidColor>(colors::Blue);
 
-		const unsigned char matId_Solid_Yellow = AddMaterial(new Material_SolidColor{ colors::Yellow });
-		const unsigned char matId_Solid_Green = AddMaterial(new Material_SolidColor{ colors::Green });
-		const unsigned char matId_Solid_Magenta = AddMaterial(new Material_SolidColor{ colors::Magenta });
+		const unsigned char matId_Solid_Yellow = AddMaterial<Material_SolidColor>(colors::Yellow);
+		const unsigned char matId_Solid_Green = AddMaterial<Material_SolidColor>(colors::Green);
+		const unsigned char matId_Solid_Magenta = AddMaterial<Material_SolidColor>(colors::Magenta);
 
 		//Plane
 		AddPlane({ -5.f, 0.f, 0.f }, { 1.f, 0.f,0.f }, matId_Solid_Green);
@@ -197,14 +381,14 @@ namespace dae {
 #pragma endregion
 
 #pragma region SCENE W3
-	void Scene_W3_TestScene::Initialize() {
+	void Scene_W3_TestScene::Populate() {
 		m_Camera.origin = { 0.0f,1.0f,-5.0f };
 		m_Camera.fovAngle = 45.0f;
 
 		//default: Material id0 >> SolidColor Material (RED)
-		const unsigned char matId_Solid_Red = AddMaterial(new Material_Lambert{ colors::Red,1.0f });
-		const unsigned char matId_Solid_Blue = AddMaterial(new Material_LambertPhong{ colors::Blue,1.0f, 1.0f, 60.0f });
-		const unsigned char matId_Solid_Yellow = AddMaterial(new Material_Lambert{ colors::Yellow,1.0f });
+		const unsigned char matId_Solid_Red = AddMaterial<Material_Lambert>(colors::Red,1.0f);
+		const unsigned char matId_Solid_Blue = AddMaterial<Material_LambertPhong>(colors::Blue,1.0f, 1.0f, 60.0f);
+		const unsigned char matId_Solid_Yellow = AddMaterial<Material_Lambert>(colors::Yellow,1.0f);
 
 		//Plane
 		AddPlane({ 0.f, 0.f, 0.f }, { 0.f, 1.f,0.f }, matId_Solid_Yellow);
@@ -219,7 +403,7 @@ namespace dae {
 
 	}
 
-	void Scene_W3::Initialize() {
+	void Scene_W3::Populate() {
 		m_Camera.origin = { 0.0f,3.0f,-9.0f };
 		m_Camera.fovAngle = 45.0f;
 
@@ -228,14 +412,14 @@ namespace dae {
 		// Gold: { 1.0f,0.782f,0.344f}
 		// Copper: { 0.955f,0.638f,0.538f }
 		// Platinum: { 0.673f,0.637f,0.585f }
-		const auto matCT_GrayRoughMetal = AddMaterial(new Material_CookTorrence({ 0.972f,0.96f,0.915f }, 1.0f, 1.0f));
-		const auto matCT_GrayMediumMetal = AddMaterial(new Material_CookTorrence({ 0.972f,0.96f,0.915f }, 1.0f, 0.6f));
-		const auto matCT_GraySmoothMetal = AddMaterial(new Material_CookTorrence({ 0.972f,0.96f,0.915f }, 1.0f, 0.1f));
-		const auto matCT_GrayRoughPlastic = AddMaterial(new Material_CookTorrence({ 0.75f,0.75f,0.75f }, 0.0f, 1.0f));
-		const auto matCT_GrayMediumPlastic = AddMaterial(new Material_CookTorrence({ 0.75f,0.75f,0.75f }, 0.0f, 0.6f));
-		const auto matCT_GraySmoothPlastic = AddMaterial(new Material_CookTorrence({ 0.75f,0.75f,0.75f }, 0.0f, 0.1f));
+		const auto matCT_GrayRoughMetal = AddMaterial<Material_CookTorrence>(ColorRGB{ 0.972f,0.96f,0.915f }, 1.0f, 1.0f);
+		const auto matCT_GrayMediumMetal = AddMaterial<Material_CookTorrence>(ColorRGB{ 0.972f,0.96f,0.915f }, 1.0f, 0.6f);
+		const auto matCT_GraySmoothMetal = AddMaterial<Material_CookTorrence>(ColorRGB{ 0.972f,0.96f,0.915f }, 1.0f, 0.1f);
+		const auto matCT_GrayRoughPlastic = AddMaterial<Material_CookTorrence>(ColorRGB{ 0.75f,0.75f,0.75f }, 0.0f, 1.0f);
+		const auto matCT_GrayMediumPlastic = AddMaterial<Material_CookTorrence>(ColorRGB{ 0.75f,0.75f,0.75f }, 0.0f, 0.6f);
+		const auto matCT_GraySmoothPlastic = AddMaterial<Material_CookTorrence>(ColorRGB{ 0.75f,0.75f,0.75f }, 0.0f, 0.1f);
 
-		const auto matLambert_GrayBlue = AddMaterial(new Material_Lambert({ 0.49f,0.57f,0.57f }, 1.0f));
+		const auto matLambert_GrayBlue = AddMaterial<Material_Lambert>(ColorRGB{ 0.49f,0.57f,0.57f }, 1.0f);
 
 		//Plane
 		AddPlane({ 0.f, 0.f, 10.f }, { 0.f, 0.f,-1.f }, matLambert_GrayBlue);
@@ -245,9 +429,9 @@ namespace dae {
 		AddPlane({ -5.f, 0.f, 0.f }, { 1.f, 0.f,0.f }, matLambert_GrayBlue);
 
 		// Temp LambertPhong materials
-		//const auto matLambertPhong1 = AddMaterial(new Material_LambertPhong{ colors::Blue,0.5f, 0.5f, 3.0f });
-		//const auto matLambertPhong2 = AddMaterial(new Material_LambertPhong{ colors::Blue,0.5f, 0.5f, 15.0f });
-		//const auto matLambertPhong3 = AddMaterial(new Material_LambertPhong{ colors::Blue,0.5f, 0.5f, 50.0f });
+		//const auto matLambertPhong1 = AddMaterial<Material_LambertPhong>(colors::Blue,0.5f, 0.5f, 3.0f);
+		//const auto matLambertPhong2 = AddMaterial<Material_LambertPhong>(colors::Blue,0.5f, 0.5f, 15.0f);
+		//const auto matLambertPhong3 = AddMaterial<Material_LambertPhong>(colors::Blue,0.5f, 0.5f, 50.0f);
 
 		//AddSphere({ -1.75f, 1.f, 0.f }, 0.75f, matLambertPhong1);
 		//AddSphere({ 0.f, 1.f, 0.f }, 0.75f, matLambertPhong2);
@@ -271,12 +455,12 @@ namespace dae {
 #pragma endregion
 
 #pragma region SCENE_W4
-	void Scene_W4_TestScene::Initialize() {
+	void Scene_W4_TestScene::Populate() {
 		m_Camera.origin = { 0.0f,1.0f,-5.0f };
 		m_Camera.fovAngle = 45.0f;
 
-		const auto matLambert_GrayBlue = AddMaterial(new Material_Lambert({ 0.49f,0.57f,0.57f }, 1.0f));
-		const auto matLambert_White = AddMaterial(new Material_Lambert(colors::White, 1.0f));
+		const auto matLambert_GrayBlue = AddMaterial<Material_Lambert>(ColorRGB{ 0.49f,0.57f,0.57f }, 1.0f);
+		const auto matLambert_White = AddMaterial<Material_Lambert>(colors::White, 1.0f);
 
 		//Plane
 		AddPlane({ 0.f, 0.f, 10.f }, { 0.f, 0.f,-1.f }, matLambert_GrayBlue);
@@ -308,15 +492,13 @@ namespace dae {
 
 	}
 
-	void Scene_W4_TestScene::Update(Timer* pTimer) {
-		Scene::Update(pTimer);
-
-		pMesh->RotateY(PI_DIV_2 * pTimer->GetTotal());
+	void Scene_W4_TestScene::Animate(float time) {
+		pMesh->RotateY(PI_DIV_2 * time);
 		pMesh->UpdateTransforms();
 	}
 
 	// Reference scene
-	void Scene_W4_ReferenceScene::Initialize() {
+	void Scene_W4_ReferenceScene::Populate() {
 
 		sceneName = "Reference Scene";
 		m_Camera.origin = { 0.0f,3.0f,-9.0f };
@@ -327,15 +509,15 @@ namespace dae {
 		// Gold: { 1.0f,0.782f,0.344f}
 		// Copper: { 0.955f,0.638f,0.538f }
 		// Platinum: { 0.673f,0.637f,0.585f }
-		const auto matCT_GrayRoughMetal = AddMaterial(new Material_CookTorrence({ 0.972f,0.96f,0.915f }, 1.0f, 1.0f));
-		const auto matCT_GrayMediumMetal = AddMaterial(new Material_CookTorrence({ 0.972f,0.96f,0.915f }, 1.0f, 0.6f));
-		const auto matCT_GraySmoothMetal = AddMaterial(new Material_CookTorrence({ 0.972f,0.96f,0.915f }, 1.0f, 0.1f));
-		const auto matCT_GrayRoughPlastic = AddMaterial(new Material_CookTorrence({ 0.75f,0.75f,0.75f }, 0.0f, 1.0f));
-		const auto matCT_GrayMediumPlastic = AddMaterial(new Material_CookTorrence({ 0.75f,0.75f,0.75f }, 0.0f, 0.6f));
-		const auto matCT_GraySmoothPlastic = AddMaterial(new Material_CookTorrence({ 0.75f,0.75f,0.75f }, 0.0f, 0.1f));
+		const auto matCT_GrayRoughMetal = AddMaterial<Material_CookTorrence>(ColorRGB{ 0.972f,0.96f,0.915f }, 1.0f, 1.0f);
+		const auto matCT_GrayMediumMetal = AddMaterial<Material_CookTorrence>(ColorRGB{ 0.972f,0.96f,0.915f }, 1.0f, 0.6f);
+		const auto matCT_GraySmoothMetal = AddMaterial<Material_CookTorrence>(ColorRGB{ 0.972f,0.96f,0.915f }, 1.0f, 0.1f);
+		const auto matCT_GrayRoughPlastic = AddMaterial<Material_CookTorrence>(ColorRGB{ 0.75f,0.75f,0.75f }, 0.0f, 1.0f);
+		const auto matCT_GrayMediumPlastic = AddMaterial<Material_CookTorrence>(ColorRGB{ 0.75f,0.75f,0.75f }, 0.0f, 0.6f);
+		const auto matCT_GraySmoothPlastic = AddMaterial<Material_CookTorrence>(ColorRGB{ 0.75f,0.75f,0.75f }, 0.0f, 0.1f);
 
-		const auto matLambert_GrayBlue = AddMaterial(new Material_Lambert({ 0.49f,0.57f,0.57f }, 1.0f));
-		const auto matLambert_White = AddMaterial(new Material_Lambert(colors::White, 1.0f));
+		const auto matLambert_GrayBlue = AddMaterial<Material_Lambert>(ColorRGB{ 0.49f,0.57f,0.57f }, 1.0f);
+		const auto matLambert_White = AddMaterial<Material_Lambert>(colors::White, 1.0f);
 
 		//Plane
 		AddPlane({ 0.f, 0.f, 10.f }, { 0.f, 0.f,-1.f }, matLambert_GrayBlue);
@@ -379,22 +561,20 @@ namespace dae {
 		AddPointLight({ 2.5f,2.5f,-5.f }, 50.f, ColorRGB{ 0.34f,0.47f,0.68f });
 	}
 
-	void Scene_W4_ReferenceScene::Update(Timer* pTimer) {
-		Scene::Update(pTimer);
-
-		const auto yawAngle{ (cos(pTimer->GetTotal()) + 1.f) / 2.f * PI_2 };
+	void Scene_W4_ReferenceScene::Animate(float time) {
+		const auto yawAngle{ (cos(time) + 1.f) / 2.f * PI_2 };
 		for (auto mesh : m_Meshes) {
 			mesh->RotateY(yawAngle);
 			mesh->UpdateTransforms();
 		}
 	}
 
-	void Scene_W4_BunnyScene::Initialize() {
+	void Scene_W4_BunnyScene::Populate() {
 		m_Camera.origin = { 0.0f,1.0f,-5.0f };
 		m_Camera.fovAngle = 45.0f;
 
-		const auto matLambert_GrayBlue = AddMaterial(new Material_Lambert({ 0.49f,0.57f,0.57f }, 1.0f));
-		const auto matLambert_White = AddMaterial(new Material_Lambert(colors::White, 1.0f));
+		const auto matLambert_GrayBlue = AddMaterial<Material_Lambert>(ColorRGB{ 0.49f,0.57f,0.57f }, 1.0f);
+		const auto matLambert_White = AddMaterial<Material_Lambert>(colors::White, 1.0f);
 
 		//Plane
 		AddPlane({ 0.f, 0.f, 10.f }, { 0.f, 0.f,-1.f }, matLambert_GrayBlue);
@@ -415,14 +595,132 @@ namespace dae {
 
 	}
 
-	void Scene_W4_BunnyScene::Update(Timer* pTimer) {
-		Scene::Update(pTimer);
-
-		const auto yawAngle{ (cos(pTimer->GetTotal()) + 1.f) / 2.f * PI_2 };
+	void Scene_W4_BunnyScene::Animate(float time) {
+		const auto yawAngle{ (cos(time) + 1.f) / 2.f * PI_2 };
 		m_pBunny->RotateY(yawAngle);
 		m_pBunny->UpdateTransforms();
 
 	}
 
 #pragma endregion
+
+#pragma region SCENE MANY LIGHTS
+	void Scene_ManyLights::Populate() {
+		sceneName = "Many Lights Scene";
+		m_Camera.fovAngle = 60.0f;
+		m_Camera.SetPose({ 0.f, 14.f, -46.f }, -0.35f, 0.f);
+
+		const auto matLambert_Street = AddMaterial<Material_Lambert>(ColorRGB{ 0.35f,0.35f,0.38f }, 1.0f);
+		const auto matCT_Building = AddMaterial<Material_CookTorrence>(ColorRGB{ 0.6f,0.62f,0.65f }, 0.0f, 0.5f);
+		const auto matCT_Glass = AddMaterial<Material_CookTorrence>(ColorRGB{ 0.9f,0.9f,0.95f }, 1.0f, 0.2f);
+
+		//Ground
+		AddPlane({ 0.f, 0.f, 0.f }, { 0.f, 1.f,0.f }, matLambert_Street);
+
+		//Blocks between the streets
+		constexpr int numBlocks{ 8 };
+		constexpr float blockSpacing{ 10.f };
+		m_SphereGeometries.reserve(numBlocks * numBlocks);
+		for (int blockZ{ 0 }; blockZ < numBlocks; ++blockZ) {
+			for (int blockX{ 0 }; blockX < numBlocks; ++blockX) {
+				const float radius{ 2.f + float((blockX * 7 + blockZ * 3) % 5) * 0.5f };
+				const Vector3 center{ (blockX - (numBlocks - 1) / 2.f) * blockSpacing, radius * 0.8f, (blockZ - (numBlocks - 1) / 2.f) * blockSpacing };
+				AddSphere(center, radius, (blockX + blockZ) % 3 == 0 ? matCT_Glass : matCT_Building);
+			}
+		}
+
+		//Street lights along both directions of the street grid, in warm and cold tints
+		constexpr int lightsPerStreet{ 64 };
+		constexpr float streetLength{ numBlocks * blockSpacing };
+		const ColorRGB tints[]{ ColorRGB{ 1.0f,0.75f,0.45f }, ColorRGB{ 1.0f,0.85f,0.6f }, ColorRGB{ 0.7f,0.8f,1.0f } };
+		Pcg32 rng{ Pcg32::FromSeed(2024) };
+
+		m_Lights.reserve(2 * (numBlocks + 1) * lightsPerStreet + 1);
+		for (int street{ 0 }; street <= numBlocks; ++street) {
+			const float streetOffset{ (street - numBlocks / 2.f) * blockSpacing };
+			for (int lightIdx{ 0 }; lightIdx < lightsPerStreet; ++lightIdx) {
+				const float along{ (lightIdx + 0.5f) / lightsPerStreet * streetLength - streetLength / 2 };
+				const float intensity{ 1.5f + 2.f * rng.NextFloat() };
+
+				AddPointLight({ streetOffset, 1.5f, along }, intensity, tints[rng.NextUInt() % 3]);
+				AddPointLight({ along, 1.5f, streetOffset }, intensity, tints[rng.NextUInt() % 3]);
+			}
+		}
+
+		//Moonlight
+		AddDirectionalLight(Vector3{ 0.3f, 1.f, -0.4f }.Normalized(), 0.05f, ColorRGB{ 0.6f,0.7f,1.0f });
+
+		LimitLightInfluence(0.01f);
+	}
+#pragma endregion
+
+#pragma region SCENE AREA LIGHTS
+	void Scene_AreaLights::Populate() {
+		sceneName = "Area Lights Scene";
+		m_Camera.origin = { 0.0f,3.0f,-9.0f };
+		m_Camera.fovAngle = 45.0f;
+
+		const auto matCT_GraySmoothMetal = AddMaterial<Material_CookTorrence>(ColorRGB{ 0.972f,0.96f,0.915f }, 1.0f, 0.1f);
+		const auto matCT_GrayMediumPlastic = AddMaterial<Material_CookTorrence>(ColorRGB{ 0.75f,0.75f,0.75f }, 0.0f, 0.6f);
+		const auto matLambert_GrayBlue = AddMaterial<Material_Lambert>(ColorRGB{ 0.49f,0.57f,0.57f }, 1.0f);
+		const auto matLambert_White = AddMaterial<Material_Lambert>(colors::White, 1.0f);
+
+		//Floor and back wall
+		AddPlane({ 0.f, 0.f, 10.f }, { 0.f, 0.f,-1.f }, matLambert_GrayBlue);
+		AddPlane({ 0.f, 0.f, 0.f }, { 0.f, 1.f,0.f }, matLambert_GrayBlue);
+
+		//Shadow casters at different heights, so the penumbrae differ in width
+		AddSphere({ -2.f, 0.75f, 0.f }, 0.75f, matCT_GrayMediumPlastic);
+		AddSphere({ 0.f, 1.75f, 1.f }, 0.75f, matCT_GraySmoothMetal);
+		AddSphere({ 2.f, 0.5f, -1.f }, 0.5f, matCT_GrayMediumPlastic);
+
+		const Triangle baseTriangle = { Vector3{-0.75f,1.5f,0.0f},Vector3{0.75f,0.0f,0.0f},Vector3{-0.75f,0.0f,0.0f} };
+		TriangleMesh* pMesh{ AddTriangleMesh(TriangleCullMode::NoCulling, matLambert_White) };
+		pMesh->AppendTriangle(baseTriangle, true);
+		pMesh->Translate({ 0.f,0.f,3.f });
+		pMesh->UpdateAABB();
+		pMesh->UpdateTransforms();
+
+		//Rect overhead, facing down
+		AddRectLight({ 0.f, 6.f, 0.f }, { 1.5f, 0.f, 0.f }, { 0.f, 0.f, 0.75f }, 40.f, ColorRGB{ 1.f, 0.95f, 0.85f });
+		//Disk on the left, facing the middle of the scene
+		AddDiskLight({ -4.f, 3.f, -2.f }, { 1.f, -0.5f, 0.5f }, 0.75f, 30.f, ColorRGB{ 0.6f, 0.75f, 1.f });
+		//Sphere on the right
+		AddSphereLight({ 3.5f, 2.5f, -2.5f }, 0.5f, 25.f, ColorRGB{ 1.f, 0.6f, 0.4f });
+	}
+#pragma endregion
+
+#pragma region SCENE REGISTRY
+	const std::vector<std::string>& GetSceneNames()
+	{
+		static const std::vector<std::string> sceneNames{
+			"Scene_W1",
+			"Scene_W2",
+			"Scene_W3_TestScene",
+			"Scene_W3",
+			"Scene_W4_TestScene",
+			"Scene_W4_ReferenceScene",
+			"Scene_W4_BunnyScene",
+			"Scene_ManyLights",
+			"Scene_AreaLights"
+		};
+
+		return sceneNames;
+	}
+
+	std::unique_ptr<Scene> CreateScene(const std::string& name)
+	{
+		if (name == "Scene_W1") return std::make_unique<Scene_W1>();
+		if (name == "Scene_W2") return std::make_unique<Scene_W2>();
+		if (name == "Scene_W3_TestScene") return std::make_unique<Scene_W3_TestScene>();
+		if (name == "Scene_W3") return std::make_unique<Scene_W3>();
+		if (name == "Scene_W4_TestScene") return std::make_unique<Scene_W4_TestScene>();
+		if (name == "Scene_W4_ReferenceScene") return std::make_unique<Scene_W4_ReferenceScene>();
+		if (name == "Scene_W4_BunnyScene") return std::make_unique<Scene_W4_BunnyScene>();
+		if (name == "Scene_ManyLights") return std::make_unique<Scene_ManyLights>();
+		if (name == "Scene_AreaLights") return std::make_unique<Scene_AreaLights>();
+
+		return nullptr;
+	}
+#pragma endregion
 }
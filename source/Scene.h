@@ -1,10 +1,13 @@
 #pragma once
+#include <memory>
 #include <string>
 #include <vector>
 
 #include "Math.h"
 #include "DataTypes.h"
 #include "Camera.h"
+#include "LightTree.h"
+#include "MemoryArena.h"
 
 namespace dae
 {
@@ -27,39 +30,85 @@ namespace dae
 		Scene& operator=(const Scene&) = delete;
 		Scene& operator=(Scene&&) noexcept = delete;
 
-		virtual void Initialize() = 0;
-		virtual void Update(dae::Timer* pTimer)
-		{
-			m_Camera.Update(pTimer);
-		}
+		//Adds the scene's content, then builds what the renderers need on top of it (the light tree)
+		void Initialize();
+		//Interactive update: camera input, the animation at the timer's total time, then the camera transform
+		void Update(dae::Timer* pTimer);
+		//Puts everything animated in the state it has at time (seconds since the start), no matter what came before,
+		//so frames can be evaluated in any order and on any number of scene copies
+		virtual void Animate(float /*time*/) {}
 
 		Camera& GetCamera() { return m_Camera; }
-		void GetClosestHit(const Ray& ray, HitRecord& closestHit) const;
-		bool DoesHit(const Ray& ray) const;
+		const Camera& GetCamera() const { return m_Camera; }
+		void GetClosestHit(const Ray& ray, HitRecord& closestHit) const { (this->*m_pGetClosestHit)(ray, closestHit); }
+		bool DoesHit(const Ray& ray) const { return (this->*m_pDoesHit)(ray); }
+
+		//Picks the hit-test algorithms behind GetClosestHit/DoesHit, resolved here once instead of per call
+		void SetIntersectionAlgorithms(SphereAlgorithm sphereAlgorithm, TriangleAlgorithm triangleAlgorithm);
+		//Times every algorithm combination on this scene's camera and shadow rays and keeps the fastest one
+		void CalibrateIntersectionAlgorithms();
+
+		SphereAlgorithm GetSphereAlgorithm() const { return m_SphereAlgorithm; }
+		TriangleAlgorithm GetTriangleAlgorithm() const { return m_TriangleAlgorithm; }
 
 		const std::vector<Plane>& GetPlaneGeometries() const { return m_PlaneGeometries; }
 		const std::vector<Sphere>& GetSphereGeometries() const { return m_SphereGeometries; }
 		const std::vector<Light>& GetLights() const { return m_Lights; }
-		const std::vector<Material*> GetMaterials() const { return m_Materials; }
+		//Built by Initialize for scenes with more than LightTree::SAMPLING_THRESHOLD lights, the renderer shades every light of the others
+		const LightTree& GetLightTree() const { return m_LightTree; }
+		const std::vector<Material*>& GetMaterials() const { return m_Materials; }
 
 	protected:
+		//Camera, materials, geometry and lights of the scene
+		virtual void Populate() = 0;
+
 		std::string	sceneName;
 
+		//Long-lived scene data (materials, ...), released in one go when the scene is destroyed
+		MemoryArena m_SceneArena{};
+
 		std::vector<Plane> m_PlaneGeometries{};
 		std::vector<Sphere> m_SphereGeometries{};
 		std::vector<TriangleMesh> m_TriangleMeshGeometries{};
 		std::vector<Light> m_Lights{};
+		LightTree m_LightTree{};
 		std::vector<Material*> m_Materials{};
 
 		Camera m_Camera{};
 
+		SphereAlgorithm m_SphereAlgorithm{};
+		TriangleAlgorithm m_TriangleAlgorithm{};
+
+		using GetClosestHitFunction = void (Scene::*)(const Ray&, HitRecord&) const;
+		using DoesHitFunction = bool (Scene::*)(const Ray&) const;
+		GetClosestHitFunction m_pGetClosestHit{};
+		DoesHitFunction m_pDoesHit{};
+
+		template<SphereAlgorithm sphereAlgorithm, TriangleAlgorithm triangleAlgorithm>
+		void GetClosestHit_Impl(const Ray& ray, HitRecord& closestHit) const;
+		template<SphereAlgorithm sphereAlgorithm, TriangleAlgorithm triangleAlgorithm>
+		bool DoesHit_Impl(const Ray& ray) const;
+
 		Sphere* AddSphere(const Vector3& origin, float radius, unsigned char materialIndex = 0);
 		Plane* AddPlane(const Vector3& origin, const Vector3& normal, unsigned char materialIndex = 0);
 		TriangleMesh* AddTriangleMesh(TriangleCullMode cullMode, unsigned char materialIndex = 0);
 
 		Light* AddPointLight(const Vector3& origin, float intensity, const ColorRGB& color);
 		Light* AddDirectionalLight(const Vector3& direction, float intensity, const ColorRGB& color);
-		unsigned char AddMaterial(Material* pMaterial);
+		//Area lights. A rect spans center +- edgeU +- edgeV and emits to the side of Cross(edgeU, edgeV), a disk to the side of normal
+		Light* AddRectLight(const Vector3& center, const Vector3& edgeU, const Vector3& edgeV, float intensity, const ColorRGB& color);
+		Light* AddDiskLight(const Vector3& center, const Vector3& normal, float radius, float intensity, const ColorRGB& color);
+		Light* AddSphereLight(const Vector3& center, float radius, float intensity, const ColorRGB& color);
+		//Gives every point light an influence radius, the distance at which its radiance drops below minRadiance.
+		//Light beyond it is dropped, in exchange the renderer only shades the lights that reach a tile
+		void LimitLightInfluence(float minRadiance);
+
+		template<typename T, typename... Args>
+		unsigned char AddMaterial(Args&&... args)
+		{
+			m_Materials.push_back(m_SceneArena.New<T>(std::forward<Args>(args)...));
+			return static_cast<unsigned char>(m_Materials.size() - 1);
+		}
 	};
 
 	//+++++++++++++++++++++++++++++++++++++++++
@@ -75,7 +124,8 @@ namespace dae
 		Scene_W1& operator=(const Scene_W1&) = delete;
 		Scene_W1& operator=(Scene_W1&&) noexcept = delete;
 
-		void Initialize() override;
+	private:
+		void Populate() override;
 	};
 
 	//+++++++++++++++++++++++++++++++++++++++++
@@ -91,7 +141,8 @@ namespace dae
 		Scene_W2& operator=(const Scene_W2&) = delete;
 		Scene_W2& operator=(Scene_W2&&) noexcept = delete;
 
-		void Initialize() override;
+	private:
+		void Populate() override;
 	};
 
 	//+++++++++++++++++++++++++++++++++++++++++
@@ -107,7 +158,8 @@ namespace dae
 		Scene_W3_TestScene& operator=(const Scene_W3_TestScene&) = delete;
 		Scene_W3_TestScene& operator=(Scene_W3_TestScene&&) noexcept = delete;
 
-		void Initialize() override;
+	private:
+		void Populate() override;
 	};
 
 	class Scene_W3 final : public Scene
@@ -121,7 +173,8 @@ namespace dae
 		Scene_W3& operator=(const Scene_W3&) = delete;
 		Scene_W3& operator=(Scene_W3&&) noexcept = delete;
 
-		void Initialize() override;
+	private:
+		void Populate() override;
 	};
 
 	//+++++++++++++++++++++++++++++++++++++++++
@@ -137,10 +190,11 @@ namespace dae
 		Scene_W4_TestScene& operator=(const Scene_W4_TestScene&) = delete;
 		Scene_W4_TestScene& operator=(Scene_W4_TestScene&&) noexcept = delete;
 
-		void Initialize() override;
-		void Update(Timer* pTimer) override;
+		void Animate(float time) override;
 
 	private:
+		void Populate() override;
+
 		TriangleMesh* pMesh{ nullptr };
 	};
 
@@ -155,10 +209,11 @@ namespace dae
 		Scene_W4_ReferenceScene& operator=(const Scene_W4_ReferenceScene&) = delete;
 		Scene_W4_ReferenceScene& operator=(Scene_W4_ReferenceScene&&) noexcept = delete;
 
-		void Initialize() override;
-		void Update(Timer* pTimer) override;
+		void Animate(float time) override;
 
 	private:
+		void Populate() override;
+
 		TriangleMesh* m_Meshes[3]{};
 	};
 
@@ -173,10 +228,52 @@ namespace dae
 		Scene_W4_BunnyScene& operator=(const Scene_W4_BunnyScene&) = delete;
 		Scene_W4_BunnyScene& operator=(Scene_W4_BunnyScene&&) noexcept = delete;
 
-		void Initialize() override;
-		void Update(Timer* pTimer) override;
+		void Animate(float time) override;
 
 	private:
+		void Populate() override;
+
 		TriangleMesh* m_pBunny{ nullptr };
 	};
+
+	//+++++++++++++++++++++++++++++++++++++++++
+	//Many Lights Scene: a city block at night, over a thousand street lights
+	class Scene_ManyLights final : public Scene
+	{
+	public:
+		Scene_ManyLights() = default;
+		~Scene_ManyLights() override = default;
+
+		Scene_ManyLights(const Scene_ManyLights&) = delete;
+		Scene_ManyLights(Scene_ManyLights&&) noexcept = delete;
+		Scene_ManyLights& operator=(const Scene_ManyLights&) = delete;
+		Scene_ManyLights& operator=(Scene_ManyLights&&) noexcept = delete;
+
+	private:
+		void Populate() override;
+	};
+
+	//+++++++++++++++++++++++++++++++++++++++++
+	//Area Lights Scene: soft shadows from a rect, a disk and a sphere light
+	class Scene_AreaLights final : public Scene
+	{
+	public:
+		Scene_AreaLights() = default;
+		~Scene_AreaLights() override = default;
+
+		Scene_AreaLights(const Scene_AreaLights&) = delete;
+		Scene_AreaLights(Scene_AreaLights&&) noexcept = delete;
+		Scene_AreaLights& operator=(const Scene_AreaLights&) = delete;
+		Scene_AreaLights& operator=(Scene_AreaLights&&) noexcept = delete;
+
+	private:
+		void Populate() override;
+	};
+
+	//+++++++++++++++++++++++++++++++++++++++++
+	//Scene Registry
+	//Names of all built-in scenes ("Scene_W1", ..., "Scene_W4_BunnyScene")
+	const std::vector<std::string>& GetSceneNames();
+	//Creates (but does not initialize) a built-in scene, nullptr if the name is unknown
+	std::unique_ptr<Scene> CreateScene(const std::string& name);
 }
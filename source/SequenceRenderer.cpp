@@ -0,0 +1,232 @@
+#include "SequenceRenderer.h"
+#include "DistributedRenderer.h"
+#include "OfflineRenderer.h"
+#include "Profiler.h"
+#include "Scene.h"
+#include "Threading.h"
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cmath>
+#include <iostream>
+#include <thread>
+
+using namespace dae;
+
+namespace
+{
+	//Within-frame needs a few tiles per thread to balance the load of uneven tiles
+	constexpr uint32_t MIN_TILES_PER_THREAD{ 4 };
+	//Share of a frame spent outside of tracing (Scene::Animate, mesh transforms) that no other thread can help with
+	constexpr double MAX_SERIAL_FRACTION{ 0.05 };
+	//Below this, fork/join and file overhead per frame outweigh splitting a frame up
+	constexpr double MIN_WITHIN_FRAME_MS{ 20.0 };
+}
+
+const char* dae::ToString(SequenceSchedule schedule)
+{
+	switch (schedule)
+	{
+	case SequenceSchedule::Auto: return "auto";
+	case SequenceSchedule::FrameParallel: return "frame-parallel";
+	case SequenceSchedule::WithinFrame: return "within-frame";
+	default: return "unknown";
+	}
+}
+
+SequenceRenderer::SequenceRenderer(const SequenceRenderSettings& settings) :
+	m_Settings(settings),
+	m_ThreadScenes(MAX_THREAD_SLOTS)
+{
+}
+
+SequenceRenderer::~SequenceRenderer() = default;
+
+bool SequenceRenderer::Render(const std::string& sceneName, SphereAlgorithm sphereAlgorithm, TriangleAlgorithm triangleAlgorithm)
+{
+	if (!HasFrames())
+		return false;
+
+	m_SceneName = sceneName;
+	m_SphereAlgorithm = sphereAlgorithm;
+	m_TriangleAlgorithm = triangleAlgorithm;
+
+	Scene* pScene{ GetThreadScene() };
+	if (!pScene)
+		return false;
+
+	const int firstFrame{ m_Settings.firstFrame };
+	const int lastFrame{ m_Settings.lastFrame };
+
+	//The first frame always goes over all threads, it doubles as the measurement for Auto
+	uint64_t animateNs{};
+	const uint64_t frameStartNs{ Profiler::Now() };
+	if (!RenderFrame(pScene, firstFrame, true, animateNs))
+		return false;
+	const uint64_t frameNs{ Profiler::Now() - frameStartNs };
+
+	m_UsedSchedule = m_Settings.schedule == SequenceSchedule::Auto ? ChooseSchedule(frameNs, animateNs) : m_Settings.schedule;
+	std::cout << "Frame " << firstFrame << " took " << double(frameNs) / 1'000'000.0 << "ms, rendering the rest "
+		<< ToString(m_UsedSchedule) << std::endl;
+
+	if (m_UsedSchedule == SequenceSchedule::WithinFrame)
+	{
+		for (int frame{ firstFrame + 1 }; frame <= lastFrame; ++frame)
+		{
+			if (!RenderFrame(pScene, frame, true, animateNs))
+				return false;
+		}
+
+		return true;
+	}
+
+	//Each thread animates and traces its own scene copy, the tile loop inside a frame runs serially on that thread
+	std::atomic<bool> succeeded{ true };
+	ParallelFor(uint32_t(firstFrame + 1), uint32_t(lastFrame + 1), [&](uint32_t frame) {
+		uint64_t frameAnimateNs{};
+		Scene* pFrameScene{ GetThreadScene() };
+		if (!pFrameScene || !RenderFrame(pFrameScene, int(frame), false, frameAnimateNs))
+			succeeded = false;
+	});
+
+	RayStatistics::MergeAndReset();
+	return succeeded;
+}
+
+bool SequenceRenderer::Render(DistributedRenderer& distributedRenderer)
+{
+	if (!HasFrames())
+		return false;
+
+	//Workers already split every frame between them
+	m_UsedSchedule = SequenceSchedule::WithinFrame;
+
+	for (int frame{ m_Settings.firstFrame }; frame <= m_Settings.lastFrame; ++frame)
+	{
+		const std::string fileName{ GetFrameFileName(m_Settings.outputPattern, frame) };
+		const std::unique_ptr<ImageSink> pSink{ CreateImageSink(fileName, m_Settings.exrLayout, m_Settings.tileSize) };
+		if (!pSink || !distributedRenderer.RenderFrame(m_Settings.width, m_Settings.height, *pSink, GetFrameTime(frame)))
+		{
+			std::cout << "Something went wrong. Frame " << frame << " not saved!" << std::endl;
+			return false;
+		}
+
+		std::cout << "Frame " << frame << " saved to " << fileName << std::endl;
+	}
+
+	return true;
+}
+
+std::string SequenceRenderer::GetFrameFileName(const std::string& pattern, int frame)
+{
+	std::string fileName{ pattern };
+
+	size_t hashStart{ fileName.find('#') };
+	if (hashStart == std::string::npos)
+	{
+		const size_t extensionStart{ fileName.rfind('.') };
+		hashStart = extensionStart == std::string::npos ? fileName.size() : extensionStart;
+		fileName.insert(hashStart, "_####");
+		++hashStart;
+	}
+
+	const size_t hashEnd{ std::min(fileName.find_first_not_of('#', hashStart), fileName.size()) };
+
+	std::string frameNumber{ std::to_string(frame) };
+	if (frameNumber.size() < hashEnd - hashStart)
+		frameNumber.insert(0, hashEnd - hashStart - frameNumber.size(), '0');
+
+	return fileName.replace(hashStart, hashEnd - hashStart, frameNumber);
+}
+
+bool SequenceRenderer::RenderFrame(Scene* pScene, int frame, bool collectRayStats, uint64_t& animateNs) const
+{
+	const uint64_t animateStartNs{ Profiler::Now() };
+	pScene->Animate(GetFrameTime(frame));
+	animateNs = Profiler::Now() - animateStartNs;
+
+	const std::string fileName{ GetFrameFileName(m_Settings.outputPattern, frame) };
+	const std::unique_ptr<ImageSink> pSink{ CreateImageSink(fileName, m_Settings.exrLayout, m_Settings.tileSize) };
+	if (!pSink)
+	{
+		std::cout << "Unsupported output file: " << fileName << " (use .exr or .pfm)" << std::endl;
+		return false;
+	}
+
+	OfflineRenderSettings renderSettings{};
+	renderSettings.width = m_Settings.width;
+	renderSettings.height = m_Settings.height;
+	renderSettings.tileSize = m_Settings.tileSize;
+	renderSettings.shadowsEnabled = m_Settings.shadowsEnabled;
+	renderSettings.printProgress = false;
+	renderSettings.collectRayStats = collectRayStats;
+
+	OfflineRenderer renderer{ renderSettings };
+	if (!renderer.Render(pScene, *pSink))
+	{
+		std::cout << "Something went wrong. Frame " << frame << " not saved!" << std::endl;
+		return false;
+	}
+
+	std::cout << "Frame " << frame << " saved to " << fileName << std::endl;
+	return true;
+}
+
+Scene* SequenceRenderer::GetThreadScene()
+{
+	std::unique_ptr<Scene>& pScene{ m_ThreadScenes[GetThreadSlot()] };
+	if (!pScene)
+	{
+		pScene = CreateScene(m_SceneName);
+		if (!pScene)
+		{
+			std::cout << "Unknown scene: " << m_SceneName << std::endl;
+			return nullptr;
+		}
+
+		pScene->Initialize();
+		pScene->SetIntersectionAlgorithms(m_SphereAlgorithm, m_TriangleAlgorithm);
+	}
+
+	return pScene.get();
+}
+
+bool SequenceRenderer::HasFrames() const
+{
+	//Frame numbers index the files and the animation time, they're counted up from firstFrame without wrapping around
+	if (m_Settings.firstFrame < 0 || m_Settings.lastFrame < m_Settings.firstFrame || m_Settings.lastFrame == INT_MAX)
+	{
+		std::cout << "No frames to render between " << m_Settings.firstFrame << " and " << m_Settings.lastFrame << std::endl;
+		return false;
+	}
+
+	if (!(m_Settings.framesPerSecond > 0) || !std::isfinite(m_Settings.framesPerSecond))
+	{
+		std::cout << "Invalid frame rate: " << m_Settings.framesPerSecond << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+SequenceSchedule SequenceRenderer::ChooseSchedule(uint64_t frameNs, uint64_t animateNs) const
+{
+	const uint32_t numThreads{ std::max(std::thread::hardware_concurrency(), 1u) };
+	const uint32_t numRemainingFrames{ uint32_t(m_Settings.lastFrame - m_Settings.firstFrame) };
+
+	//Frame-parallel only pays off with a thread to spare and enough frames to hand every thread one
+	if (numThreads == 1 || numRemainingFrames < numThreads)
+		return SequenceSchedule::WithinFrame;
+
+	const uint32_t numTiles{ uint32_t((m_Settings.width + m_Settings.tileSize - 1) / m_Settings.tileSize)
+		* uint32_t((m_Settings.height + m_Settings.tileSize - 1) / m_Settings.tileSize) };
+	const double serialFraction{ frameNs > 0 ? double(animateNs) / frameNs : 0.0 };
+	const double frameMs{ double(frameNs) / 1'000'000.0 };
+
+	if (numTiles < MIN_TILES_PER_THREAD * numThreads || serialFraction > MAX_SERIAL_FRACTION || frameMs < MIN_WITHIN_FRAME_MS)
+		return SequenceSchedule::FrameParallel;
+
+	//Big frames keep every thread busy on their own, with only one scene in memory
+	return SequenceSchedule::WithinFrame;
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "DataTypes.h"
+#include "ImageSink.h"
+
+namespace dae
+{
+	class Scene;
+	class DistributedRenderer;
+
+	//FrameParallel renders whole frames side by side (one scene copy per thread), WithinFrame one frame at a time over all threads
+	enum class SequenceSchedule { Auto, FrameParallel, WithinFrame };
+
+	const char* ToString(SequenceSchedule schedule);
+
+	struct SequenceRenderSettings
+	{
+		int width{ 1280 };
+		int height{ 720 };
+		int tileSize{ 64 };
+		bool shadowsEnabled{ true };
+
+		//Both inclusive and 0 or more, frame n shows the scene at n / framesPerSecond seconds (framesPerSecond above 0)
+		int firstFrame{ 0 };
+		int lastFrame{ 119 };
+		float framesPerSecond{ 30.f };
+
+		//The run of '#' is replaced by the zero padded frame number ("_####" is added before the extension if there is none)
+		std::string outputPattern{ "frame_####.exr" };
+		ExrLayout exrLayout{ ExrLayout::Scanline };
+
+		SequenceSchedule schedule{ SequenceSchedule::Auto };
+	};
+
+	/**
+	 * \brief Renders frames [firstFrame, lastFrame] of a scene's animation to numbered images.
+	 * Every frame is evaluated at its own time through Scene::Animate, so frames don't depend on each other.
+	 * With Auto, the first frame is rendered within-frame and timed, then the rest of the sequence switches to
+	 * frame-parallel when a single frame can't keep all threads busy or its serial part is too large.
+	 */
+	class SequenceRenderer final
+	{
+	public:
+		explicit SequenceRenderer(const SequenceRenderSettings& settings);
+		~SequenceRenderer();
+
+		SequenceRenderer(const SequenceRenderer&) = delete;
+		SequenceRenderer(SequenceRenderer&&) noexcept = delete;
+		SequenceRenderer& operator=(const SequenceRenderer&) = delete;
+		SequenceRenderer& operator=(SequenceRenderer&&) noexcept = delete;
+
+		//Scene copies are created per thread as needed, all tracing with the given intersection algorithms
+		bool Render(const std::string& sceneName, SphereAlgorithm sphereAlgorithm, TriangleAlgorithm triangleAlgorithm);
+		//Frame after frame on already started worker processes, which animate their own scenes
+		bool Render(DistributedRenderer& distributedRenderer);
+
+		SequenceSchedule GetUsedSchedule() const { return m_UsedSchedule; }
+
+		static std::string GetFrameFileName(const std::string& pattern, int frame);
+
+	private:
+		//Renders one frame into its file, returns the time spent in Scene::Animate
+		bool RenderFrame(Scene* pScene, int frame, bool collectRayStats, uint64_t& animateNs) const;
+		Scene* GetThreadScene();
+		//False (and says why) for an empty or negative frame range, or a frame rate that gives no frame times
+		bool HasFrames() const;
+
+		SequenceSchedule ChooseSchedule(uint64_t frameNs, uint64_t animateNs) const;
+
+		float GetFrameTime(int frame) const { return frame / m_Settings.framesPerSecond; }
+
+		SequenceRenderSettings m_Settings{};
+		SequenceSchedule m_UsedSchedule{ SequenceSchedule::WithinFrame };
+
+		std::string m_SceneName{};
+		SphereAlgorithm m_SphereAlgorithm{};
+		TriangleAlgorithm m_TriangleAlgorithm{};
+
+		//Indexed by thread slot, only filled for threads that rendered a frame
+		std::vector<std::unique_ptr<Scene>> m_ThreadScenes{};
+	};
+}
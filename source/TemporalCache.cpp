@@ -0,0 +1,169 @@
+#include "TemporalCache.h"
+#include "Threading.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+using namespace dae;
+
+TemporalCache::TemporalCache(const TemporalCacheSettings& settings) :
+	m_Settings(settings)
+{
+}
+
+void TemporalCache::Resize(int width, int height)
+{
+	if (width == m_Width && height == m_Height)
+		return;
+
+	m_Width = width;
+	m_Height = height;
+	m_HasHistory = false;
+
+	const size_t numPixels{ size_t(width) * height };
+	m_PreviousHits.assign(numPixels, {});
+	m_HistoryColors.Resize(width, height);
+	m_HistoryLengths.assign(numPixels, 0.f);
+	m_SampleCounts.assign(numPixels, 0u);
+	m_ReprojectedColors.Resize(width, height);
+	m_ReprojectedLengths.assign(numPixels, 0.f);
+	m_FrameSamples.assign(numPixels, 0u);
+}
+
+void TemporalCache::BeginFrame(int width, int height)
+{
+	Resize(width, height);
+	++m_FrameCount;
+}
+
+bool TemporalCache::IsSkipTurn(size_t pixelIndex) const
+{
+	//Diagonals take turns, every pixel's neighbours trace when it doesn't
+	const size_t x{ pixelIndex % size_t(m_Width) };
+	const size_t y{ pixelIndex / size_t(m_Width) };
+	return m_HasHistory && (x + y + m_FrameCount) % m_Settings.sampleInterval != 0;
+}
+
+uint32_t TemporalCache::Reproject(size_t pixelIndex, const PrimaryHit& primaryHit)
+{
+	ColorRGB color{};
+	float length{ 0.f };
+	if (m_HasHistory && primaryHit.depth > 0.f) {
+		LookUpHistory(primaryHit, color, length);
+	}
+
+	m_ReprojectedColors.SetPixel(pixelIndex, color);
+	m_ReprojectedLengths[pixelIndex] = length;
+
+	uint32_t numSamples{ 1 };
+	if (length >= m_Settings.minSkipHistoryLength && IsSkipTurn(pixelIndex))
+		numSamples = 0;
+	else if (length <= 0.f && primaryHit.depth > 0.f)
+		numSamples += m_Settings.disocclusionSamples;
+
+	m_FrameSamples[pixelIndex] = numSamples;
+	return numSamples;
+}
+
+void TemporalCache::LookUpHistory(const PrimaryHit& primaryHit, ColorRGB& color, float& length) const
+{
+	//Into the previous camera's space, its axes are orthonormal
+	const Vector3 toSurface{ primaryHit.position - m_PreviousCamera.origin };
+	const float cameraZ{ Vector3::Dot(toSurface, m_PreviousCamera.forward) };
+	if (cameraZ <= 0.f)
+		return;
+
+	//The inverse of ImagePlane::GetPrimaryRay, in pixels. The size doesn't change while there is history
+	const float fov{ tanf(m_PreviousCamera.fovAngle * TO_RADIANS / 2) };
+	const float aspectRatio{ float(m_Width) / m_Height };
+	const float previousX{ (Vector3::Dot(toSurface, m_PreviousCamera.right) / cameraZ / (aspectRatio * fov) + 1) * m_Width / 2 };
+	const float previousY{ (1 - Vector3::Dot(toSurface, m_PreviousCamera.up) / cameraZ / fov) * m_Height / 2 };
+	//Just entered the view. Borrowing the edge pixel would keep it from ever being disoccluded, stuck with what the edge showed long ago
+	if (previousX < 0.f || previousY < 0.f || previousX >= m_Width || previousY >= m_Height)
+		return;
+
+	//The 4 pixel centers around it
+	const float tapX{ previousX - 0.5f };
+	const float tapY{ previousY - 0.5f };
+	const int startX{ int(floorf(tapX)) };
+	const int startY{ int(floorf(tapY)) };
+	const float fractionX{ tapX - startX };
+	const float fractionY{ tapY - startY };
+
+	const float maxPlaneDistance{ m_Settings.maxPlaneDistance * primaryHit.depth };
+
+	ColorRGB sumColor{};
+	float sumLength{ 0.f };
+	float sumWeight{ 0.f };
+	for (int offsetY{ 0 }; offsetY < 2; ++offsetY) {
+		for (int offsetX{ 0 }; offsetX < 2; ++offsetX) {
+			const int x{ startX + offsetX };
+			const int y{ startY + offsetY };
+			if (x < 0 || y < 0 || x >= m_Width || y >= m_Height)
+				continue;
+
+			const size_t pixelIndex{ size_t(y) * m_Width + x };
+			const PrimaryHit& previousHit{ m_PreviousHits[pixelIndex] };
+			if (previousHit.depth <= 0.f || m_HistoryLengths[pixelIndex] <= 0.f)
+				continue;
+
+			//Only taps that saw the same surface: on its plane, facing the same way
+			if (fabsf(Vector3::Dot(previousHit.position - primaryHit.position, primaryHit.normal)) > maxPlaneDistance
+				|| Vector3::Dot(previousHit.normal, primaryHit.normal) < m_Settings.minNormalCos)
+				continue;
+
+			const float weight{ (offsetX ? fractionX : 1 - fractionX) * (offsetY ? fractionY : 1 - fractionY) };
+			sumColor += m_HistoryColors.GetPixel(pixelIndex) * weight;
+			sumLength += m_HistoryLengths[pixelIndex] * weight;
+			sumWeight += weight;
+		}
+	}
+
+	//A sliver of a valid tap doesn't make history, it would be the whole of it after normalizing
+	constexpr float minWeight{ 0.01f };
+	if (sumWeight < minWeight)
+		return;
+
+	color = sumColor / sumWeight;
+	length = sumLength / sumWeight;
+}
+
+void TemporalCache::Accumulate(HdrBuffer& hdrBuffer, const std::vector<PrimaryHit>& primaryHits, const Camera& camera)
+{
+	assert(hdrBuffer.width == m_Width && hdrBuffer.height == m_Height && "Begin the frame at the size of the image first");
+
+	const float maxLength{ float(m_Settings.maxHistoryLength) };
+
+	ParallelFor(0u, uint32_t(m_Height), [&](uint32_t py) {
+		for (int px{ 0 }; px < m_Width; ++px) {
+			const size_t pixelIndex{ size_t(py) * m_Width + px };
+
+			const float reprojectedLength{ m_ReprojectedLengths[pixelIndex] };
+			const uint32_t numSamples{ m_FrameSamples[pixelIndex] };
+			ColorRGB color{ hdrBuffer.GetPixel(pixelIndex) };
+			float length{ 0.f };
+			if (numSamples == 0) {
+				color = m_ReprojectedColors.GetPixel(pixelIndex);
+				length = reprojectedLength;
+			}
+			else if (reprojectedLength > 0.f) {
+				length = std::min(reprojectedLength + 1, maxLength);
+				color = ColorRGB::Lerp(m_ReprojectedColors.GetPixel(pixelIndex), color, 1 / length);
+			}
+			else if (primaryHits[pixelIndex].depth > 0.f) {
+				//Disoccluded pixels averaged their extra samples already
+				length = float(numSamples);
+			}
+
+			hdrBuffer.SetPixel(pixelIndex, color);
+			m_HistoryColors.SetPixel(pixelIndex, color);
+			m_HistoryLengths[pixelIndex] = length;
+			m_SampleCounts[pixelIndex] += numSamples;
+		}
+	});
+
+	m_PreviousHits = primaryHits;
+	m_PreviousCamera.CopyState(camera);
+	m_HasHistory = true;
+}
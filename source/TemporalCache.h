@@ -0,0 +1,100 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "Camera.h"
+#include "DataTypes.h"
+#include "HdrBuffer.h"
+
+namespace dae
+{
+	struct TemporalCacheSettings
+	{
+		//Frames a pixel's history averages at most, a new frame never weighs less than 1 / maxHistoryLength.
+		//Longer converges further while the camera stands still, but every move resamples the history, which blurs it a little
+		uint32_t maxHistoryLength{ 16 };
+		//Samples traced on top of the frame's own for pixels without history, so they don't stand out from their converged neighbours
+		uint32_t disocclusionSamples{ 3 };
+		//Pixels with history trace a sample in one of every sampleInterval frames (interleaved), and show their history in between.
+		//The noise they settle at stays the same, changes in lighting take this many times longer to show
+		uint32_t sampleInterval{ 2 };
+		//History a pixel needs before it may skip a frame's sample, freshly disoccluded pixels keep tracing until they caught up
+		float minSkipHistoryLength{ 4.f };
+		//How far the surface a history pixel saw may be off the plane of the current one, relative to the current depth
+		float maxPlaneDistance{ 0.01f };
+		//Smallest cosine between the normal a history pixel saw and the current one
+		float minNormalCos{ 0.9f };
+	};
+
+	/**
+	 * \brief Keeps the colors of past frames and reuses them after the camera moved.
+	 * The primary hit of each pixel (recorded by the tracer) is projected into the previous frame's camera, and the history there is
+	 * taken (bilinearly, from the neighbours that saw the same surface) when the previous hit's position lies on the current hit's
+	 * plane and its normal agrees. New samples are then blended in with a weight of 1 / history length. Pixels that find no history
+	 * are disoccluded: they start over and get extra samples. Pixels with enough history only trace a sample every sampleInterval
+	 * frames, in between their primary ray finds the history they show, so a moving camera costs a fraction of the rays.
+	 * Moving objects fail the position check, so they don't smear.
+	 * Glossy reflections move over their surface with the camera, they pass both checks and lag behind.
+	 */
+	class TemporalCache final
+	{
+	public:
+		explicit TemporalCache(const TemporalCacheSettings& settings = {});
+		~TemporalCache() = default;
+
+		TemporalCache(const TemporalCache&) = delete;
+		TemporalCache(TemporalCache&&) noexcept = delete;
+		TemporalCache& operator=(const TemporalCache&) = delete;
+		TemporalCache& operator=(TemporalCache&&) noexcept = delete;
+
+		//Starts a frame of the given size, before any pixel is reprojected
+		void BeginFrame(int width, int height);
+
+		//Whether it's the pixel's turn to skip its sample this frame, if its history allows. Such pixels only trace their primary hit,
+		//reproject it and trace samples after all when that asks for them
+		bool IsSkipTurn(size_t pixelIndex) const;
+		//Looks up the history of what the pixel shows this frame. Returns how many samples the pixel takes: 0 to show its history
+		//as is (on its skip turn), 1, or 1 + disocclusionSamples without history. Pixels can be reprojected in parallel
+		uint32_t Reproject(size_t pixelIndex, const PrimaryHit& primaryHit);
+
+		//Sample index of the pixel's next sample. Counted per pixel, so the samples a pixel takes stay consecutive
+		//when disoccluded pixels take more of them in a frame than the others
+		uint32_t GetSampleIndex(size_t pixelIndex) const { return m_SampleCounts[pixelIndex]; }
+
+		//Blends the frame's samples in hdrBuffer (their average, for pixels that took several) into the reprojected history
+		//and writes the result back, pixels that took none get their history. The result and primaryHits, traced with camera,
+		//are the next frame's history. The sample counts move past the samples of this frame
+		void Accumulate(HdrBuffer& hdrBuffer, const std::vector<PrimaryHit>& primaryHits, const Camera& camera);
+
+		//Forgets all history, for when pixels change while the camera doesn't (lighting mode, shadows)
+		void Reset() { m_HasHistory = false; }
+
+	private:
+		void Resize(int width, int height);
+		//History color and length of the previous frame at the world position of the hit, a length of 0 if none fits
+		void LookUpHistory(const PrimaryHit& primaryHit, ColorRGB& color, float& length) const;
+
+		TemporalCacheSettings m_Settings{};
+
+		int m_Width{};
+		int m_Height{};
+		//Frames begun, picks the pixels whose turn it is to skip
+		uint32_t m_FrameCount{ 0 };
+
+		std::vector<PrimaryHit> m_PreviousHits{};
+		Camera m_PreviousCamera{};
+		bool m_HasHistory{ false };
+
+		//Accumulated colors and how many frames they average (fewer once capped), as of the previous frame
+		HdrBuffer m_HistoryColors{};
+		std::vector<float> m_HistoryLengths{};
+
+		//Samples traced for every pixel so far, kept when the history is reset
+		std::vector<uint32_t> m_SampleCounts{};
+
+		//The same, moved to the current frame's pixels by Reproject, and the samples each pixel takes this frame
+		HdrBuffer m_ReprojectedColors{};
+		std::vector<float> m_ReprojectedLengths{};
+		std::vector<uint32_t> m_FrameSamples{};
+	};
+}
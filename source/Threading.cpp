@@ -0,0 +1,207 @@
+#include "Threading.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+
+#if defined(_MSC_VER)
+#include <ppl.h>
+#else
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#endif
+
+using namespace dae;
+
+namespace
+{
+	std::mutex g_SlotMutex{};
+	//Slot -> taken by a living thread
+	bool g_IsSlotTaken[MAX_THREAD_SLOTS]{};
+
+	//Set while the thread runs tasks of a ParallelFor, a nested one then runs serially
+	thread_local bool t_IsInsideParallelFor{ false };
+
+	void RunSerially(uint32_t begin, uint32_t end, const std::function<void(uint32_t)>& task)
+	{
+		for (uint32_t index{ begin }; index < end; ++index)
+		{
+			task(index);
+		}
+	}
+}
+
+uint32_t dae::detail::AcquireThreadSlot()
+{
+	{
+		const std::lock_guard lock{ g_SlotMutex };
+		for (uint32_t slot{ 0 }; slot < MAX_THREAD_SLOTS; ++slot)
+		{
+			if (!g_IsSlotTaken[slot])
+			{
+				g_IsSlotTaken[slot] = true;
+				return slot;
+			}
+		}
+	}
+
+	std::cerr << "More than " << MAX_THREAD_SLOTS << " threads touch per-thread render data at the same time" << std::endl;
+	std::abort();
+}
+
+void dae::detail::ReleaseThreadSlot(uint32_t slot)
+{
+	const std::lock_guard lock{ g_SlotMutex };
+	g_IsSlotTaken[slot] = false;
+}
+
+#if defined(_MSC_VER)
+
+void dae::ParallelFor(uint32_t begin, uint32_t end, const std::function<void(uint32_t)>& task)
+{
+	if (t_IsInsideParallelFor)
+	{
+		RunSerially(begin, end, task);
+		return;
+	}
+
+	//PPL would happily nest, the flag is set on whichever thread (a PPL worker or this one) runs a task
+	concurrency::parallel_for(begin, end, [&task](uint32_t index) {
+		t_IsInsideParallelFor = true;
+		task(index);
+		t_IsInsideParallelFor = false;
+	});
+}
+
+#else
+
+namespace
+{
+	//Workers live as long as the program, so their thread slots (and per-thread data) stay valid across frames
+	class ThreadPool final
+	{
+	public:
+		ThreadPool()
+		{
+			const uint32_t numWorkers{ std::max(std::thread::hardware_concurrency(), 1u) - 1 };
+
+			m_Workers.reserve(numWorkers);
+			for (uint32_t workerIdx{ 0 }; workerIdx < numWorkers; ++workerIdx)
+			{
+				m_Workers.emplace_back([this] { WorkerLoop(); });
+			}
+		}
+
+		~ThreadPool()
+		{
+			{
+				const std::lock_guard lock{ m_Mutex };
+				m_IsStopping = true;
+			}
+			m_WorkAvailable.notify_all();
+
+			for (std::thread& worker : m_Workers)
+			{
+				worker.join();
+			}
+		}
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool(ThreadPool&&) noexcept = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+		ThreadPool& operator=(ThreadPool&&) noexcept = delete;
+
+		void Run(uint32_t begin, uint32_t end, const std::function<void(uint32_t)>& task)
+		{
+			//One job at a time, other callers wait for their turn
+			const std::lock_guard runLock{ m_RunMutex };
+
+			{
+				const std::lock_guard lock{ m_Mutex };
+				m_pTask = &task;
+				m_NextIndex.store(begin, std::memory_order_relaxed);
+				m_EndIndex = end;
+				m_NumBusyWorkers = uint32_t(m_Workers.size());
+				++m_Generation;
+			}
+			m_WorkAvailable.notify_all();
+
+			DoWork();
+
+			std::unique_lock lock{ m_Mutex };
+			m_WorkDone.wait(lock, [this] { return m_NumBusyWorkers == 0; });
+			m_pTask = nullptr;
+		}
+
+	private:
+		void WorkerLoop()
+		{
+			uint64_t lastGeneration{ 0 };
+
+			while (true)
+			{
+				{
+					std::unique_lock lock{ m_Mutex };
+					m_WorkAvailable.wait(lock, [&] { return m_IsStopping || m_Generation != lastGeneration; });
+
+					if (m_IsStopping)
+						return;
+
+					lastGeneration = m_Generation;
+				}
+
+				DoWork();
+
+				{
+					const std::lock_guard lock{ m_Mutex };
+					--m_NumBusyWorkers;
+				}
+				m_WorkDone.notify_one();
+			}
+		}
+
+		//Every participating thread pulls indices until the range is exhausted
+		void DoWork()
+		{
+			t_IsInsideParallelFor = true;
+
+			for (uint32_t index{ m_NextIndex.fetch_add(1, std::memory_order_relaxed) }; index < m_EndIndex; index = m_NextIndex.fetch_add(1, std::memory_order_relaxed))
+			{
+				(*m_pTask)(index);
+			}
+
+			t_IsInsideParallelFor = false;
+		}
+
+		std::vector<std::thread> m_Workers{};
+
+		std::mutex m_RunMutex{};
+		std::mutex m_Mutex{};
+		std::condition_variable m_WorkAvailable{};
+		std::condition_variable m_WorkDone{};
+
+		const std::function<void(uint32_t)>* m_pTask{};
+		std::atomic<uint32_t> m_NextIndex{};
+		uint32_t m_EndIndex{};
+		uint32_t m_NumBusyWorkers{};
+		uint64_t m_Generation{};
+		bool m_IsStopping{ false };
+	};
+}
+
+void dae::ParallelFor(uint32_t begin, uint32_t end, const std::function<void(uint32_t)>& task)
+{
+	if (t_IsInsideParallelFor)
+	{
+		RunSerially(begin, end, task);
+		return;
+	}
+
+	static ThreadPool s_ThreadPool{};
+	s_ThreadPool.Run(begin, end, task);
+}
+
+#endif
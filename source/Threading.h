@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+
+namespace dae
+{
+	//Upper bound on the number of threads alive at the same time that touch per-thread render data (main + worker pool + pipeline threads)
+	constexpr uint32_t MAX_THREAD_SLOTS{ 128 };
+
+	namespace detail
+	{
+		//Exits the program when all slots are taken: indexing past MAX_THREAD_SLOTS would write past per-thread storage
+		uint32_t AcquireThreadSlot();
+		void ReleaseThreadSlot(uint32_t slot);
+
+		//Holds the slot of the thread it belongs to, gives it back when the thread exits
+		struct ThreadSlot final
+		{
+			ThreadSlot() : index{ AcquireThreadSlot() } {}
+			~ThreadSlot() { ReleaseThreadSlot(index); }
+
+			ThreadSlot(const ThreadSlot&) = delete;
+			ThreadSlot(ThreadSlot&&) noexcept = delete;
+			ThreadSlot& operator=(const ThreadSlot&) = delete;
+			ThreadSlot& operator=(ThreadSlot&&) noexcept = delete;
+
+			const uint32_t index;
+		};
+	}
+
+	/**
+	 * \brief Returns a small, stable index for the calling thread.
+	 * A thread takes a free slot on its first call and gives it back when it exits, so no two living threads
+	 * share one and per-thread storage can be indexed without locks. A later thread inherits what an exited one left in its slot.
+	 */
+	inline uint32_t GetThreadSlot()
+	{
+		thread_local const detail::ThreadSlot t_Slot{};
+		return t_Slot.index;
+	}
+
+	/**
+	 * \brief Calls task(index) for every index in [begin, end) spread over all cores, returns when all are done.
+	 * PPL's parallel_for on MSVC, a persistent worker pool (plus the calling thread) everywhere else.
+	 * A ParallelFor started from inside another one runs serially on the calling thread.
+	 */
+	void ParallelFor(uint32_t begin, uint32_t end, const std::function<void(uint32_t)>& task);
+}
@@ -0,0 +1,72 @@
+#include "TileLightLists.h"
+#include "Camera.h"
+#include "Renderer.h"
+#include "Threading.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace dae;
+
+namespace
+{
+	//Signed distance of a camera space point to a plane through the camera, given by its inward normal (nx, 0, nz) or (0, ny, nz)
+	float DistanceToPlane(float pointA, float pointZ, float normalA, float normalZ)
+	{
+		return (pointA * normalA + pointZ * normalZ) / sqrtf(normalA * normalA + normalZ * normalZ);
+	}
+}
+
+bool TileLightLists::HasBoundedLights(const std::vector<Light>& lights)
+{
+	return std::any_of(lights.begin(), lights.end(), [](const Light& light) { return light.influenceRadius > 0.f; });
+}
+
+void TileLightLists::Build(const std::vector<Light>& lights, const Camera& camera, const ImagePlane& imagePlane, uint32_t tileSize)
+{
+	m_CameraSpaceSpheres.resize(lights.size());
+	for (size_t lightIdx{ 0 }; lightIdx < lights.size(); ++lightIdx)
+	{
+		const Light& light{ lights[lightIdx] };
+		const Vector3 toLight{ light.origin - camera.origin };
+		m_CameraSpaceSpheres[lightIdx] = Vector4{ Vector3::Dot(toLight, camera.right), Vector3::Dot(toLight, camera.up), Vector3::Dot(toLight, camera.forward), light.influenceRadius };
+	}
+
+	const uint32_t numTilesX{ (uint32_t(imagePlane.width) + tileSize - 1) / tileSize };
+	const uint32_t numTilesY{ (uint32_t(imagePlane.height) + tileSize - 1) / tileSize };
+	m_TileLights.resize(size_t(numTilesX) * numTilesY);
+
+	ParallelFor(0u, numTilesX * numTilesY, [&](uint32_t tileIndex) {
+		const uint32_t tileStartX{ (tileIndex % numTilesX) * tileSize };
+		const uint32_t tileStartY{ (tileIndex / numTilesX) * tileSize };
+		const uint32_t tileEndX{ std::min(tileStartX + tileSize, uint32_t(imagePlane.width)) };
+		const uint32_t tileEndY{ std::min(tileStartY + tileSize, uint32_t(imagePlane.height)) };
+
+		//Slopes of the tile's edges on the image plane at z = 1, the same mapping as ImagePlane::GetPrimaryRay
+		const float slopeLeft{ ((2.f * tileStartX / imagePlane.width) - 1) * imagePlane.aspectRatio * imagePlane.fov };
+		const float slopeRight{ ((2.f * tileEndX / imagePlane.width) - 1) * imagePlane.aspectRatio * imagePlane.fov };
+		const float slopeTop{ (1 - (2.f * tileStartY / imagePlane.height)) * imagePlane.fov };
+		const float slopeBottom{ (1 - (2.f * tileEndY / imagePlane.height)) * imagePlane.fov };
+
+		std::vector<Light>& tileLights{ m_TileLights[tileIndex] };
+		tileLights.clear();
+
+		for (size_t lightIdx{ 0 }; lightIdx < lights.size(); ++lightIdx)
+		{
+			const Vector4& sphere{ m_CameraSpaceSpheres[lightIdx] };
+			const float radius{ sphere.w };
+
+			//A sphere is culled once it lies entirely outside one of the four side planes or behind the camera.
+			//Near the frustum's corners this keeps some spheres that miss it, which only costs a few range checks
+			const bool isVisible{ radius <= 0.f || (
+				sphere.z >= -radius &&
+				DistanceToPlane(sphere.x, sphere.z, 1.f, -slopeLeft) >= -radius &&
+				DistanceToPlane(sphere.x, sphere.z, -1.f, slopeRight) >= -radius &&
+				DistanceToPlane(sphere.y, sphere.z, -1.f, slopeTop) >= -radius &&
+				DistanceToPlane(sphere.y, sphere.z, 1.f, -slopeBottom) >= -radius) };
+
+			if (isVisible)
+				tileLights.push_back(lights[lightIdx]);
+		}
+	});
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "DataTypes.h"
+
+namespace dae
+{
+	struct Camera;
+	struct ImagePlane;
+
+	/**
+	 * \brief Per-tile light lists, as in tiled deferred shading: every light with an influence radius is tested against the frustum
+	 * of every tileSize x tileSize tile of the image, a tile only keeps the lights whose sphere of influence reaches into it.
+	 * Lights without a radius (directional lights included) are kept by every tile.
+	 * The lists only hold for primary hits, light bouncing in from outside a tile's frustum isn't covered.
+	 */
+	class TileLightLists final
+	{
+	public:
+		TileLightLists() = default;
+		~TileLightLists() = default;
+
+		TileLightLists(const TileLightLists&) = delete;
+		TileLightLists(TileLightLists&&) noexcept = delete;
+		TileLightLists& operator=(const TileLightLists&) = delete;
+		TileLightLists& operator=(TileLightLists&&) noexcept = delete;
+
+		//Culling only pays off when at least one light has an influence radius
+		static bool HasBoundedLights(const std::vector<Light>& lights);
+
+		//Rebuilds the lists for this frame's camera. Tiles are numbered row by row, like the renderer hands them out.
+		//The camera's cameraToWorld (and right, up, forward) has to be up to date
+		void Build(const std::vector<Light>& lights, const Camera& camera, const ImagePlane& imagePlane, uint32_t tileSize);
+
+		const std::vector<Light>& GetTileLights(uint32_t tileIndex) const { return m_TileLights[tileIndex]; }
+
+	private:
+		//Light centers in camera space (x right, y up, z forward) with their influence radius in w, 0 for unbounded lights
+		std::vector<Vector4> m_CameraSpaceSpheres{};
+
+		//Copies rather than indices, so a tile's lights sit next to each other and can be passed on as a regular light list.
+		//Kept between frames, only the first frame allocates
+		std::vector<std::vector<Light>> m_TileLights{};
+	};
+}
@@ -1,23 +1,50 @@
 #include "Timer.h"
 
+#include <cfloat>
 #include <iostream>
 #include <numeric>
 
 #include <iostream>
 #include <fstream>
 
+#if defined(HEADLESS)
+#include <chrono>
+#else
 #include "SDL.h"
+#endif
 using namespace dae;
 
+namespace
+{
+	//High resolution counter, SDL's when there is a window and the steady clock otherwise
+	uint64_t GetPerformanceCounter()
+	{
+#if defined(HEADLESS)
+		return uint64_t(std::chrono::steady_clock::now().time_since_epoch().count());
+#else
+		return SDL_GetPerformanceCounter();
+#endif
+	}
+
+	uint64_t GetPerformanceFrequency()
+	{
+#if defined(HEADLESS)
+		return uint64_t(std::chrono::steady_clock::period::den / std::chrono::steady_clock::period::num);
+#else
+		return SDL_GetPerformanceFrequency();
+#endif
+	}
+}
+
 Timer::Timer()
 {
-	const uint64_t countsPerSecond = SDL_GetPerformanceFrequency();
+	const uint64_t countsPerSecond = GetPerformanceFrequency();
 	m_SecondsPerCount = 1.0f / static_cast<float>(countsPerSecond);
 }
 
 void Timer::Reset()
 {
-	const uint64_t currentTime = SDL_GetPerformanceCounter();
+	const uint64_t currentTime = GetPerformanceCounter();
 
 	m_BaseTime = currentTime;
 	m_PreviousTime = currentTime;
@@ -29,7 +56,7 @@ void Timer::Reset()
 
 void Timer::Start()
 {
-	const uint64_t startTime = SDL_GetPerformanceCounter();
+	const uint64_t startTime = GetPerformanceCounter();
 
 	if (m_IsStopped)
 	{
@@ -74,7 +101,14 @@ void Timer::Update()
 		return;
 	}
 
-	const uint64_t currentTime = SDL_GetPerformanceCounter();
+	if (m_FixedTimeStep > 0.0f)
+	{
+		m_ElapsedTime = m_FixedTimeStep;
+		m_TotalTime += m_FixedTimeStep;
+		return;
+	}
+
+	const uint64_t currentTime = GetPerformanceCounter();
 	m_CurrentTime = currentTime;
 
 	m_ElapsedTime = (float)((m_CurrentTime - m_PreviousTime) * m_SecondsPerCount);
@@ -135,7 +169,7 @@ void Timer::Stop()
 {
 	if (!m_IsStopped)
 	{
-		const uint64_t currentTime = SDL_GetPerformanceCounter();
+		const uint64_t currentTime = GetPerformanceCounter();
 
 		m_StopTime = currentTime;
 		m_IsStopped = true;
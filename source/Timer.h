@@ -19,6 +19,9 @@ namespace dae
 
 		void StartBenchmark(int numFrames = 10);
 
+		//Every Update advances the timer by exactly elapsedSeconds (deterministic playback), 0 = wall clock
+		void SetFixedTimeStep(float elapsedSeconds) { m_FixedTimeStep = elapsedSeconds; }
+
 		void Reset();
 		void Start();
 		void Update();
@@ -47,6 +50,8 @@ namespace dae
 		float m_ElapsedUpperBound = 0.03f;
 		float m_FPSTimer = 0.0f;
 
+		float m_FixedTimeStep = 0.0f;
+
 		bool m_IsStopped = true;
 		bool m_ForceElapsedUpperBound = false;
 
@@ -0,0 +1,180 @@
+#include "ToneMapper.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+#include "CpuFeatures.h"
+#include "Float8.h"
+
+using namespace dae;
+
+namespace
+{
+#if defined(FLOAT8_SSE)
+	//Channels in [0, 1], truncated to 8 bit like static_cast<uint8_t>(c * 255) and shifted into place
+	inline void Pack8(const Float8& red, const Float8& green, const Float8& blue, const PixelLayout& layout, uint32_t* pPixels)
+	{
+		const __m128 scale{ _mm_set1_ps(255.f) };
+		const __m128i redShift{ _mm_cvtsi32_si128(int(layout.redShift)) };
+		const __m128i greenShift{ _mm_cvtsi32_si128(int(layout.greenShift)) };
+		const __m128i blueShift{ _mm_cvtsi32_si128(int(layout.blueShift)) };
+		const __m128i alpha{ _mm_set1_epi32(int(layout.alphaMask)) };
+
+		const auto pack4 = [&](__m128 r, __m128 g, __m128 b) {
+			__m128i pixels{ _mm_sll_epi32(_mm_cvttps_epi32(_mm_mul_ps(r, scale)), redShift) };
+			pixels = _mm_or_si128(pixels, _mm_sll_epi32(_mm_cvttps_epi32(_mm_mul_ps(g, scale)), greenShift));
+			pixels = _mm_or_si128(pixels, _mm_sll_epi32(_mm_cvttps_epi32(_mm_mul_ps(b, scale)), blueShift));
+			return _mm_or_si128(pixels, alpha);
+		};
+
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(pPixels), pack4(red.lo, green.lo, blue.lo));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(pPixels + 4), pack4(red.hi, green.hi, blue.hi));
+	}
+#else
+	inline void Pack8(const Float8& red, const Float8& green, const Float8& blue, const PixelLayout& layout, uint32_t* pPixels)
+	{
+		for (int lane{ 0 }; lane < 8; ++lane)
+		{
+			pPixels[lane] = layout.alphaMask
+				| (uint32_t(red.values[lane] * 255) << layout.redShift)
+				| (uint32_t(green.values[lane] * 255) << layout.greenShift)
+				| (uint32_t(blue.values[lane] * 255) << layout.blueShift);
+		}
+	}
+#endif
+
+	template<ToneMapOperator toneMapOperator>
+	inline void ToneMap8(Float8& red, Float8& green, Float8& blue)
+	{
+		const Float8 one{ Set8(1.f) };
+
+		if constexpr (toneMapOperator == ToneMapOperator::MaxToOne) {
+			const Float8 divisor{ Max8(Max8(red, Max8(green, blue)), one) };
+			red = red / divisor;
+			green = green / divisor;
+			blue = blue / divisor;
+		}
+		else if constexpr (toneMapOperator == ToneMapOperator::Reinhard) {
+			red = red / (red + one);
+			green = green / (green + one);
+			blue = blue / (blue + one);
+		}
+		else if constexpr (toneMapOperator == ToneMapOperator::ACES) {
+			//Narkowicz's fit of the ACES filmic curve: x(2.51x + 0.03) / (x(2.43x + 0.59) + 0.14)
+			const auto aces = [](const Float8& x) {
+				return (x * (Set8(2.51f) * x + Set8(0.03f))) / (x * (Set8(2.43f) * x + Set8(0.59f)) + Set8(0.14f));
+			};
+			red = aces(red);
+			green = aces(green);
+			blue = aces(blue);
+		}
+
+		//Clamp is just this
+		const Float8 zero{ Set8(0.f) };
+		red = Min8(Max8(red, zero), one);
+		green = Min8(Max8(green, zero), one);
+		blue = Min8(Max8(blue, zero), one);
+	}
+
+	//Linear [0, 1] to sRGB. The power curve is approximated with square roots (max error ~0.25 of an 8 bit step)
+	inline Float8 EncodeSRGB8(const Float8& linear)
+	{
+		const Float8 sqrt1{ Sqrt8(linear) };
+		const Float8 sqrt2{ Sqrt8(sqrt1) };
+		const Float8 sqrt3{ Sqrt8(sqrt2) };
+		const Float8 curve{ Set8(0.662002687f) * sqrt1 + Set8(0.684122060f) * sqrt2 - Set8(0.323583601f) * sqrt3 - Set8(0.0225411470f) * linear };
+
+		return SelectLessEqual8(linear, 0.0031308f, Set8(12.92f) * linear, curve);
+	}
+
+	template<ToneMapOperator toneMapOperator, bool srgbEnabled>
+	HOT_KERNEL void ToneMapPixels(const HdrBuffer& hdrBuffer, size_t firstPixel, size_t numPixels, uint32_t* pPixels, const PixelLayout& layout, float exposure)
+	{
+		const Float8 exposureLanes{ Set8(exposure) };
+		const size_t endPixel{ firstPixel + numPixels };
+
+		for (size_t pixelIndex{ firstPixel }; pixelIndex < endPixel; pixelIndex += HdrBuffer::PIXEL_BLOCK_SIZE)
+		{
+			Float8 red{ Load8(hdrBuffer.red.data() + pixelIndex) * exposureLanes };
+			Float8 green{ Load8(hdrBuffer.green.data() + pixelIndex) * exposureLanes };
+			Float8 blue{ Load8(hdrBuffer.blue.data() + pixelIndex) * exposureLanes };
+
+			ToneMap8<toneMapOperator>(red, green, blue);
+
+			if constexpr (srgbEnabled) {
+				red = EncodeSRGB8(red);
+				green = EncodeSRGB8(green);
+				blue = EncodeSRGB8(blue);
+			}
+
+			//The HDR planes are padded, the output isn't: the last partial block goes through a temporary
+			if (endPixel - pixelIndex >= HdrBuffer::PIXEL_BLOCK_SIZE) {
+				Pack8(red, green, blue, layout, pPixels + pixelIndex);
+			}
+			else {
+				uint32_t lastPixels[HdrBuffer::PIXEL_BLOCK_SIZE]{};
+				Pack8(red, green, blue, layout, lastPixels);
+				std::memcpy(pPixels + pixelIndex, lastPixels, (endPixel - pixelIndex) * sizeof(uint32_t));
+			}
+		}
+	}
+
+	template<ToneMapOperator toneMapOperator>
+	void ToneMapPixels(bool srgbEnabled, const HdrBuffer& hdrBuffer, size_t firstPixel, size_t numPixels, uint32_t* pPixels, const PixelLayout& layout, float exposure)
+	{
+		if (srgbEnabled)
+			ToneMapPixels<toneMapOperator, true>(hdrBuffer, firstPixel, numPixels, pPixels, layout, exposure);
+		else
+			ToneMapPixels<toneMapOperator, false>(hdrBuffer, firstPixel, numPixels, pPixels, layout, exposure);
+	}
+}
+
+const char* dae::ToString(ToneMapOperator toneMapOperator)
+{
+	switch (toneMapOperator)
+	{
+	case ToneMapOperator::MaxToOne:
+		return "MaxToOne";
+	case ToneMapOperator::Clamp:
+		return "Clamp";
+	case ToneMapOperator::Reinhard:
+		return "Reinhard";
+	case ToneMapOperator::ACES:
+		return "ACES";
+	}
+
+	return "Unknown";
+}
+
+void ToneMapper::Apply(const HdrBuffer& hdrBuffer, size_t firstPixel, size_t numPixels, uint32_t* pPixels, const PixelLayout& layout) const
+{
+	//Blocks have to line up with the padding of the HDR planes
+	assert(firstPixel % HdrBuffer::PIXEL_BLOCK_SIZE == 0);
+	assert(firstPixel + numPixels <= hdrBuffer.GetPixelCount());
+
+	const bool sRGBEnabled{ m_SRGBEnabled };
+	const float exposure{ m_Exposure };
+
+	switch (m_Operator.load())
+	{
+	case ToneMapOperator::MaxToOne:
+		ToneMapPixels<ToneMapOperator::MaxToOne>(sRGBEnabled, hdrBuffer, firstPixel, numPixels, pPixels, layout, exposure);
+		break;
+	case ToneMapOperator::Clamp:
+		ToneMapPixels<ToneMapOperator::Clamp>(sRGBEnabled, hdrBuffer, firstPixel, numPixels, pPixels, layout, exposure);
+		break;
+	case ToneMapOperator::Reinhard:
+		ToneMapPixels<ToneMapOperator::Reinhard>(sRGBEnabled, hdrBuffer, firstPixel, numPixels, pPixels, layout, exposure);
+		break;
+	case ToneMapOperator::ACES:
+		ToneMapPixels<ToneMapOperator::ACES>(sRGBEnabled, hdrBuffer, firstPixel, numPixels, pPixels, layout, exposure);
+		break;
+	}
+}
+
+void ToneMapper::CycleOperator()
+{
+	m_Operator = ToneMapOperator((int(m_Operator.load()) + 1) % 4);
+}
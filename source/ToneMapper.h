@@ -0,0 +1,59 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "HdrBuffer.h"
+
+namespace dae
+{
+	//MaxToOne scales a color down by its brightest channel, the look the renderer always had
+	enum class ToneMapOperator { MaxToOne, Clamp, Reinhard, ACES };
+
+	//Where the 8 bit channels go in a 32 bit pixel
+	struct PixelLayout
+	{
+		uint32_t redShift{ 16 };
+		uint32_t greenShift{ 8 };
+		uint32_t blueShift{ 0 };
+		uint32_t alphaMask{ 0xFF000000 };
+	};
+
+	const char* ToString(ToneMapOperator toneMapOperator);
+
+	/**
+	 * \brief Turns the linear HDR buffer into displayable 32 bit pixels: exposure, tone mapping operator,
+	 * optional sRGB encoding and packing, 8 pixels per step. Runs as its own pass after tracing,
+	 * so operators can be swapped without touching the trace code.
+	 */
+	class ToneMapper final
+	{
+	public:
+		ToneMapper() = default;
+		~ToneMapper() = default;
+
+		ToneMapper(const ToneMapper&) = delete;
+		ToneMapper(ToneMapper&&) noexcept = delete;
+		ToneMapper& operator=(const ToneMapper&) = delete;
+		ToneMapper& operator=(ToneMapper&&) noexcept = delete;
+
+		//Maps pixels [firstPixel, firstPixel + numPixels) of hdrBuffer into pPixels (indexed the same way)
+		void Apply(const HdrBuffer& hdrBuffer, size_t firstPixel, size_t numPixels, uint32_t* pPixels, const PixelLayout& layout) const;
+
+		void SetOperator(ToneMapOperator toneMapOperator) { m_Operator = toneMapOperator; }
+		void CycleOperator();
+		ToneMapOperator GetOperator() const { return m_Operator; }
+
+		void SetExposure(float exposure) { m_Exposure = exposure; }
+		float GetExposure() const { return m_Exposure; }
+
+		void ToggleSRGB() { m_SRGBEnabled = !m_SRGBEnabled.load(); }
+		bool IsSRGBEnabled() const { return m_SRGBEnabled; }
+
+	private:
+		//Changed from input while a pipelined frame is being presented, Apply reads each of them once
+		std::atomic<ToneMapOperator> m_Operator{ ToneMapOperator::MaxToOne };
+		std::atomic<float> m_Exposure{ 1.f };
+		std::atomic<bool> m_SRGBEnabled{ false };
+	};
+}
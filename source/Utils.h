@@ -1,9 +1,12 @@
 #pragma once
+#include <algorithm>
 #include <cassert>
 #include <fstream>
 #include "Math.h"
 #include "DataTypes.h"
+#include "RayStats.h"
 
+//Default algorithms, Scene::CalibrateIntersectionAlgorithms can pick others at runtime
 //#define SPHERE_ANALYTIC
 #define SPHERE_GEOMETRIC
 
@@ -14,11 +17,23 @@ namespace dae
 {
 	namespace GeometryUtils
 	{
+#if defined(SPHERE_ANALYTIC)
+		constexpr SphereAlgorithm DEFAULT_SPHERE_ALGORITHM{ SphereAlgorithm::Analytic };
+#elif defined(SPHERE_GEOMETRIC)
+		constexpr SphereAlgorithm DEFAULT_SPHERE_ALGORITHM{ SphereAlgorithm::Geometric };
+#endif
+
+#if defined(TRIANGLE_NAIVE)
+		constexpr TriangleAlgorithm DEFAULT_TRIANGLE_ALGORITHM{ TriangleAlgorithm::Naive };
+#elif defined(TRIANGLE_MT)
+		constexpr TriangleAlgorithm DEFAULT_TRIANGLE_ALGORITHM{ TriangleAlgorithm::MollerTrumbore };
+#endif
+
 #pragma region Sphere HitTest
 		//SPHERE HIT-TESTS
-		inline bool HitTest_Sphere(const Sphere& sphere, const Ray& ray, HitRecord& hitRecord, bool ignoreHitRecord = false)
+		inline bool HitTest_Sphere_Analytic(const Sphere& sphere, const Ray& ray, HitRecord& hitRecord, bool ignoreHitRecord = false)
 		{
-#if defined(SPHERE_ANALYTIC)
+			RAY_STATS_INC(sphereTests);
 
 			// Analytic solution
 			Vector3 L{ray.origin - sphere.origin};
@@ -44,15 +59,17 @@ namespace dae
 				hitRecord.didHit = true;
 				hitRecord.materialIndex = sphere.materialIndex;
 				hitRecord.t = t;
-				hitRecord.origin = ray.origin + ray.direction * t;
+				hitRecord.origin = Vector3::MulAdd(ray.direction, t, ray.origin);
 				hitRecord.normal = hitRecord.origin - sphere.origin;
 
 				return true;
 			}
 			return false;
+		}
 
-
-#elif defined(SPHERE_GEOMETRIC)
+		inline bool HitTest_Sphere_Geometric(const Sphere& sphere, const Ray& ray, HitRecord& hitRecord, bool ignoreHitRecord = false)
+		{
+			RAY_STATS_INC(sphereTests);
 
 			// Geometric Solution
 			// hypothenuse
@@ -80,13 +97,26 @@ namespace dae
 				hitRecord.didHit = true;
 				hitRecord.materialIndex = sphere.materialIndex;
 				hitRecord.t = t;
-				hitRecord.origin = ray.origin + ray.direction * t;
+				hitRecord.origin = Vector3::MulAdd(ray.direction, t, ray.origin);
 				hitRecord.normal = (hitRecord.origin - sphere.origin).Normalized();
 
 				return true;
 			}
 			return false;
-#endif
+		}
+
+		template<SphereAlgorithm algorithm>
+		inline bool HitTest_Sphere(const Sphere& sphere, const Ray& ray, HitRecord& hitRecord, bool ignoreHitRecord = false)
+		{
+			if constexpr (algorithm == SphereAlgorithm::Analytic)
+				return HitTest_Sphere_Analytic(sphere, ray, hitRecord, ignoreHitRecord);
+			else
+				return HitTest_Sphere_Geometric(sphere, ray, hitRecord, ignoreHitRecord);
+		}
+
+		inline bool HitTest_Sphere(const Sphere& sphere, const Ray& ray, HitRecord& hitRecord, bool ignoreHitRecord = false)
+		{
+			return HitTest_Sphere<DEFAULT_SPHERE_ALGORITHM>(sphere, ray, hitRecord, ignoreHitRecord);
 		}
 
 		inline bool HitTest_Sphere(const Sphere& sphere, const Ray& ray)
@@ -99,6 +129,8 @@ namespace dae
 		//PLANE HIT-TESTS
 		inline bool HitTest_Plane(const Plane& plane, const Ray& ray, HitRecord& hitRecord, bool ignoreHitRecord = false)
 		{
+			RAY_STATS_INC(planeTests);
+
 			float t = Vector3::Dot(plane.origin - ray.origin, plane.normal) / Vector3::Dot(ray.direction, plane.normal);
 
 			if (t >= ray.min && t <= ray.max) {
@@ -109,7 +141,7 @@ namespace dae
 				hitRecord.didHit = true;
 				hitRecord.materialIndex = plane.materialIndex;
 				hitRecord.t = t;
-				hitRecord.origin = ray.origin + ray.direction * t;
+				hitRecord.origin = Vector3::MulAdd(ray.direction, t, ray.origin);
 				hitRecord.normal = plane.normal.Normalized();
 
 				return true;
@@ -126,9 +158,9 @@ namespace dae
 #pragma endregion
 #pragma region Triangle HitTest
 		//TRIANGLE HIT-TESTS
-		inline bool HitTest_Triangle(const Triangle& triangle, const Ray& ray, HitRecord& hitRecord, bool ignoreHitRecord = false)
+		//Culling checks, true if the triangle can't be hit by this ray
+		inline bool IsTriangleCulled(const Triangle& triangle, const Ray& ray, bool ignoreHitRecord)
 		{
-			// Culling checks
 			float dotProduct{ Vector3::Dot(triangle.normal, ray.direction) };
 			// Ray doesn't hit the plane
 			if (	dotProduct == 0 
@@ -137,10 +169,20 @@ namespace dae
 				||	(dotProduct > 0 && triangle.cullMode == TriangleCullMode::FrontFaceCulling && ignoreHitRecord)	// frontface shadow ray
 				||	(dotProduct < 0 && triangle.cullMode == TriangleCullMode::BackFaceCulling && ignoreHitRecord)	// backface shadow ray	
 			) {
+				return true;
+			}
+
+			return false;
+		}
+
+		inline bool HitTest_Triangle_Naive(const Triangle& triangle, const Ray& ray, HitRecord& hitRecord, bool ignoreHitRecord = false)
+		{
+			RAY_STATS_INC(triangleTests);
+
+			if (IsTriangleCulled(triangle, ray, ignoreHitRecord)) {
 				return false;
 			}
 
-#if defined(TRIANGLE_NAIVE)
 			// Naive Triangle Ray Intersection
 			// Plane hit check
 			Vector3 triangleCenter{ (triangle.v0 + triangle.v1 + triangle.v2) / 3 };
@@ -151,7 +193,7 @@ namespace dae
 			}
 
 			// Triangle check
-			Vector3 hitPoint{ ray.origin + ray.direction * t };
+			Vector3 hitPoint{ Vector3::MulAdd(ray.direction, t, ray.origin) };
 
 			//Side A
 			Vector3 side{ triangle.v1 - triangle.v0 };
@@ -186,7 +228,16 @@ namespace dae
 			hitRecord.normal = triangle.normal.Normalized();
 
 			return true;
-#elif defined(TRIANGLE_MT)
+		}
+
+		inline bool HitTest_Triangle_MT(const Triangle& triangle, const Ray& ray, HitRecord& hitRecord, bool ignoreHitRecord = false)
+		{
+			RAY_STATS_INC(triangleTests);
+
+			if (IsTriangleCulled(triangle, ray, ignoreHitRecord)) {
+				return false;
+			}
+
 			// Mller-Trumbore Triangle Ray Intersection
 			Vector3 edge1{ triangle.v1 - triangle.v0 };
 			Vector3 edge2{ triangle.v2 - triangle.v0 };
@@ -215,14 +266,27 @@ namespace dae
 				hitRecord.didHit = true;
 				hitRecord.materialIndex = triangle.materialIndex;
 				hitRecord.t = t;
-				hitRecord.origin = ray.origin + ray.direction * t;
+				hitRecord.origin = Vector3::MulAdd(ray.direction, t, ray.origin);
 				hitRecord.normal = triangle.normal.Normalized();
 
 				return true;
 			}
 
 			return false;
-#endif
+		}
+
+		template<TriangleAlgorithm algorithm>
+		inline bool HitTest_Triangle(const Triangle& triangle, const Ray& ray, HitRecord& hitRecord, bool ignoreHitRecord = false)
+		{
+			if constexpr (algorithm == TriangleAlgorithm::Naive)
+				return HitTest_Triangle_Naive(triangle, ray, hitRecord, ignoreHitRecord);
+			else
+				return HitTest_Triangle_MT(triangle, ray, hitRecord, ignoreHitRecord);
+		}
+
+		inline bool HitTest_Triangle(const Triangle& triangle, const Ray& ray, HitRecord& hitRecord, bool ignoreHitRecord = false)
+		{
+			return HitTest_Triangle<DEFAULT_TRIANGLE_ALGORITHM>(triangle, ray, hitRecord, ignoreHitRecord);
 		}
 
 		inline bool HitTest_Triangle(const Triangle& triangle, const Ray& ray)
@@ -252,9 +316,17 @@ namespace dae
 			tmin = std::max(tmin, std::min(tz1, tz2));
 			tmax = std::min(tmax, std::max(tz1, tz2));
 
-			return tmin > 0 && tmax >= tmin;
+			const bool didHit{ tmin > 0 && tmax >= tmin };
+#if defined(ENABLE_RAY_STATS)
+			if (didHit)
+				RAY_STATS_INC(slabTestsPassed);
+			else
+				RAY_STATS_INC(slabTestsFailed);
+#endif
+			return didHit;
 		}
 
+		template<TriangleAlgorithm algorithm>
 		inline bool HitTest_TriangleMesh(const TriangleMesh& mesh, const Ray& ray, HitRecord& hitRecord, bool ignoreHitRecord = false)
 		{
 			if (!SlabTest_TriangleMesh(mesh, ray)) {
@@ -272,13 +344,18 @@ namespace dae
 				triangle.v1 = mesh.transformedPositions[mesh.indices[(3 * index) + 1]];
 				triangle.v2 = mesh.transformedPositions[mesh.indices[(3 * index) + 2]];
 
-				if (HitTest_Triangle(triangle, ray, tempHitRecord) && tempHitRecord.t < hitRecord.t) {
+				if (HitTest_Triangle<algorithm>(triangle, ray, tempHitRecord) && tempHitRecord.t < hitRecord.t) {
 					hitRecord = tempHitRecord;
 				}
 			}
 			return hitRecord.didHit;
 		}
 
+		inline bool HitTest_TriangleMesh(const TriangleMesh& mesh, const Ray& ray, HitRecord& hitRecord, bool ignoreHitRecord = false)
+		{
+			return HitTest_TriangleMesh<DEFAULT_TRIANGLE_ALGORITHM>(mesh, ray, hitRecord, ignoreHitRecord);
+		}
+
 		inline bool HitTest_TriangleMesh(const TriangleMesh& mesh, const Ray& ray)
 		{
 			HitRecord temp{};
@@ -296,18 +373,54 @@ namespace dae
 			return {light.origin - origin};
 		}
 
+		//False beyond the light's influence radius, lights without one reach everywhere
+		inline bool IsInRange(const Light& light, float sqrDistance)
+		{
+			return light.influenceRadius <= 0.f || sqrDistance <= light.influenceRadius * light.influenceRadius;
+		}
+
+		//Distance at which a point light's brightest channel falls off to minRadiance
+		inline float GetInfluenceRadius(const Light& light, float minRadiance)
+		{
+			const float maxChannel{ std::max({ light.color.r, light.color.g, light.color.b }) };
+			return sqrtf(light.intensity * maxChannel / minRadiance);
+		}
+
+		//Radiance of a point or directional light arriving sqrDistance away, point lights fall off with the squared distance.
+		//Returns false beyond the light's influence radius. isPointLight is a parameter so callers that know it can drop the type check
+		inline bool GetPunctualRadiance(const Light& light, float sqrDistance, bool isPointLight, ColorRGB& radiance)
+		{
+			if (!IsInRange(light, sqrDistance))
+				return false;
+
+			radiance = light.color * light.intensity;
+			if (isPointLight)
+				radiance /= sqrDistance;
+			return true;
+		}
+
 		inline ColorRGB GetRadiance(const Light& light, const Vector3& target)
 		{
 			Vector3 lightDirection{ GetDirectionToLight(light, target) };
 
 			switch (light.type) {
 			case LightType::Point:
-				return (light.color * light.intensity) / (lightDirection.SqrMagnitude());
+			case LightType::Directional: {
+				ColorRGB radiance{};
+				GetPunctualRadiance(light, lightDirection.SqrMagnitude(), light.type == LightType::Point, radiance);
+				return radiance;
+			}
+			case LightType::Rect:
+			case LightType::Disk:
+				//From the center of the light, only on the side it emits to
+				return (light.color * (light.intensity * std::max(Vector3::Dot(light.direction, -lightDirection.Normalized()), 0.f))) / (lightDirection.SqrMagnitude());
 				break;
-			case LightType::Directional:
-				return (light.color * light.intensity);
+			case LightType::Sphere:
+				return (light.color * light.intensity) / (lightDirection.SqrMagnitude());
 				break;
 			}
+
+			return ColorRGB{};
 		}
 	}
 
@@ -367,13 +480,13 @@ namespace dae
 				Vector3 edgeV0V2 = positions[i2] - positions[i0];
 				Vector3 normal = Vector3::Cross(edgeV0V1, edgeV0V2);
 
-				if(isnan(normal.x))
+				if(std::isnan(normal.x))
 				{
 					int k = 0;
 				}
 
 				normal.Normalize();
-				if (isnan(normal.x))
+				if (std::isnan(normal.x))
 				{
 					int k = 0;
 				}
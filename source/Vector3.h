@@ -1,48 +1,202 @@
 #pragma once
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+//Back Vector3 with SSE registers (padded to 16 bytes), comment out for the plain scalar layout
+#define VECTOR3_SSE
+
+#if defined(VECTOR3_SSE)
+#include <xmmintrin.h>
+#endif
 
 namespace dae
 {
 	struct Vector4;
+
+	/**
+	 * \brief Defined in the header so every operation can inline into the hit tests and shading code.
+	 * With VECTOR3_SSE the vector is padded to 16 bytes and loaded into one SSE register, the padding lane (w) carries no meaning.
+	 */
+#if defined(VECTOR3_SSE)
+	struct alignas(16) Vector3
+#else
 	struct Vector3
+#endif
 	{
 		float x{};
 		float y{};
 		float z{};
+#if defined(VECTOR3_SSE)
+		float w{};
+#endif
 
 		Vector3() = default;
-		Vector3(float _x, float _y, float _z);
-		Vector3(const Vector3& from, const Vector3& to);
+		Vector3(float _x, float _y, float _z) : x(_x), y(_y), z(_z) {}
+		Vector3(const Vector3& from, const Vector3& to) : x(to.x - from.x), y(to.y - from.y), z(to.z - from.z) {}
 		Vector3(const Vector4& v);
 
-		float Magnitude() const;
-		float SqrMagnitude() const;
-		float Normalize();
-		Vector3 Normalized() const;
+#if defined(VECTOR3_SSE)
+		explicit Vector3(__m128 v) { _mm_store_ps(&x, v); }
+		__m128 Load() const { return _mm_load_ps(&x); }
+
+		//x + y + z of v, in the lowest lane
+		static __m128 HorizontalSum3(__m128 v)
+		{
+			const __m128 y{ _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1)) };
+			const __m128 z{ _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2)) };
+			return _mm_add_ss(_mm_add_ss(v, y), z);
+		}
+#endif
+
+		float Magnitude() const
+		{
+			return sqrtf(SqrMagnitude());
+		}
+
+		float SqrMagnitude() const
+		{
+			return Dot(*this, *this);
+		}
+
+		//Returns the length before normalizing
+		float Normalize()
+		{
+#if defined(VECTOR3_SSE)
+			//rsqrt estimate (12 bits) refined by one Newton-Raphson step: r' = r * (1.5 - 0.5 * sqr * r * r)
+			const __m128 v{ Load() };
+			const __m128 sqrMagnitude{ HorizontalSum3(_mm_mul_ps(v, v)) };
+			__m128 invMagnitude{ _mm_rsqrt_ss(sqrMagnitude) };
+			const __m128 halfSqrMagnitude{ _mm_mul_ss(sqrMagnitude, _mm_set_ss(0.5f)) };
+			invMagnitude = _mm_mul_ss(invMagnitude, _mm_sub_ss(_mm_set_ss(1.5f), _mm_mul_ss(halfSqrMagnitude, _mm_mul_ss(invMagnitude, invMagnitude))));
+
+			*this = Vector3{ _mm_mul_ps(v, _mm_shuffle_ps(invMagnitude, invMagnitude, _MM_SHUFFLE(0, 0, 0, 0))) };
+			return _mm_cvtss_f32(_mm_mul_ss(sqrMagnitude, invMagnitude));
+#else
+			const float m = Magnitude();
+			const float invM = 1.f / m;
+			x *= invM;
+			y *= invM;
+			z *= invM;
+
+			return m;
+#endif
+		}
+
+		Vector3 Normalized() const
+		{
+			Vector3 normalized{ *this };
+			normalized.Normalize();
+			return normalized;
+		}
+
+		static float Dot(const Vector3& v1, const Vector3& v2)
+		{
+#if defined(VECTOR3_SSE)
+			return _mm_cvtss_f32(HorizontalSum3(_mm_mul_ps(v1.Load(), v2.Load())));
+#else
+			return v1.x * v2.x + v1.y * v2.y + v1.z * v2.z;
+#endif
+		}
 
-		static float Dot(const Vector3& v1, const Vector3& v2);
-		static Vector3 Cross(const Vector3& v1, const Vector3& v2);
-		static Vector3 Project(const Vector3& v1, const Vector3& v2);
-		static Vector3 Reject(const Vector3& v1, const Vector3& v2);
-		static Vector3 Reflect(const Vector3& v1, const Vector3& v2);
-		static Vector3 Max(const Vector3& v1, const Vector3& v2);
-		static Vector3 Min(const Vector3& v1, const Vector3& v2);
+		static Vector3 Cross(const Vector3& v1, const Vector3& v2)
+		{
+#if defined(VECTOR3_SSE)
+			//v1.yzx * v2.zxy - v1.zxy * v2.yzx
+			const __m128 a{ v1.Load() };
+			const __m128 b{ v2.Load() };
+			const __m128 aYZX{ _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1)) };
+			const __m128 bYZX{ _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1)) };
+			const __m128 crossZXY{ _mm_sub_ps(_mm_mul_ps(a, bYZX), _mm_mul_ps(aYZX, b)) };
+			return Vector3{ _mm_shuffle_ps(crossZXY, crossZXY, _MM_SHUFFLE(3, 0, 2, 1)) };
+#else
+			return { v1.y * v2.z - v1.z * v2.y, v1.z * v2.x - v1.x * v2.z, v1.x * v2.y - v1.y * v2.x };
+#endif
+		}
+
+		static Vector3 Project(const Vector3& v1, const Vector3& v2)
+		{
+			return (v2 * (Dot(v1, v2) / Dot(v2, v2)));
+		}
+
+		static Vector3 Reject(const Vector3& v1, const Vector3& v2)
+		{
+			return (v1 - v2 * (Dot(v1, v2) / Dot(v2, v2)));
+		}
+
+		static Vector3 Reflect(const Vector3& v1, const Vector3& v2)
+		{
+			return MulAdd(v2, -2.f * Dot(v1, v2), v1);
+		}
+
+		static Vector3 Max(const Vector3& v1, const Vector3& v2)
+		{
+#if defined(VECTOR3_SSE)
+			return Vector3{ _mm_max_ps(v1.Load(), v2.Load()) };
+#else
+			return { std::max(v1.x, v2.x), std::max(v1.y, v2.y), std::max(v1.z, v2.z) };
+#endif
+		}
+
+		static Vector3 Min(const Vector3& v1, const Vector3& v2)
+		{
+#if defined(VECTOR3_SSE)
+			return Vector3{ _mm_min_ps(v1.Load(), v2.Load()) };
+#else
+			return { std::min(v1.x, v2.x), std::min(v1.y, v2.y), std::min(v1.z, v2.z) };
+#endif
+		}
+
+		//v * scale + offset in one go, e.g. the point at distance t along a ray
+		static Vector3 MulAdd(const Vector3& v, float scale, const Vector3& offset)
+		{
+#if defined(VECTOR3_SSE)
+			return Vector3{ _mm_add_ps(_mm_mul_ps(v.Load(), _mm_set1_ps(scale)), offset.Load()) };
+#else
+			return { v.x * scale + offset.x, v.y * scale + offset.y, v.z * scale + offset.z };
+#endif
+		}
 
 		Vector4 ToPoint4() const;
 		Vector4 ToVector4() const;
 
 		//Member Operators
-		Vector3 operator*(float scale) const;
-		Vector3 operator/(float scale) const;
-		Vector3 operator+(const Vector3& v) const;
-		Vector3 operator-(const Vector3& v) const;
-		Vector3 operator-() const;
+#if defined(VECTOR3_SSE)
+		Vector3 operator*(float scale) const { return Vector3{ _mm_mul_ps(Load(), _mm_set1_ps(scale)) }; }
+		Vector3 operator/(float scale) const { return Vector3{ _mm_div_ps(Load(), _mm_set1_ps(scale)) }; }
+		Vector3 operator+(const Vector3& v) const { return Vector3{ _mm_add_ps(Load(), v.Load()) }; }
+		Vector3 operator-(const Vector3& v) const { return Vector3{ _mm_sub_ps(Load(), v.Load()) }; }
+		Vector3 operator-() const { return Vector3{ _mm_sub_ps(_mm_setzero_ps(), Load()) }; }
+#else
+		Vector3 operator*(float scale) const { return { x * scale, y * scale, z * scale }; }
+		Vector3 operator/(float scale) const { return { x / scale, y / scale, z / scale }; }
+		Vector3 operator+(const Vector3& v) const { return { x + v.x, y + v.y, z + v.z }; }
+		Vector3 operator-(const Vector3& v) const { return { x - v.x, y - v.y, z - v.z }; }
+		Vector3 operator-() const { return { -x, -y, -z }; }
+#endif
 		//Vector3& operator-();
-		Vector3& operator+=(const Vector3& v);
-		Vector3& operator-=(const Vector3& v);
-		Vector3& operator/=(float scale);
-		Vector3& operator*=(float scale);
-		float& operator[](int index);
-		float operator[](int index) const;
+		Vector3& operator+=(const Vector3& v) { return *this = *this + v; }
+		Vector3& operator-=(const Vector3& v) { return *this = *this - v; }
+		Vector3& operator/=(float scale) { return *this = *this / scale; }
+		Vector3& operator*=(float scale) { return *this = *this * scale; }
+
+		float& operator[](int index)
+		{
+			assert(index <= 2 && index >= 0);
+
+			if (index == 0) return x;
+			if (index == 1) return y;
+			return z;
+		}
+
+		float operator[](int index) const
+		{
+			assert(index <= 2 && index >= 0);
+
+			if (index == 0) return x;
+			if (index == 1) return y;
+			return z;
+		}
 
 		static const Vector3 UnitX;
 		static const Vector3 UnitY;
@@ -50,9 +204,14 @@ namespace dae
 		static const Vector3 Zero;
 	};
 
+	inline const Vector3 Vector3::UnitX{ 1, 0, 0 };
+	inline const Vector3 Vector3::UnitY{ 0, 1, 0 };
+	inline const Vector3 Vector3::UnitZ{ 0, 0, 1 };
+	inline const Vector3 Vector3::Zero{ 0, 0, 0 };
+
 	//Global Operators
 	inline Vector3 operator*(float scale, const Vector3& v)
 	{
-		return { v.x * scale, v.y * scale, v.z * scale };
+		return v * scale;
 	}
 }
@@ -1,30 +1,419 @@
 //External includes
+#if defined(_MSC_VER)
 #include "vld.h"
+#endif
+#if !defined(HEADLESS)
 #include "SDL.h"
 #include "SDL_surface.h"
 #undef main
+#endif
 
 //Standard includes
+#include <charconv>
+#include <cmath>
+#include <csignal>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
 #include <iostream>
+#include <optional>
+#include <string>
 
 //Project includes
 #include "Timer.h"
 #include "Renderer.h"
 #include "Scene.h"
+#include "Profiler.h"
+#include "Benchmark.h"
+#include "CpuFeatures.h"
+#include "DistributedRenderer.h"
+#include "FramePipeline.h"
+#include "ImageSink.h"
+#include "OfflineRenderer.h"
+#include "ProgressiveRenderer.h"
+#include "SequenceRenderer.h"
 
 using namespace dae;
 
+#if !defined(HEADLESS)
 void ShutDown(SDL_Window* pWindow)
 {
 	SDL_DestroyWindow(pWindow);
 	SDL_Quit();
 }
+#endif
+
+//Parses all of pText into value. Prints what's wrong and returns false otherwise, std::stoi and friends would throw instead
+template<typename T>
+bool ParseNumber(const std::string& option, const char* pText, T& value)
+{
+	const char* const pEnd{ pText + std::strlen(pText) };
+	const auto [pParsed, error]{ std::from_chars(pText, pEnd, value) };
+	if (error == std::errc{} && pParsed == pEnd)
+		return true;
+
+	std::cout << "Invalid value for " << option << ": " << pText << std::endl;
+	return false;
+}
+
+//Prints what's wrong and returns false when value is outside [min, max], for options whose syntax alone doesn't make them usable
+template<typename T>
+bool CheckRange(const std::string& option, T value, T min, T max)
+{
+	if (min <= value && value <= max)
+		return true;
+
+	std::cout << option << " must be between " << min << " and " << max << ": " << value << std::endl;
+	return false;
+}
+
+//Largest width or height an image may have, the tile math and pixel indices stay well inside their types
+constexpr int MAX_IMAGE_SIZE{ 1 << 15 };
+//Local worker processes, and remote workers to wait for
+constexpr uint32_t MAX_WORKERS{ 256 };
+
+//Picks the algorithm whose ToString is pText. Prints what's wrong and returns false otherwise
+template<typename Algorithm>
+bool ParseAlgorithm(const std::string& option, const char* pText, std::initializer_list<Algorithm> algorithms, std::optional<Algorithm>& algorithm)
+{
+	for (const Algorithm candidate : algorithms)
+	{
+		if (std::strcmp(pText, ToString(candidate)) == 0)
+		{
+			algorithm = candidate;
+			return true;
+		}
+	}
+
+	std::cout << "Invalid value for " << option << ": " << pText << std::endl;
+	return false;
+}
+
+//Headless benchmark
+constexpr const char* BENCHMARK_USAGE{ "--benchmark [--out file.json] [--scene name]... [--frames n] [--warmup n] [--width w] [--height h]" };
+
+int RunBenchmark(int argc, char* args[])
+{
+	BenchmarkSettings settings{};
+	std::string outputFile{ "benchmark.json" };
+	bool isValid{ true };
+
+	for (int argIdx{ 1 }; argIdx < argc; ++argIdx)
+	{
+		const std::string arg{ args[argIdx] };
+		const bool hasValue{ argIdx + 1 < argc };
+
+		if (arg == "--out" && hasValue)
+			outputFile = args[++argIdx];
+		else if (arg == "--scene" && hasValue)
+			settings.sceneNames.push_back(args[++argIdx]);
+		else if (arg == "--frames" && hasValue)
+			isValid &= ParseNumber(arg, args[++argIdx], settings.measuredFrames);
+		else if (arg == "--warmup" && hasValue)
+			isValid &= ParseNumber(arg, args[++argIdx], settings.warmupFrames);
+		else if (arg == "--width" && hasValue)
+			isValid &= ParseNumber(arg, args[++argIdx], settings.width);
+		else if (arg == "--height" && hasValue)
+			isValid &= ParseNumber(arg, args[++argIdx], settings.height);
+	}
+
+	if (isValid)
+	{
+		isValid &= CheckRange("--width", settings.width, 1, MAX_IMAGE_SIZE);
+		isValid &= CheckRange("--height", settings.height, 1, MAX_IMAGE_SIZE);
+	}
+
+	if (!isValid)
+	{
+		std::cout << "Usage: " << BENCHMARK_USAGE << std::endl;
+		return 1;
+	}
+
+#if !defined(HEADLESS)
+	SDL_Init(0);
+#endif
+
+	Benchmark benchmark{ settings };
+	const bool succeeded{ benchmark.Run() && benchmark.WriteJson(outputFile) };
+
+	if (succeeded)
+		std::cout << "Benchmark results saved to " << outputFile << std::endl;
+	else
+		std::cout << "Something went wrong. Benchmark results not saved!" << std::endl;
+
+#if !defined(HEADLESS)
+	SDL_Quit();
+#endif
+	return succeeded ? 0 : 1;
+}
+
+//Offline still, spread over worker processes, progressive with checkpoints, or an animation instead of a still
+constexpr const char* OFFLINE_RENDER_USAGE{
+	"--render file.(exr|pfm) [--scene name] [--width w] [--height h] [--tile n] [--exr-tiled] [--no-shadows]\n"
+	"  [--workers n] [--remote-workers n --port p]\n"
+	"  [--spp n] [--checkpoint file] [--checkpoint-interval seconds] [--path-trace] [--sampler sobol|blue-noise|pcg] [--denoise]\n"
+	"  [--sphere Analytic|Geometric] [--triangle Naive|MollerTrumbore] (pins what the timing based calibration would pick)\n"
+	"--sequence frame_####.exr [--first a] [--last b] [--fps f] [--schedule auto|frames|tiles] (and the options of --render)" };
+
+int RunOfflineRender(int argc, char* args[])
+{
+	OfflineRenderSettings settings{};
+	DistributedRenderSettings distributedSettings{};
+	distributedSettings.numLocalWorkers = 0;
+	ProgressiveRenderSettings progressiveSettings{};
+	progressiveSettings.samplesPerPixel = 1;
+	SequenceRenderSettings sequenceSettings{};
+	sequenceSettings.outputPattern.clear();
+	std::string outputFile{};
+	std::string sceneName{ "Scene_W4_ReferenceScene" };
+	ExrLayout exrLayout{ ExrLayout::Scanline };
+	std::optional<SphereAlgorithm> sphereAlgorithm{};
+	std::optional<TriangleAlgorithm> triangleAlgorithm{};
+	bool isValid{ true };
+
+	for (int argIdx{ 1 }; argIdx < argc; ++argIdx)
+	{
+		const std::string arg{ args[argIdx] };
+		const bool hasValue{ argIdx + 1 < argc };
+
+		if (arg == "--render" && hasValue)
+			outputFile = args[++argIdx];
+		else if (arg == "--scene" && hasValue)
+			sceneName = args[++argIdx];
+		else if (arg == "--width" && hasValue)
+			isValid &= ParseNumber(arg, args[++argIdx], settings.width);
+		else if (arg == "--height" && hasValue)
+			isValid &= ParseNumber(arg, args[++argIdx], settings.height);
+		else if (arg == "--tile" && hasValue)
+			isValid &= ParseNumber(arg, args[++argIdx], settings.tileSize);
+		else if (arg == "--exr-tiled")
+			exrLayout = ExrLayout::Tiled;
+		else if (arg == "--no-shadows")
+			settings.shadowsEnabled = false;
+		else if (arg == "--workers" && hasValue)
+			isValid &= ParseNumber(arg, args[++argIdx], distributedSettings.numLocalWorkers);
+		else if (arg == "--remote-workers" && hasValue)
+			isValid &= ParseNumber(arg, args[++argIdx], distributedSettings.numRemoteWorkers);
+		else if (arg == "--port" && hasValue)
+			isValid &= ParseNumber(arg, args[++argIdx], distributedSettings.port);
+		else if (arg == "--spp" && hasValue)
+			isValid &= ParseNumber(arg, args[++argIdx], progressiveSettings.samplesPerPixel);
+		else if (arg == "--checkpoint" && hasValue)
+			progressiveSettings.checkpointFile = args[++argIdx];
+		else if (arg == "--checkpoint-interval" && hasValue)
+			isValid &= ParseNumber(arg, args[++argIdx], progressiveSettings.checkpointInterval);
+		else if (arg == "--path-trace")
+			progressiveSettings.pathTracingEnabled = true;
+		else if (arg == "--denoise")
+			progressiveSettings.denoiseEnabled = true;
+		else if (arg == "--sampler" && hasValue)
+		{
+			const std::string sampler{ args[++argIdx] };
+			progressiveSettings.samplerType = sampler == "blue-noise" ? SamplerType::BlueNoise
+				: sampler == "pcg" ? SamplerType::Pcg : SamplerType::Sobol;
+		}
+		else if (arg == "--sequence" && hasValue)
+			sequenceSettings.outputPattern = args[++argIdx];
+		else if (arg == "--first" && hasValue)
+			isValid &= ParseNumber(arg, args[++argIdx], sequenceSettings.firstFrame);
+		else if (arg == "--last" && hasValue)
+			isValid &= ParseNumber(arg, args[++argIdx], sequenceSettings.lastFrame);
+		else if (arg == "--fps" && hasValue)
+			isValid &= ParseNumber(arg, args[++argIdx], sequenceSettings.framesPerSecond);
+		else if (arg == "--sphere" && hasValue)
+			isValid &= ParseAlgorithm(arg, args[++argIdx], { SphereAlgorithm::Analytic, SphereAlgorithm::Geometric }, sphereAlgorithm);
+		else if (arg == "--triangle" && hasValue)
+			isValid &= ParseAlgorithm(arg, args[++argIdx], { TriangleAlgorithm::Naive, TriangleAlgorithm::MollerTrumbore }, triangleAlgorithm);
+		else if (arg == "--schedule" && hasValue)
+		{
+			const std::string schedule{ args[++argIdx] };
+			sequenceSettings.schedule = schedule == "frames" ? SequenceSchedule::FrameParallel
+				: schedule == "tiles" ? SequenceSchedule::WithinFrame : SequenceSchedule::Auto;
+		}
+	}
+
+	//Zero sized images and tiles divide by zero or write nothing, remote workers can't find a coordinator on a random port
+	if (isValid)
+	{
+		isValid &= CheckRange("--width", settings.width, 1, MAX_IMAGE_SIZE);
+		isValid &= CheckRange("--height", settings.height, 1, MAX_IMAGE_SIZE);
+		isValid &= CheckRange("--tile", settings.tileSize, 1, MAX_IMAGE_SIZE);
+		isValid &= CheckRange("--spp", progressiveSettings.samplesPerPixel, 1u, UINT32_MAX);
+		isValid &= CheckRange("--workers", distributedSettings.numLocalWorkers, 0u, MAX_WORKERS);
+		isValid &= CheckRange("--remote-workers", distributedSettings.numRemoteWorkers, 0u, MAX_WORKERS);
+		if (distributedSettings.numRemoteWorkers > 0)
+			isValid &= CheckRange("--port", uint32_t(distributedSettings.port), 1u, uint32_t(UINT16_MAX));
+
+		if (!sequenceSettings.outputPattern.empty())
+		{
+			isValid &= CheckRange("--first", sequenceSettings.firstFrame, 0, INT32_MAX - 1);
+			isValid &= CheckRange("--last", sequenceSettings.lastFrame, sequenceSettings.firstFrame, INT32_MAX - 1);
+			if (!(sequenceSettings.framesPerSecond > 0) || !std::isfinite(sequenceSettings.framesPerSecond))
+			{
+				std::cout << "--fps must be above 0: " << sequenceSettings.framesPerSecond << std::endl;
+				isValid = false;
+			}
+		}
+	}
+
+	if (!isValid)
+	{
+		std::cout << "Usage:\n" << OFFLINE_RENDER_USAGE << std::endl;
+		return 1;
+	}
+
+	const bool isSequence{ !sequenceSettings.outputPattern.empty() };
+	const std::unique_ptr<ImageSink> pSink{ isSequence ? nullptr : CreateImageSink(outputFile, exrLayout, settings.tileSize) };
+	if (!isSequence && !pSink)
+	{
+		std::cout << "Unsupported output file: " << outputFile << " (use .exr or .pfm)" << std::endl;
+		return 1;
+	}
+
+	const std::unique_ptr<Scene> pScene{ CreateScene(sceneName) };
+	if (!pScene)
+	{
+		std::cout << "Unknown scene: " << sceneName << std::endl;
+		return 1;
+	}
+
+	pScene->Initialize();
+
+	//The algorithms differ in their last bits, and calibration picks by timing: pinned, every run traces the same pixels
+	if (!sphereAlgorithm || !triangleAlgorithm)
+		pScene->CalibrateIntersectionAlgorithms();
+	pScene->SetIntersectionAlgorithms(sphereAlgorithm.value_or(pScene->GetSphereAlgorithm()), triangleAlgorithm.value_or(pScene->GetTriangleAlgorithm()));
+
+	std::cout << "Intersection algorithms: sphere " << ToString(pScene->GetSphereAlgorithm())
+		<< ", triangle " << ToString(pScene->GetTriangleAlgorithm()) << std::endl;
+	if (!sphereAlgorithm || !triangleAlgorithm)
+		std::cout << "Calibrated, another run may pick differently. Add --sphere " << ToString(pScene->GetSphereAlgorithm())
+			<< " --triangle " << ToString(pScene->GetTriangleAlgorithm()) << " to render the same pixels every run" << std::endl;
+
+	const bool isDistributed{ distributedSettings.numLocalWorkers + distributedSettings.numRemoteWorkers > 0 };
+	distributedSettings.tileSize = settings.tileSize;
+	distributedSettings.shadowsEnabled = settings.shadowsEnabled;
+
+	if (isSequence)
+	{
+		sequenceSettings.width = settings.width;
+		sequenceSettings.height = settings.height;
+		sequenceSettings.tileSize = settings.tileSize;
+		sequenceSettings.shadowsEnabled = settings.shadowsEnabled;
+		sequenceSettings.exrLayout = exrLayout;
+
+		std::cout << "Rendering frames " << sequenceSettings.firstFrame << " to " << sequenceSettings.lastFrame << " of " << sceneName
+			<< " at " << settings.width << "x" << settings.height << " to " << sequenceSettings.outputPattern << std::endl;
+
+		SequenceRenderer renderer{ sequenceSettings };
+		const uint64_t startNs{ Profiler::Now() };
+		bool succeeded{};
+		if (isDistributed)
+		{
+			DistributedRenderer distributedRenderer{ distributedSettings };
+			succeeded = distributedRenderer.Start(sceneName, pScene->GetSphereAlgorithm(), pScene->GetTriangleAlgorithm())
+				&& renderer.Render(distributedRenderer);
+		}
+		else
+		{
+			succeeded = renderer.Render(sceneName, pScene->GetSphereAlgorithm(), pScene->GetTriangleAlgorithm());
+		}
+		const double seconds{ double(Profiler::Now() - startNs) / 1'000'000'000.0 };
+
+		if (succeeded)
+			std::cout << "Sequence rendered in " << seconds << "s" << std::endl;
+		else
+			std::cout << "Something went wrong. Sequence not finished!" << std::endl;
+
+		return succeeded ? 0 : 1;
+	}
+
+	std::cout << "Rendering " << sceneName << " at " << settings.width << "x" << settings.height << " to " << outputFile << std::endl;
+
+	if (isDistributed)
+	{
+		//Workers use the algorithms calibrated here, so every chunk is traced the same way
+		DistributedRenderer renderer{ distributedSettings };
+		const uint64_t startNs{ Profiler::Now() };
+		const bool succeeded{ renderer.Start(sceneName, pScene->GetSphereAlgorithm(), pScene->GetTriangleAlgorithm())
+			&& renderer.RenderFrame(settings.width, settings.height, *pSink) };
+		const double seconds{ double(Profiler::Now() - startNs) / 1'000'000'000.0 };
+
+		if (succeeded)
+			std::cout << "Render saved to " << outputFile << " in " << seconds << "s" << std::endl;
+		else
+			std::cout << "Something went wrong. Render not saved!" << std::endl;
+
+		return succeeded ? 0 : 1;
+	}
+
+	//Path tracing needs many samples per pixel, it's only done progressively. So is denoising, it needs the whole image at once
+	if (progressiveSettings.samplesPerPixel > 1 || !progressiveSettings.checkpointFile.empty() || progressiveSettings.pathTracingEnabled
+		|| progressiveSettings.denoiseEnabled)
+	{
+		progressiveSettings.width = settings.width;
+		progressiveSettings.height = settings.height;
+		progressiveSettings.tileSize = settings.tileSize;
+		progressiveSettings.shadowsEnabled = settings.shadowsEnabled;
+
+		//Preempted batch jobs get a SIGTERM first: finish the pass, save a checkpoint and quit
+		std::signal(SIGTERM, [](int) { ProgressiveRenderer::RequestStop(); });
+		std::signal(SIGINT, [](int) { ProgressiveRenderer::RequestStop(); });
+
+		ProgressiveRenderer renderer{ progressiveSettings };
+		const uint64_t startNs{ Profiler::Now() };
+		const bool succeeded{ renderer.Render(pScene.get(), sceneName, *pSink) };
+		const double seconds{ double(Profiler::Now() - startNs) / 1'000'000'000.0 };
+
+		if (succeeded)
+			std::cout << "Render saved to " << outputFile << " in " << seconds << "s" << std::endl;
+		else
+			std::cout << "Render not finished, nothing saved to " << outputFile << std::endl;
+
+		return succeeded ? 0 : 1;
+	}
+
+	OfflineRenderer renderer{ settings };
+	const uint64_t startNs{ Profiler::Now() };
+	const bool succeeded{ renderer.Render(pScene.get(), *pSink) };
+	const double seconds{ double(Profiler::Now() - startNs) / 1'000'000'000.0 };
+
+	if (succeeded)
+		std::cout << "Render saved to " << outputFile << " in " << seconds << "s ("
+			<< double(renderer.GetStats().GetTotalRays()) / seconds / 1'000'000.0 << " Mrays/s)" << std::endl;
+	else
+		std::cout << "Something went wrong. Render not saved!" << std::endl;
+
+	return succeeded ? 0 : 1;
+}
 
 int main(int argc, char* args[])
 {
-	//Unreferenced parameters
-	(void)argc;
-	(void)args;
+	//Render worker of a distributed render: --worker <coordinator host>:<port>
+	for (int argIdx{ 1 }; argIdx + 1 < argc; ++argIdx)
+	{
+		if (std::string(args[argIdx]) == "--worker")
+			return RunRenderWorker(args[argIdx + 1]);
+	}
+
+	std::cout << "Hot kernels running with: " << GetKernelIsaName() << std::endl;
+
+	for (int argIdx{ 1 }; argIdx < argc; ++argIdx)
+	{
+		const std::string arg{ args[argIdx] };
+		if (arg == "--render" || arg == "--sequence")
+			return RunOfflineRender(argc, args);
+	}
+
+#if defined(HEADLESS)
+	//No window to show anything in, a headless build only runs offline renders and the benchmark
+	return RunBenchmark(argc, args);
+#else
+	for (int argIdx{ 1 }; argIdx < argc; ++argIdx)
+	{
+		if (std::string(args[argIdx]) == "--benchmark")
+			return RunBenchmark(argc, args);
+	}
 
 	//Create window + surfaces
 	SDL_Init(SDL_INIT_VIDEO);
@@ -44,16 +433,30 @@ int main(int argc, char* args[])
 	//Initialize "framework"
 	const auto pTimer = new Timer();
 	const auto pRenderer = new Renderer(pWindow);
+	const auto pPipeline = new FramePipeline(pRenderer);
 
-	//const auto pScene = new Scene_W4_BunnyScene();
-	const auto pScene = new Scene_W4_ReferenceScene();
-	pScene->Initialize();
+	//One scene copy is traced while the next frame is updated in the other one
+	Scene* pScenes[FramePipeline::NUM_SCENES]{};
+	for (Scene*& pScene : pScenes)
+	{
+		//pScene = new Scene_W4_BunnyScene();
+		pScene = new Scene_W4_ReferenceScene();
+		pScene->Initialize();
+	}
+
+	pScenes[0]->CalibrateIntersectionAlgorithms();
+	for (Scene* pScene : pScenes)
+		pScene->SetIntersectionAlgorithms(pScenes[0]->GetSphereAlgorithm(), pScenes[0]->GetTriangleAlgorithm());
+	std::cout << "Intersection algorithms: sphere " << ToString(pScenes[0]->GetSphereAlgorithm())
+		<< ", triangle " << ToString(pScenes[0]->GetTriangleAlgorithm()) << std::endl;
 
 	//Start loop
 	pTimer->Start();
 	float printTimer = 0.f;
+	RayStats printStats{};
 	bool isLooping = true;
 	bool takeScreenshot = false;
+	uint32_t frameIndex = 0;
 	while (isLooping)
 	{
 		//--------- Get input events ---------
@@ -91,28 +494,85 @@ int main(int argc, char* args[])
 					pTimer->StartBenchmark();
 				}
 
+				if (e.key.keysym.scancode == SDL_SCANCODE_F5) {
+					pRenderer->CycleHeatmapMetric();
+				}
+
+				if (e.key.keysym.scancode == SDL_SCANCODE_F8) {
+					pRenderer->GetToneMapper().CycleOperator();
+					std::cout << "Tone mapping: " << ToString(pRenderer->GetToneMapper().GetOperator()) << std::endl;
+				}
+
+				if (e.key.keysym.scancode == SDL_SCANCODE_F9) {
+					pRenderer->GetToneMapper().ToggleSRGB();
+					std::cout << "sRGB output: " << (pRenderer->GetToneMapper().IsSRGBEnabled() ? "on" : "off") << std::endl;
+				}
+
+				if (e.key.keysym.scancode == SDL_SCANCODE_F11) {
+					std::cout << "Denoiser: " << (pRenderer->ToggleDenoiser() ? "on" : "off") << std::endl;
+				}
+
+				if (e.key.keysym.scancode == SDL_SCANCODE_F12) {
+					std::cout << "Temporal reuse: " << (pRenderer->ToggleTemporalReuse() ? "on" : "off") << std::endl;
+				}
+
+				if (e.key.keysym.scancode == SDL_SCANCODE_F10) {
+					pPipeline->Flush();
+					if (pRenderer->SaveHdrImage("RayTracing_Buffer.exr"))
+						std::cout << "HDR image saved!" << std::endl;
+					else
+						std::cout << "Something went wrong. HDR image not saved!" << std::endl;
+				}
+
+				if (e.key.keysym.scancode == SDL_SCANCODE_F7) {
+					pPipeline->Flush();
+					if (Profiler::Get().WriteChromeTrace("profile_trace.json"))
+						std::cout << "Profile trace saved!" << std::endl;
+					else
+						std::cout << "Something went wrong. Profile trace not saved!" << std::endl;
+				}
+
 				break;
 			}
 		}
 
 		//--------- Update ---------
-		pScene->Update(pTimer);
+		//Runs while the previous frame is still being traced from the other scene copy
+		Scene* const pScene = pScenes[frameIndex % FramePipeline::NUM_SCENES];
+		{
+			PROFILE_SCOPE("Scene::Update");
+			const Scene* const pPreviousScene = pScenes[(frameIndex + FramePipeline::NUM_SCENES - 1) % FramePipeline::NUM_SCENES];
+			pScene->GetCamera().CopyState(pPreviousScene->GetCamera());
+			pScene->Update(pTimer);
+		}
 
 		//--------- Render ---------
-		pRenderer->Render(pScene);
+		//Returns once the previous frame is traced, it's tone mapped on the pipeline's present thread and shown here
+		pPipeline->SubmitFrame(pScene);
+		++frameIndex;
 
 		//--------- Timer ---------
 		pTimer->Update();
 		printTimer += pTimer->GetElapsed();
+		printStats += pPipeline->GetFrameStats();
 		if (printTimer >= 1.f)
 		{
+			const double totalRays{ double(printStats.GetTotalRays()) };
+			std::cout << "dFPS: " << pTimer->GetdFPS()
+				<< " | Mrays/s: " << totalRays / printTimer / 1'000'000.0
+				<< " (primary " << printStats.primaryRays << ", shadow " << printStats.shadowRays << ", secondary " << printStats.secondaryRays << ")"
+				<< " | tests/ray: " << (totalRays > 0 ? printStats.GetTotalPrimitiveTests() / totalRays : 0.0)
+				<< " | slab pass/fail: " << printStats.slabTestsPassed << "/" << printStats.slabTestsFailed
+				<< std::endl;
+
 			printTimer = 0.f;
-			std::cout << "dFPS: " << pTimer->GetdFPS() << std::endl;
+			printStats = {};
 		}
 
 		//Save screenshot after full render
 		if (takeScreenshot)
 		{
+			pPipeline->Flush();
 			if (!pRenderer->SaveBufferToImage())
 				std::cout << "Screenshot saved!" << std::endl;
 			else
@@ -123,10 +583,13 @@ int main(int argc, char* args[])
 	pTimer->Stop();
 
 	//Shutdown "framework"
-	delete pScene;
+	delete pPipeline;
+	for (Scene* pScene : pScenes)
+		delete pScene;
 	delete pRenderer;
 	delete pTimer;
 
 	ShutDown(pWindow);
 	return 0;
-}
\ No newline at end of file
+#endif
+}